@@ -0,0 +1,429 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decompressors/HuffmanTableLUT.h"    // for HuffmanTableLUT
+#include "decompressors/HuffmanTableLookup.h" // for HuffmanTableLookup
+#include "decompressors/HuffmanTableTree.h"   // for HuffmanTableTree
+#include "decompressors/HuffmanTableVector.h" // for HuffmanTableVector
+#include "io/BitPumpJPEG.h"                   // for BitPumpJPEG
+#include "io/BitPumpMSB.h"                    // for BitPumpMSB
+#include "io/BitPumpMSB32.h"                  // for BitPumpMSB32
+#include "io/Buffer.h"                        // for Buffer, DataBuffer
+#include "io/ByteStream.h"                    // for ByteStream
+#include "io/Endianness.h"                    // for Endianness, Endianness...
+#include <algorithm>                          // for max, min
+#include <array>                              // for array
+#include <benchmark/benchmark.h>              // for State, Benchmark, Init...
+#include <cassert>                            // for assert
+#include <cmath>                              // for exp, ldexp
+#include <cstddef>                            // for size_t
+#include <cstdint>                            // for uint8_t, uint32_t, uin...
+#include <random>                             // for minstd_rand, discrete_...
+#include <string>                             // for string
+#include <utility>                            // for pair, swap, move
+#include <vector>                             // for vector
+
+using rawspeed::BitPumpJPEG;
+using rawspeed::BitPumpMSB;
+using rawspeed::BitPumpMSB32;
+using rawspeed::Buffer;
+using rawspeed::ByteStream;
+using rawspeed::DataBuffer;
+using rawspeed::Endianness;
+using rawspeed::HuffmanTableLookup;
+using rawspeed::HuffmanTableLUT;
+using rawspeed::HuffmanTableTree;
+using rawspeed::HuffmanTableVector;
+
+namespace {
+
+struct DHT {
+  std::string name;
+  std::array<uint8_t, 16> nCodesPerLength;
+  std::vector<uint8_t> codeValues;
+  // The probability of each code value (diff length), in the same order.
+  std::vector<double> frequencies;
+};
+
+struct FixedDHT {
+  const char* name;
+  std::array<uint8_t, 16> nCodesPerLength;
+  std::array<uint8_t, 16> codeValues;
+};
+
+// The tables that are hardcoded in the decoders, see NikonDecompressor and
+// PentaxDecompressor. These were designed for a code of length l to be seen
+// with the frequency of 2^-l, so that is what is generated for them.
+const std::array<FixedDHT, 5> FixedTables = {{
+    {"NEF<Lossy12>",
+     {0, 1, 5, 1, 1, 1, 1, 1, 1, 2, 0, 0, 0, 0, 0, 0},
+     {5, 4, 3, 6, 2, 7, 1, 0, 8, 9, 11, 10, 12}},
+    {"NEF<Lossless12>",
+     {0, 1, 4, 2, 3, 1, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+     {5, 4, 6, 3, 7, 2, 8, 1, 9, 0, 10, 11, 12}},
+    {"NEF<Lossy14>",
+     {0, 1, 4, 3, 1, 1, 1, 1, 1, 2, 0, 0, 0, 0, 0, 0},
+     {5, 6, 4, 7, 8, 3, 9, 2, 1, 0, 10, 11, 12, 13, 14}},
+    {"NEF<Lossless14>",
+     {0, 1, 4, 2, 2, 3, 1, 2, 0, 0, 0, 0, 0, 0, 0, 0},
+     {7, 6, 8, 5, 9, 4, 10, 3, 11, 12, 2, 0, 1, 13, 14}},
+    {"PEF",
+     {0, 2, 3, 1, 1, 1, 1, 1, 1, 2, 0, 0, 0, 0, 0, 0},
+     {3, 4, 2, 5, 1, 6, 0, 7, 8, 9, 10, 11, 12}},
+}};
+
+// CR2, DNG and 3FR store their DHT in the file, and it is optimized by the
+// encoder for the image (the DNG SDK does exactly that). So here the tables
+// are built the same way, from the histogram of the prediction differences
+// of an image, which are modelled as a Laplace distribution.
+struct Histogram {
+  const char* name;
+  int bits;     // of the image
+  double scale; // of the Laplace distribution of the differences
+};
+
+const std::array<Histogram, 5> Histograms = {{
+    {"CR2<12bit, ISO100>", 12, 3},
+    {"CR2<14bit, ISO6400>", 14, 96},
+    {"DNG<12bit, ISO100>", 12, 6},
+    {"DNG<16bit, ISO1600>", 16, 480},
+    {"3FR<16bit, ISO100>", 16, 40},
+}};
+
+// The probability of each diff length (SSSS), 0..bits.
+std::vector<double> getDiffLengthFrequencies(const Histogram& h) {
+  // P(|diff| >= x) = exp(-x / scale), with the rounding to integers.
+  const auto tail = [&h](double x) { return std::exp(-x / h.scale); };
+
+  std::vector<double> freq(h.bits + 1);
+  freq[0] = 1.0 - tail(0.5);
+  for (int len = 1; len <= h.bits; ++len) {
+    freq[len] =
+        tail(std::ldexp(1, len - 1) - 0.5) - tail(std::ldexp(1, len) - 0.5);
+  }
+  return freq;
+}
+
+// ITU T.81, Annex K.2: the code lengths for these frequencies, limited to 16.
+DHT buildOptimalDHT(const Histogram& h) {
+  const std::vector<double> prob = getDiffLengthFrequencies(h);
+  const int nSymbols = prob.size();
+
+  // Integer frequencies; each possible diff length does get a code.
+  std::vector<uint64_t> freq(nSymbols + 1);
+  for (int i = 0; i < nSymbols; ++i)
+    freq[i] = std::max<uint64_t>(1, prob[i] * (uint64_t(1) << 32));
+  // Figure K.1 reserves one code point, so no code is all ones.
+  freq[nSymbols] = 1;
+
+  // Figure K.1: the code size of each symbol.
+  std::vector<int> codesize(nSymbols + 1, 0);
+  std::vector<int> others(nSymbols + 1, -1);
+  while (true) {
+    int v1 = -1;
+    int v2 = -1;
+    for (int i = 0; i <= nSymbols; ++i) {
+      if (freq[i] == 0)
+        continue;
+      if (v1 < 0 || freq[i] <= freq[v1]) {
+        v2 = v1;
+        v1 = i;
+      } else if (v2 < 0 || freq[i] <= freq[v2])
+        v2 = i;
+    }
+    if (v2 < 0)
+      break;
+
+    freq[v1] += freq[v2];
+    freq[v2] = 0;
+
+    for (codesize[v1]++; others[v1] >= 0; codesize[v1]++)
+      v1 = others[v1];
+    others[v1] = v2;
+    for (codesize[v2]++; others[v2] >= 0; codesize[v2]++)
+      v2 = others[v2];
+  }
+
+  // Figure K.2: the number of codes of each size.
+  std::array<int, 33> bits = {};
+  for (int i = 0; i <= nSymbols; ++i) {
+    if (codesize[i])
+      bits[codesize[i]]++;
+  }
+
+  // Figure K.3: limit the code lengths to 16 bits.
+  for (int i = 32; i > 16; --i) {
+    while (bits[i] > 0) {
+      int j = i - 2;
+      while (bits[j] == 0)
+        j--;
+      bits[i] -= 2;
+      bits[i - 1]++;
+      bits[j + 1] += 2;
+      bits[j]--;
+    }
+  }
+  // And drop the reserved code point.
+  int i = 16;
+  while (bits[i] == 0)
+    i--;
+  bits[i]--;
+
+  DHT dht;
+  dht.name = h.name;
+  for (int len = 1; len <= 16; ++len)
+    dht.nCodesPerLength[len - 1] = bits[len];
+
+  // Figure K.4: the symbols, sorted by the code size.
+  for (int len = 1; len <= 32; ++len) {
+    for (int s = 0; s < nSymbols; ++s) {
+      if (codesize[s] == len) {
+        dht.codeValues.emplace_back(s);
+        dht.frequencies.emplace_back(prob[s]);
+      }
+    }
+  }
+  assert(dht.codeValues.size() == static_cast<size_t>(nSymbols));
+
+  return dht;
+}
+
+DHT getFixedDHT(const FixedDHT& t) {
+  DHT dht;
+  dht.name = t.name;
+  dht.nCodesPerLength = t.nCodesPerLength;
+  int count = 0;
+  for (int len = 1; len <= 16; ++len) {
+    for (int i = 0; i < t.nCodesPerLength[len - 1]; ++i) {
+      dht.codeValues.emplace_back(t.codeValues[count++]);
+      dht.frequencies.emplace_back(std::ldexp(1, -len));
+    }
+  }
+  return dht;
+}
+
+// Writes the bits MSB-first, as the given BitPump wants to read them.
+class BitWriter final {
+  std::vector<uint8_t> bytes;
+  uint64_t cache = 0;
+  int fillLevel = 0;
+  bool stuffFF;
+
+public:
+  explicit BitWriter(bool stuffFF_) : stuffFF(stuffFF_) {}
+
+  void put(uint32_t bits, int count) {
+    assert(count <= 32);
+    cache = (cache << count) | (bits & ((uint64_t(1) << count) - 1));
+    fillLevel += count;
+    while (fillLevel >= 8) {
+      fillLevel -= 8;
+      const uint8_t byte = cache >> fillLevel;
+      bytes.emplace_back(byte);
+      // BitPumpJPEG expects the 0xFF bytes to be followed by a zero byte.
+      if (stuffFF && byte == 0xFF)
+        bytes.emplace_back(0x00);
+    }
+  }
+
+  std::vector<uint8_t> finish() {
+    if (fillLevel > 0)
+      put(0, 8 - fillLevel);
+    // Some padding, so that the pumps never run out of input.
+    bytes.resize(bytes.size() + 64);
+    return std::move(bytes);
+  }
+};
+
+enum class PumpKind { JPEG, MSB, MSB32 };
+
+template <typename Pump> struct PumpTraits;
+template <> struct PumpTraits<BitPumpJPEG> final {
+  static constexpr PumpKind kind = PumpKind::JPEG;
+  static constexpr const char* name = "BitPumpJPEG";
+};
+template <> struct PumpTraits<BitPumpMSB> final {
+  static constexpr PumpKind kind = PumpKind::MSB;
+  static constexpr const char* name = "BitPumpMSB";
+};
+template <> struct PumpTraits<BitPumpMSB32> final {
+  static constexpr PumpKind kind = PumpKind::MSB32;
+  static constexpr const char* name = "BitPumpMSB32";
+};
+
+struct Stream {
+  std::vector<uint8_t> data;
+  size_t symbols;
+  uint64_t bits; // code and diff bits, excluding the JPEG byte stuffing
+};
+
+constexpr size_t NumSymbols = 1 << 20;
+
+// Random code values with the frequencies of the DHT, each followed by the
+// random bits of the difference.
+Stream generateStream(const DHT& dht, PumpKind kind) {
+  // The canonical codes, ITU T.81 Figure C.2.
+  std::vector<std::pair<uint32_t, int>> codes;
+  uint32_t code = 0;
+  for (int len = 1; len <= 16; ++len) {
+    for (int i = 0; i < dht.nCodesPerLength[len - 1]; ++i)
+      codes.emplace_back(code++, len);
+    code <<= 1;
+  }
+  assert(codes.size() == dht.codeValues.size());
+
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  std::discrete_distribution<size_t> symbol(dht.frequencies.begin(),
+                                            dht.frequencies.end());
+  std::uniform_int_distribution<uint32_t> diffBits(0, 0xFFFF);
+
+  Stream s;
+  s.symbols = NumSymbols;
+  s.bits = 0;
+
+  BitWriter writer(/*stuffFF=*/kind == PumpKind::JPEG);
+  for (size_t i = 0; i < s.symbols; ++i) {
+    const size_t sym = symbol(rng);
+    writer.put(codes[sym].first, codes[sym].second);
+    s.bits += codes[sym].second;
+
+    // A diff length of 16 is not followed by any bits.
+    const int len = dht.codeValues[sym];
+    if (len != 0 && len != 16) {
+      writer.put(diffBits(rng), len);
+      s.bits += len;
+    }
+  }
+  s.data = writer.finish();
+
+  // BitPumpMSB32 reads little-endian 32-bit words, MSB-first.
+  if (kind == PumpKind::MSB32) {
+    s.data.resize((s.data.size() + 3) & ~size_t(3));
+    for (size_t i = 0; i < s.data.size(); i += 4) {
+      std::swap(s.data[i], s.data[i + 3]);
+      std::swap(s.data[i + 1], s.data[i + 2]);
+    }
+  }
+
+  return s;
+}
+
+template <typename HuffmanTableTy, typename Pump>
+void BM_HuffmanTable(benchmark::State& state, const DHT* dht,
+                     const Stream* stream, bool fullDecode) {
+  HuffmanTableTy ht;
+  const auto nCodes = ht.setNCodesPerLength(
+      Buffer(dht->nCodesPerLength.data(), dht->nCodesPerLength.size()));
+  ht.setCodeValues(Buffer(dht->codeValues.data(), nCodes));
+  ht.setup(fullDecode, /*fixDNGBug16_=*/false);
+
+  const ByteStream bs(DataBuffer(
+      Buffer(stream->data.data(), stream->data.size()), Endianness::unknown));
+
+  if (fullDecode) {
+    for (auto _ : state) {
+      Pump pump(bs);
+      for (size_t i = 0; i < stream->symbols; i++)
+        benchmark::DoNotOptimize(ht.decodeDifference(pump));
+    }
+  } else {
+    // The diff itself is then read separately, e.g. as in Hasselblad.
+    for (auto _ : state) {
+      Pump pump(bs);
+      for (size_t i = 0; i < stream->symbols; i++) {
+        const int len = ht.decodeCodeValue(pump);
+        if (len != 0 && len != 16)
+          benchmark::DoNotOptimize(pump.getBits(len));
+      }
+    }
+  }
+
+  state.counters.insert(
+      {{"Symbols",
+        benchmark::Counter(
+            stream->symbols,
+            benchmark::Counter::Flags::kIsIterationInvariantRate)},
+       {"Bits", benchmark::Counter(
+                    stream->bits,
+                    benchmark::Counter::Flags::kIsIterationInvariantRate)},
+       {"BitsPerSymbol", double(stream->bits) / stream->symbols}});
+}
+
+void CustomArguments(benchmark::internal::Benchmark* b) {
+  b->Unit(benchmark::kMillisecond);
+}
+
+template <typename HuffmanTableTy, typename Pump>
+void registerBenchmark(const char* tableName, const DHT& dht,
+                       const Stream& stream, bool fullDecode) {
+  std::string name("BM_HuffmanTable<");
+  name += tableName;
+  name += ", ";
+  name += PumpTraits<Pump>::name;
+  name += ", ";
+  name += fullDecode ? "Full" : "LengthOnly";
+  name += ", ";
+  name += dht.name;
+  name += ">";
+  auto* b = benchmark::RegisterBenchmark(
+      name.c_str(), BM_HuffmanTable<HuffmanTableTy, Pump>, &dht, &stream,
+      fullDecode);
+  b->Apply(CustomArguments);
+}
+
+template <typename Pump>
+void registerBenchmarks(const DHT& dht, const Stream& stream) {
+  for (bool fullDecode : {true, false}) {
+    registerBenchmark<HuffmanTableLUT, Pump>("LUT", dht, stream, fullDecode);
+    registerBenchmark<HuffmanTableLookup, Pump>("Lookup", dht, stream,
+                                                fullDecode);
+    registerBenchmark<HuffmanTableTree, Pump>("Tree", dht, stream, fullDecode);
+    registerBenchmark<HuffmanTableVector, Pump>("Vector", dht, stream,
+                                                fullDecode);
+  }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  std::vector<DHT> tables;
+  for (const FixedDHT& t : FixedTables)
+    tables.emplace_back(getFixedDHT(t));
+  for (const Histogram& h : Histograms)
+    tables.emplace_back(buildOptimalDHT(h));
+
+  // The benchmarks only keep pointers, so these must not be reallocated.
+  std::vector<std::array<Stream, 3>> streams;
+  streams.reserve(tables.size());
+  for (const DHT& dht : tables) {
+    streams.push_back({{generateStream(dht, PumpKind::JPEG),
+                        generateStream(dht, PumpKind::MSB),
+                        generateStream(dht, PumpKind::MSB32)}});
+  }
+
+  for (size_t i = 0; i < tables.size(); ++i) {
+    registerBenchmarks<BitPumpJPEG>(tables[i], streams[i][0]);
+    registerBenchmarks<BitPumpMSB>(tables[i], streams[i][1]);
+    registerBenchmarks<BitPumpMSB32>(tables[i], streams[i][2]);
+  }
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+}
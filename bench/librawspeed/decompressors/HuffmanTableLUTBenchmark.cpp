@@ -0,0 +1,140 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decompressors/HuffmanTableLUT.h" // for HuffmanTableLUT
+#include "io/BitPumpMSB.h"                 // for BitPumpMSB
+#include "io/Buffer.h"                     // for Buffer, DataBuffer
+#include "io/ByteStream.h"                 // for ByteStream
+#include "io/Endianness.h"                 // for Endianness, Endianness::big
+#include <array>                           // for array
+#include <benchmark/benchmark.h>           // for State, Benchmark, Initialize
+#include <cassert>                         // for assert
+#include <cstddef>                         // for size_t
+#include <cstdint>                         // for uint8_t
+#include <random>                          // for minstd_rand, uniform_int_...
+#include <string>                          // for string, to_string
+
+using rawspeed::BitPumpMSB;
+using rawspeed::Buffer;
+using rawspeed::ByteStream;
+using rawspeed::DataBuffer;
+using rawspeed::Endianness;
+using rawspeed::HuffmanTableLUT;
+
+namespace {
+
+struct DHT {
+  const char* name;
+  std::array<uint8_t, 16> nCodesPerLength;
+  std::array<uint8_t, 16> codeValues;
+};
+
+// The real-world tables, see NikonDecompressor and PentaxDecompressor.
+// All of them are complete, so random input is a valid input,
+// and each code of length l is then seen with the frequency of 2^-l.
+const std::array<DHT, 5> Tables = {{
+    {"NikonLossy12",
+     {0, 1, 5, 1, 1, 1, 1, 1, 1, 2, 0, 0, 0, 0, 0, 0},
+     {5, 4, 3, 6, 2, 7, 1, 0, 8, 9, 11, 10, 12}},
+    {"NikonLossless12",
+     {0, 1, 4, 2, 3, 1, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+     {5, 4, 6, 3, 7, 2, 8, 1, 9, 0, 10, 11, 12}},
+    {"NikonLossy14",
+     {0, 1, 4, 3, 1, 1, 1, 1, 1, 2, 0, 0, 0, 0, 0, 0},
+     {5, 6, 4, 7, 8, 3, 9, 2, 1, 0, 10, 11, 12, 13, 14}},
+    {"NikonLossless14",
+     {0, 1, 4, 2, 2, 3, 1, 2, 0, 0, 0, 0, 0, 0, 0, 0},
+     {7, 6, 8, 5, 9, 4, 10, 3, 11, 12, 2, 0, 1, 13, 14}},
+    {"Pentax",
+     {0, 2, 3, 1, 1, 1, 1, 1, 1, 2, 0, 0, 0, 0, 0, 0},
+     {3, 4, 2, 5, 1, 6, 0, 7, 8, 9, 10, 11, 12}},
+}};
+
+constexpr unsigned AutoDepth = 0;
+
+void BM_HuffmanTableLUT(benchmark::State& state, const DHT* dht,
+                        unsigned depth) {
+  assert(state.range(0) > 0);
+
+  HuffmanTableLUT ht;
+  const auto nCodes = ht.setNCodesPerLength(
+      Buffer(dht->nCodesPerLength.data(), dht->nCodesPerLength.size()));
+  ht.setCodeValues(Buffer(dht->codeValues.data(), nCodes));
+  if (depth != AutoDepth)
+    ht.setLookupDepth(depth);
+  ht.setup(/*fullDecode_=*/true, /*fixDNGBug16_=*/false);
+
+  const size_t size = state.range(0);
+  auto storage = Buffer::Create(size);
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<unsigned> bytes(0, 255);
+  for (size_t i = 0; i < size; i++)
+    storage.get()[i] = bytes(rng);
+
+  const Buffer b(storage.get(), size);
+  const ByteStream bs(DataBuffer(b, Endianness::big));
+
+  // Each code+diff takes at most 32 bits, so this never overruns the input.
+  const size_t diffs = 8 * size / 32;
+
+  for (auto _ : state) {
+    BitPumpMSB pump(bs);
+    for (size_t i = 0; i < diffs; i++)
+      benchmark::DoNotOptimize(ht.decodeDifference(pump));
+  }
+
+  state.counters.insert(
+      {{"LookupDepth", ht.getLookupDepth()},
+       {"Diffs",
+        benchmark::Counter(
+            diffs, benchmark::Counter::Flags::kIsIterationInvariantRate)}});
+}
+
+void CustomArguments(benchmark::internal::Benchmark* b) {
+  b->Arg(4 << 20);
+  b->Unit(benchmark::kMillisecond);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  for (const DHT& dht : Tables) {
+    for (unsigned depth = 9; depth <= 14; depth++) {
+      std::string name("BM_HuffmanTableLUT<");
+      name += dht.name;
+      name += ", Depth<";
+      name += std::to_string(depth);
+      name += ">>";
+      auto* b = benchmark::RegisterBenchmark(name.c_str(), BM_HuffmanTableLUT,
+                                             &dht, depth);
+      b->Apply(CustomArguments);
+    }
+
+    std::string name("BM_HuffmanTableLUT<");
+    name += dht.name;
+    name += ", Depth<Auto>>";
+    auto* b = benchmark::RegisterBenchmark(name.c_str(), BM_HuffmanTableLUT,
+                                           &dht, AutoDepth);
+    b->Apply(CustomArguments);
+  }
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,164 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decompressors/NikonDecompressor.h"     // for NikonDecompressor
+#include "common/Point.h"                        // for iPoint2D
+#include "common/RawImage.h"                     // for RawImage, RawImageData
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex
+#include "io/Buffer.h"                           // for Buffer, DataBuffer
+#include "io/ByteStream.h"                       // for ByteStream
+#include "io/Endianness.h"                       // for Endianness, Endiannes...
+#include <array>                                 // for array
+#include <benchmark/benchmark.h>                 // for State, Benchmark, Ini...
+#include <cassert>                               // for assert
+#include <cstddef>                               // for size_t
+#include <cstdint>                               // for uint8_t, uint16_t
+#include <random>                                // for minstd_rand, uniform_...
+#include <string>                                // for string, to_string
+#include <vector>                                // for vector
+
+using rawspeed::Buffer;
+using rawspeed::ByteStream;
+using rawspeed::DataBuffer;
+using rawspeed::DecodeCheckpointIndex;
+using rawspeed::Endianness;
+using rawspeed::iPoint2D;
+using rawspeed::NikonDecompressor;
+using rawspeed::RawImage;
+using rawspeed::TYPE_USHORT16;
+
+namespace {
+
+struct Camera {
+  const char* name;
+  iPoint2D dim;
+};
+
+const std::array<Camera, 2> Cameras = {{
+    {"D800", {7424, 4924}},
+    {"D850", {8288, 5520}},
+}};
+
+// The lossy NEF metadata (v0 = 68, v1 = 32): the initial predictors,
+// an identity curve, and the row at which the Huffman tree changes.
+std::vector<uint8_t> createMetadata(unsigned bitsPS, uint16_t split) {
+  std::vector<uint8_t> meta;
+  const auto putU16 = [&meta](unsigned v) {
+    meta.push_back(v >> 8);
+    meta.push_back(v & 0xff);
+  };
+
+  meta.push_back(68);
+  meta.push_back(32);
+  for (int i = 0; i < 4; i++)
+    putU16(1U << (bitsPS - 1));
+
+  const unsigned csize = 257;
+  const unsigned step = (1U << bitsPS) / (csize - 1);
+  putU16(csize);
+  for (unsigned i = 0; i < csize; i++)
+    putU16(i * step);
+
+  assert(meta.size() <= 562);
+  meta.resize(562);
+  putU16(split);
+
+  return meta;
+}
+
+void BM_NikonDecompressor(benchmark::State& state, const Camera* camera,
+                          unsigned bitsPS, bool split, bool checkpoints) {
+  const iPoint2D dim = camera->dim;
+
+  const std::vector<uint8_t> meta =
+      createMetadata(bitsPS, split ? dim.y / 2 : 0);
+  const ByteStream metadata(
+      DataBuffer(Buffer(meta.data(), meta.size()), Endianness::big));
+
+  // All the Nikon lossy trees are complete, so random input is a valid input.
+  // No code+diff takes more than 25 bits, so this never overruns the input.
+  const size_t size = (25 * size_t(dim.area()) + 7) / 8;
+  auto storage = Buffer::Create(size);
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<unsigned> bytes(0, 255);
+  for (size_t i = 0; i < size; i++)
+    storage.get()[i] = bytes(rng);
+
+  const Buffer b(storage.get(), size);
+  const ByteStream bs(DataBuffer(b, Endianness::little));
+
+  RawImage mRaw = RawImage::create(dim, TYPE_USHORT16, 1);
+
+  // A repeated decode: the index was recorded by some previous decode.
+  DecodeCheckpointIndex index;
+  if (checkpoints) {
+    NikonDecompressor n(mRaw, metadata, bitsPS);
+    n.setCheckpointIndex(&index);
+    n.decompress(bs, /*uncorrectedRawValues=*/false);
+  }
+
+  for (auto _ : state) {
+    NikonDecompressor n(mRaw, metadata, bitsPS);
+    if (checkpoints)
+      n.setCheckpointIndex(&index);
+    n.decompress(bs, /*uncorrectedRawValues=*/false);
+  }
+
+  state.SetComplexityN(dim.area());
+  state.counters.insert(
+      {{"Pixels", benchmark::Counter(
+                      state.complexity_length_n(),
+                      benchmark::Counter::Flags::kIsIterationInvariantRate)}});
+}
+
+void CustomArguments(benchmark::internal::Benchmark* b) {
+  b->MeasureProcessCPUTime();
+  b->UseRealTime();
+  b->Unit(benchmark::kMillisecond);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  for (const Camera& camera : Cameras) {
+    for (unsigned bitsPS : {12, 14}) {
+      for (bool split : {false, true}) {
+        for (bool checkpoints : {false, true}) {
+          std::string name("BM_NikonDecompressor<");
+          name += camera.name;
+          name += ", ";
+          name += std::to_string(bitsPS);
+          name += "bit, ";
+          name += split ? "Split" : "NoSplit";
+          if (checkpoints)
+            name += ", Checkpoints";
+          name += ">";
+          auto* b = benchmark::RegisterBenchmark(name.c_str(),
+                                                 BM_NikonDecompressor, &camera,
+                                                 bitsPS, split, checkpoints);
+          b->Apply(CustomArguments);
+        }
+      }
+    }
+  }
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+}
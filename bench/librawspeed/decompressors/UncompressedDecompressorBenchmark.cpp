@@ -0,0 +1,107 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decompressors/UncompressedDecompressor.h" // for UncompressedDeco...
+#include "bench/Common.h"                           // for areaToRectangle
+#include "common/Common.h"                          // for BitOrder, roundUp
+#include "common/Point.h"                           // for iPoint2D
+#include "common/RawImage.h"                        // for RawImage, RawIma...
+#include "io/Buffer.h"                              // for Buffer, DataBuffer
+#include "io/ByteStream.h"                          // for ByteStream
+#include "io/Endianness.h"                          // for Endianness, Endi...
+#include <benchmark/benchmark.h>                    // for State, Benchmark
+#include <cstdint>                                  // for uint16_t
+#include <type_traits>                              // for integral_constant
+
+using rawspeed::BitOrder;
+using rawspeed::BitOrder_LSB;
+using rawspeed::BitOrder_MSB;
+using rawspeed::BitOrder_MSB16;
+using rawspeed::BitOrder_MSB32;
+using rawspeed::Buffer;
+using rawspeed::ByteStream;
+using rawspeed::DataBuffer;
+using rawspeed::Endianness;
+using rawspeed::iPoint2D;
+using rawspeed::RawImage;
+using rawspeed::roundUp;
+using rawspeed::TYPE_USHORT16;
+using rawspeed::UncompressedDecompressor;
+using std::integral_constant;
+
+template <int N> using BPS = integral_constant<int, N>;
+template <BitOrder N> using Order = integral_constant<BitOrder, N>;
+
+template <typename BPS, typename Order>
+static inline void BM_UncompressedDecompressor(benchmark::State& state) {
+  iPoint2D dim = areaToRectangle(state.range(0));
+  // Every order must consume whole bytes (MSB32 - whole 32-bit words).
+  dim.x = roundUp(dim.x, 32);
+
+  const int inputPitch = BPS::value * dim.x / 8;
+
+  // will contain some random garbage
+  Buffer buf(Buffer::Create(inputPitch * dim.y), inputPitch * dim.y);
+  const ByteStream bs(DataBuffer(buf, Endianness::little));
+
+  RawImage mRaw = RawImage::create(dim, TYPE_USHORT16, 1);
+
+  for (auto _ : state) {
+    UncompressedDecompressor u(bs, mRaw);
+    u.readUncompressedRaw(dim, {0, 0}, inputPitch, BPS::value, Order::value);
+  }
+
+  state.SetComplexityN(dim.area());
+  state.counters.insert(
+      {{"Pixels", benchmark::Counter(
+                      state.complexity_length_n(),
+                      benchmark::Counter::Flags::kIsIterationInvariantRate)},
+       {"Bytes", benchmark::Counter(
+                     BPS::value * state.complexity_length_n() / 8,
+                     benchmark::Counter::Flags::kIsIterationInvariantRate,
+                     benchmark::Counter::kIs1024)}});
+}
+
+static inline void CustomArguments(benchmark::internal::Benchmark* b) {
+  b->MeasureProcessCPUTime();
+  b->UseRealTime();
+  b->RangeMultiplier(2);
+#if 1
+  b->Arg(24'000'000);
+#else
+  b->Range(1, 256 << 20)->Complexity(benchmark::oN);
+#endif
+  b->Unit(benchmark::kMillisecond);
+}
+
+#define GEN_E(s, o)                                                            \
+  BENCHMARK_TEMPLATE(BM_UncompressedDecompressor, BPS<s>, Order<o>)            \
+      ->Apply(CustomArguments);
+#define GEN_OS(s)                                                              \
+  GEN_E(s, BitOrder_LSB)                                                       \
+  GEN_E(s, BitOrder_MSB)                                                       \
+  GEN_E(s, BitOrder_MSB16)                                                     \
+  GEN_E(s, BitOrder_MSB32)
+
+GEN_OS(10)
+GEN_OS(12)
+GEN_OS(14)
+
+BENCHMARK_MAIN();
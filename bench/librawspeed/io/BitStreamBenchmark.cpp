@@ -39,6 +39,11 @@ using rawspeed::BitPumpLSB;
 using rawspeed::BitPumpMSB;
 using rawspeed::BitPumpMSB16;
 using rawspeed::BitPumpMSB32;
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+using rawspeed::BitPumpJPEGWide;
+using rawspeed::BitPumpMSB32Wide;
+using rawspeed::BitPumpMSBWide;
+#endif
 using rawspeed::Endianness;
 
 static constexpr const size_t STEP_MAX = 32;
@@ -142,6 +147,11 @@ int main(int argc, char** argv) {
   REGISTER_PUMP(BitPumpMSB16);
   REGISTER_PUMP(BitPumpMSB32);
   REGISTER_PUMP(BitPumpJPEG);
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+  REGISTER_PUMP(BitPumpMSBWide);
+  REGISTER_PUMP(BitPumpMSB32Wide);
+  REGISTER_PUMP(BitPumpJPEGWide);
+#endif
 
   benchmark::Initialize(&argc, argv);
   benchmark::RunSpecifiedBenchmarks();
@@ -0,0 +1,130 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "io/Buffer.h"           // for Buffer, DataBuffer
+#include "io/ByteCursor.h"       // for ByteCursor
+#include "io/ByteStream.h"       // for ByteStream
+#include "io/Endianness.h"       // for Endianness, Endianness::big, Endian...
+#include <benchmark/benchmark.h> // for State, Benchmark, DoNotOptimize
+#include <cassert>               // for assert
+#include <cstddef>               // for size_t
+#include <cstdint>               // for uint8_t, uint16_t, uint32_t
+#include <cstring>               // for memset
+#include <string>                // for string
+#include <type_traits>           // for integral_constant
+
+using rawspeed::Endianness;
+
+// Measures the cost of the bounds-checked element getters of ByteStream.
+template <typename T>
+static inline void BM_ByteStream(benchmark::State& state,
+                                 Endianness endianness) {
+  assert(state.range(0) > 0);
+
+  const auto size = static_cast<rawspeed::Buffer::size_type>(state.range(0));
+  auto storage = rawspeed::Buffer::Create(size);
+  memset(storage.get(), 0, size);
+  const rawspeed::Buffer b(storage.get(), size);
+  assert(b.getSize() == size);
+
+  const rawspeed::DataBuffer db(b, endianness);
+  rawspeed::ByteStream bs(db);
+
+  const size_t numElements = b.getSize() / sizeof(T);
+
+  for (auto _ : state) {
+    bs.setPosition(0);
+
+    for (size_t i = 0; i < numElements; ++i)
+      benchmark::DoNotOptimize(bs.get<T>());
+  }
+
+  state.SetComplexityN(numElements * sizeof(T));
+  state.SetItemsProcessed(numElements * state.iterations());
+  state.SetBytesProcessed(numElements * sizeof(T) * state.iterations());
+}
+
+// Same, but through the ByteCursor, that is only checked once.
+template <typename T>
+static inline void BM_ByteCursor(benchmark::State& state,
+                                 Endianness endianness) {
+  assert(state.range(0) > 0);
+
+  const auto size = static_cast<rawspeed::Buffer::size_type>(state.range(0));
+  auto storage = rawspeed::Buffer::Create(size);
+  memset(storage.get(), 0, size);
+  const rawspeed::Buffer b(storage.get(), size);
+  assert(b.getSize() == size);
+
+  const rawspeed::DataBuffer db(b, endianness);
+  const rawspeed::ByteStream bs(db);
+
+  const size_t numElements = b.getSize() / sizeof(T);
+
+  for (auto _ : state) {
+    rawspeed::ByteCursor c = bs.peekCursor(numElements, sizeof(T));
+
+    for (size_t i = 0; i < numElements; ++i)
+      benchmark::DoNotOptimize(c.read<T>());
+  }
+
+  state.SetComplexityN(numElements * sizeof(T));
+  state.SetItemsProcessed(numElements * state.iterations());
+  state.SetBytesProcessed(numElements * sizeof(T) * state.iterations());
+}
+
+static inline void CustomArguments(benchmark::internal::Benchmark* b) {
+  b->Arg(256 << 20);
+  b->Unit(benchmark::kMillisecond);
+}
+
+using Big = std::integral_constant<Endianness, Endianness::big>;
+using Little = std::integral_constant<Endianness, Endianness::little>;
+
+template <typename BO>
+void registerType(const char* reader, const char* byteOrder,
+                  const char* typeName,
+                  void (*Fn)(benchmark::State&, Endianness)) {
+  std::string name(reader);
+  name += "<ByteOrder<";
+  name += byteOrder;
+  name += ">, Type<";
+  name += typeName;
+  name += ">>";
+
+  auto* b = benchmark::RegisterBenchmark(name.c_str(), Fn, BO::value);
+  b->Apply(CustomArguments);
+}
+
+#define REG_TYPE_2(BO, T)                                                      \
+  registerType<BO>("BM_ByteStream", #BO, #T, BM_ByteStream<T>);                \
+  registerType<BO>("BM_ByteCursor", #BO, #T, BM_ByteCursor<T>)
+#define REGISTER_TYPE(T)                                                       \
+  REG_TYPE_2(Big, T);                                                          \
+  REG_TYPE_2(Little, T)
+
+int main(int argc, char** argv) {
+  REGISTER_TYPE(uint8_t);
+  REGISTER_TYPE(uint16_t);
+  REGISTER_TYPE(uint32_t);
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+}
@@ -0,0 +1,13 @@
+include(CheckCXXSourceCompiles)
+
+# Can the current thread be restricted to a set of CPUs? (Linux)
+CHECK_CXX_SOURCE_COMPILES("
+#include <sched.h>
+int main(void)
+{
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(0, &set);
+  return sched_setaffinity(0, sizeof(set), &set) +
+         sched_getaffinity(0, sizeof(set), &set);
+}" HAVE_SCHED_SETAFFINITY)
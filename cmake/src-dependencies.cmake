@@ -92,6 +92,20 @@ else()
 endif()
 add_feature_info("OpenMP-based threading" HAVE_OPENMP "used for parallelization of the library")
 
+message(STATUS "Looking for Threads")
+set(THREADS_PREFER_PTHREAD_FLAG ON)
+find_package(Threads)
+if(NOT Threads_FOUND)
+  message(SEND_ERROR "Did not find Threads! The platform threading library is required.")
+else()
+  message(STATUS "Looking for Threads - found")
+  target_link_libraries(rawspeed PUBLIC Threads::Threads)
+  set_package_properties(Threads PROPERTIES
+                         TYPE REQUIRED
+                         DESCRIPTION "Platform threading library"
+                         PURPOSE "Used for read-ahead of input files")
+endif()
+
 unset(HAVE_PUGIXML)
 if(WITH_PUGIXML)
   message(STATUS "Looking for pugixml")
@@ -0,0 +1,105 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+// Checks that the speculative parallel decoding of the Cr2Decompressor
+// decodes exactly the same image as the serial one, or fails just the same.
+
+#include "decompressors/Cr2Decompressor.h"
+#include "common/Point.h"             // for iPoint2D
+#include "common/RawImage.h"          // for RawImage, RawImageData
+#include "common/RawspeedException.h" // for RawspeedException
+#include "fuzz/Common.h"              // for CreateRawImage
+#include "io/Buffer.h"                // for Buffer, DataBuffer
+#include "io/ByteStream.h"            // for ByteStream
+#include "io/Endianness.h"            // for Endianness, Endianness::little
+#include <cassert>                    // for assert
+#include <cstdint>                    // for uint8_t, uint16_t
+#include <cstdio>                     // for size_t
+#include <cstring>                    // for memcmp
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* Data, size_t Size);
+
+namespace {
+
+// Decodes the image, and tells whether the decoding has succeeded.
+rawspeed::RawImage decode(const rawspeed::DataBuffer& db, bool speculative,
+                          bool* success) {
+  rawspeed::ByteStream bs(db);
+
+  rawspeed::RawImage mRaw(CreateRawImage(&bs));
+
+  using slice_type = uint16_t;
+  const auto numSlices = bs.get<slice_type>();
+  const auto sliceWidth = bs.get<slice_type>();
+  const auto lastSliceWidth = bs.get<slice_type>();
+
+  const rawspeed::Cr2Slicing slicing(numSlices, sliceWidth, lastSliceWidth);
+
+  rawspeed::Cr2Decompressor c(bs, mRaw);
+  c.setSpeculativeParallelDecode(speculative);
+  mRaw->createData();
+  try {
+    c.decode(slicing);
+  } catch (rawspeed::RawspeedException&) {
+    *success = false;
+    return mRaw;
+  }
+
+  mRaw->checkMemIsInitialized();
+  *success = true;
+  return mRaw;
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* Data, size_t Size) {
+  assert(Data);
+
+  try {
+    const rawspeed::Buffer b(Data, Size);
+    const rawspeed::DataBuffer db(b, rawspeed::Endianness::little);
+
+    bool success0 = false;
+    bool success1 = false;
+    rawspeed::RawImage serial = decode(db, /*speculative=*/false, &success0);
+    rawspeed::RawImage speculative =
+        decode(db, /*speculative=*/true, &success1);
+
+    // They both should either fail or succeed, else there is a bug.
+    assert(success0 == success1);
+
+    // If any failed, there is nothing to compare.
+    if (!success0 || !success1)
+      return 0;
+
+    // They both should have decoded the very same pixels.
+    const rawspeed::iPoint2D dim = serial->getUncroppedDim();
+    assert(speculative->getUncroppedDim() == dim);
+    for (int row = 0; row < dim.y; ++row) {
+      assert(memcmp(serial->getDataUncropped(0, row),
+                    speculative->getDataUncropped(0, row),
+                    dim.x * serial->getBpp()) == 0);
+    }
+  } catch (rawspeed::RawspeedException&) {
+    // Exceptions are good, crashes are bad.
+  }
+
+  return 0;
+}
@@ -0,0 +1,141 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+// Checks that HuffmanTableLUT with the shifted differences decodes exactly
+// the same differences as the NikonLASDecompressor it has replaced.
+
+#include "common/RawspeedException.h"            // for RawspeedException
+#include "decompressors/HuffmanTable/NikonLAS.h" // for NikonLASDecompressor
+#include "decompressors/HuffmanTableLUT.h"       // for HuffmanTableLUT
+#include "io/BitPumpMSB.h"                       // for BitPumpMSB
+#include "io/BitStream.h"                        // for BitStream
+#include "io/Buffer.h"                           // for Buffer, DataBuffer
+#include "io/ByteStream.h"                       // for ByteStream
+#include "io/Endianness.h"                       // for Endianness, Endiannes...
+#include "io/IOException.h"                      // for IOException
+#include <cassert>                               // for assert
+#include <cstdint>                               // for uint8_t, uint32_t
+#include <cstdio>                                // for size_t
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* Data, size_t Size);
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* Data, size_t Size) {
+  assert(Data);
+
+  try {
+    const rawspeed::Buffer b(Data, Size);
+    const rawspeed::DataBuffer db(b, rawspeed::Endianness::little);
+    rawspeed::ByteStream bs(db);
+
+    // first 16 bytes are consumed as n-codes-per-length,
+    // and then count more bytes consumed as code values.
+    const rawspeed::Buffer nCodesPerLength = bs.getBuffer(16);
+
+    rawspeed::HuffmanTableLUT ht0;
+    const auto count = ht0.setNCodesPerLength(nCodesPerLength);
+    const rawspeed::Buffer codeValues = bs.getBuffer(count);
+    ht0.setCodeValues(codeValues);
+    ht0.enableShiftedDifferences();
+    // The LUT is the stricter one. Only the tables it accepts are compared.
+    ht0.setup(/*fullDecode_=*/true, /*fixDNGBug16_=*/false);
+
+    // The reference only supports the complete tables with the codes of at
+    // most 14 bits (the bits of its big table), like the real Nikon trees.
+    uint32_t kraftSum = 0; // in the units of 2^-16
+    for (uint32_t l = 1; l <= 16; l++) {
+      if (l > 14 && nCodesPerLength[l - 1] != 0)
+        return 0;
+      kraftSum += nCodesPerLength[l - 1] << (16 - l);
+    }
+    if (kraftSum != 1U << 16)
+      return 0;
+    // And it can not read a zero-length difference (but for the code value 0).
+    for (const auto codeValue : codeValues) {
+      if (codeValue != 0 && codeValue != 16 &&
+          (codeValue >> 4) >= (codeValue & 15))
+        return 0;
+    }
+
+    rawspeed::NikonLASDecompressor ht1;
+    bool tableFailure = false;
+    try {
+      (void)ht1.setNCodesPerLength(nCodesPerLength);
+      ht1.setCodeValues(codeValues);
+      ht1.setup(/*fullDecode_=*/true, /*fixDNGBug16_=*/false);
+    } catch (rawspeed::RawspeedException&) {
+      tableFailure = true;
+    }
+
+    // Any table the LUT accepts must be accepted by the reference, too.
+    assert(!tableFailure);
+    if (tableFailure)
+      return 0;
+
+    rawspeed::BitPumpMSB bits0(bs);
+    rawspeed::BitPumpMSB bits1(bs);
+
+    while (true) {
+      bool failure0 = false;
+      bool failure1 = false;
+
+      int decoded0 = 0;
+      int decoded1 = 0;
+
+      try {
+        decoded0 = ht0.decodeDifference(bits0);
+      } catch (rawspeed::IOException&) {
+        // For now, let's ignore stream depleteon issues.
+        throw;
+      } catch (rawspeed::RawspeedException&) {
+        failure0 = true;
+      }
+      try {
+        decoded1 = ht1.decodeDifference(bits1);
+      } catch (rawspeed::IOException&) {
+        // For now, let's ignore stream depleteon issues.
+        throw;
+      } catch (rawspeed::RawspeedException&) {
+        failure1 = true;
+      }
+
+      // They both should either fail or succeed, else there is a bug.
+      assert(failure0 == failure1);
+
+      // If any failed, we can't continue.
+      if (failure0 || failure1)
+        return 0;
+
+      (void)decoded0;
+      (void)decoded1;
+
+      // They both should have decoded the same value,
+      assert(decoded0 == decoded1);
+
+      // and should now be at the same position in the input.
+      bits0.fill(32);
+      bits1.fill(32);
+      assert(bits0.peekBitsNoFill(24) == bits1.peekBitsNoFill(24));
+    }
+  } catch (rawspeed::RawspeedException&) {
+    return 0;
+  }
+
+  __builtin_unreachable();
+}
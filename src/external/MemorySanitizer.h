@@ -48,6 +48,10 @@ struct MSan final {
   /* Checks that memory range is fully initialized, and reports an error if it
    * is not. */
   static void CheckMemIsInitialized(const volatile void* addr, size_t size);
+
+  /* Marks the memory range as freshly allocated, i.e. as uninitialized, e.g.
+   * when a buffer that was used before is handed out again. */
+  static void Allocated(const volatile void* addr, size_t size);
 };
 
 #if __has_feature(memory_sanitizer) || defined(__SANITIZE_MEMORY__)
@@ -55,6 +59,9 @@ inline void MSan::CheckMemIsInitialized(const volatile void* addr,
                                         size_t size) {
   __msan_check_mem_is_initialized(addr, size);
 }
+inline void MSan::Allocated(const volatile void* addr, size_t size) {
+  __msan_allocated_memory(addr, size);
+}
 #else
 inline void MSan::CheckMemIsInitialized(const volatile void* addr,
                                         size_t size) {
@@ -62,6 +69,11 @@ inline void MSan::CheckMemIsInitialized(const volatile void* addr,
   // body of this function. It's better than to have a macros, or to use
   // preprocessor in every place it is called.
 }
+inline void MSan::Allocated(const volatile void* addr, size_t size) {
+  // If we are building without MSAN, then there is no way to have a non-empty
+  // body of this function. It's better than to have a macros, or to use
+  // preprocessor in every place it is called.
+}
 #endif
 
 } // namespace rawspeed
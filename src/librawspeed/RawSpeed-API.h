@@ -26,11 +26,16 @@
 #include "rawspeedconfig.h"
 
 #include "common/Common.h"
+#include "common/Executor.h"
 #include "common/Mutex.h"
 #include "common/Point.h"
 #include "common/RawImage.h"
+#include "common/RawImagePool.h"
 #include "common/RawspeedException.h"
+#include "decoders/BatchDecoder.h"
 #include "decoders/RawDecoder.h"
+#include "decompressors/DecodeCheckpointIndex.h"
+#include "io/BatchFileReader.h"
 #include "io/Buffer.h"
 #include "io/Endianness.h"
 #include "io/FileReader.h"
@@ -0,0 +1,183 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "rawspeedconfig.h" // for HAVE_SCHED_SETAFFINITY
+#include "common/CpuSet.h"
+#include "common/Common.h"            // for splitString
+#include "common/RawspeedException.h" // for ThrowRSE
+#include <algorithm>                  // for sort, unique, set_intersection
+#include <fstream>                    // IWYU pragma: keep
+#include <iterator>                   // for back_inserter
+#include <string>                     // for string, getline, to_string
+#include <utility>                    // for move
+#include <vector>                     // for vector
+
+#ifdef HAVE_SCHED_SETAFFINITY
+#include <sched.h> // for cpu_set_t, sched_getaffinity, sched_setaffinity
+#endif
+
+namespace rawspeed {
+
+namespace {
+
+int parseCpu(const std::string& list, const std::string& number) {
+  static constexpr int MaxCpu = 1 << 16;
+
+  if (number.empty() || number.size() > 5 ||
+      number.find_first_not_of("0123456789") != std::string::npos)
+    ThrowRSE("Malformed CPU list: \"%s\"", list.c_str());
+
+  const int cpu = std::stoi(number);
+  if (cpu >= MaxCpu)
+    ThrowRSE("CPU %i is out of range in the CPU list \"%s\"", cpu,
+             list.c_str());
+  return cpu;
+}
+
+// The first line of that file, or nothing if it could not be read.
+std::string readLine(const std::string& fileName) {
+  std::ifstream file(fileName);
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+} // namespace
+
+CpuSet::CpuSet(std::vector<int> cpus_) : cpus(std::move(cpus_)) {
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+}
+
+CpuSet CpuSet::parse(const std::string& list) {
+  std::vector<int> cpus;
+  for (const std::string& item : splitString(list, ',')) {
+    const auto dash = item.find('-');
+    const int first = parseCpu(list, item.substr(0, dash));
+    const int last = dash == std::string::npos
+                         ? first
+                         : parseCpu(list, item.substr(dash + 1));
+    if (first > last)
+      ThrowRSE("Malformed CPU list: \"%s\"", list.c_str());
+
+    for (int cpu = first; cpu <= last; ++cpu)
+      cpus.emplace_back(cpu);
+  }
+  return CpuSet(std::move(cpus));
+}
+
+CpuSet CpuSet::ofNumaNode(int node) {
+  if (node < 0)
+    return CpuSet();
+
+  const std::string list = readLine("/sys/devices/system/node/node" +
+                                    std::to_string(node) + "/cpulist");
+  return parse(list);
+}
+
+CpuSet CpuSet::ofCurrentThread() {
+#ifdef HAVE_SCHED_SETAFFINITY
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) != 0)
+    return CpuSet();
+
+  std::vector<int> cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &set))
+      cpus.emplace_back(cpu);
+  }
+  return CpuSet(std::move(cpus));
+#else
+  return CpuSet();
+#endif
+}
+
+CpuSet CpuSet::intersect(const CpuSet& other) const {
+  std::vector<int> common;
+  std::set_intersection(cpus.begin(), cpus.end(), other.cpus.begin(),
+                        other.cpus.end(), std::back_inserter(common));
+  return CpuSet(std::move(common));
+}
+
+std::string CpuSet::toString() const {
+  std::string list;
+  for (auto first = cpus.begin(); first != cpus.end();) {
+    auto last = first;
+    while (last + 1 != cpus.end() && *(last + 1) == *last + 1)
+      ++last;
+
+    if (!list.empty())
+      list += ',';
+    list += std::to_string(*first);
+    if (last != first)
+      list += '-' + std::to_string(*last);
+
+    first = last + 1;
+  }
+  return list;
+}
+
+bool CpuSet::applyToCurrentThread() const {
+#ifdef HAVE_SCHED_SETAFFINITY
+  if (cpus.empty() || cpus.back() >= CPU_SETSIZE)
+    return false;
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus)
+    CPU_SET(cpu, &set);
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
+std::vector<int> getNumaNodes() {
+  // Same format as the CPU lists.
+  return CpuSet::parse(readLine("/sys/devices/system/node/online")).getCpus();
+}
+
+int getNumaNodeOfCurrentThread() {
+  const CpuSet current = CpuSet::ofCurrentThread();
+  if (current.empty())
+    return -1;
+
+  for (int node : getNumaNodes()) {
+    if (current.intersect(CpuSet::ofNumaNode(node)) == current)
+      return node;
+  }
+  return -1;
+}
+
+ScopedThreadAffinity::ScopedThreadAffinity(const CpuSet& cpus) {
+  if (cpus.empty())
+    return;
+
+  previous = CpuSet::ofCurrentThread();
+  applied = !previous.empty() && cpus.applyToCurrentThread();
+}
+
+ScopedThreadAffinity::~ScopedThreadAffinity() {
+  if (applied)
+    previous.applyToCurrentThread();
+}
+
+} // namespace rawspeed
@@ -0,0 +1,89 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <string> // for string
+#include <vector> // for vector
+
+namespace rawspeed {
+
+// A set of (logical) CPUs, e.g. the ones some threads may run on.
+// Where the affinity can not be queried or set (i.e. not on Linux),
+// the functions below report that as an empty set, or as a failure.
+class CpuSet final {
+  std::vector<int> cpus; // Sorted, without duplicates.
+
+public:
+  CpuSet() = default;
+  explicit CpuSet(std::vector<int> cpus_);
+
+  // Parses the "cpulist" format (of sysfs, or `taskset -c`), i.e. a comma
+  // separated list of CPUs and (inclusive) ranges of them, e.g. "0-3,8,10-11".
+  static CpuSet parse(const std::string& list);
+
+  // The CPUs of that NUMA node.
+  static CpuSet ofNumaNode(int node);
+
+  // The CPUs the current thread may run on.
+  static CpuSet ofCurrentThread();
+
+  bool empty() const { return cpus.empty(); }
+  int size() const { return cpus.size(); }
+  const std::vector<int>& getCpus() const { return cpus; }
+
+  bool operator==(const CpuSet& other) const { return cpus == other.cpus; }
+  bool operator!=(const CpuSet& other) const { return !(*this == other); }
+
+  CpuSet intersect(const CpuSet& other) const;
+
+  // In the format parse() accepts.
+  std::string toString() const;
+
+  // Restricts the current thread to these CPUs. Returns whether it worked.
+  bool applyToCurrentThread() const;
+};
+
+// The NUMA nodes that are online.
+std::vector<int> getNumaNodes();
+
+// The NUMA node the current thread is restricted to, i.e. the one its memory
+// ends up on. -1 if it may run on the CPUs of several nodes, or if nothing is
+// known about them.
+int getNumaNodeOfCurrentThread();
+
+// Restricts the current thread to the given CPUs, until it goes out of scope.
+// Does nothing if the set is empty.
+class ScopedThreadAffinity final {
+  CpuSet previous;
+  bool applied = false;
+
+public:
+  explicit ScopedThreadAffinity(const CpuSet& cpus);
+
+  ScopedThreadAffinity(const ScopedThreadAffinity&) = delete;
+  ScopedThreadAffinity(ScopedThreadAffinity&&) = delete;
+  ScopedThreadAffinity& operator=(const ScopedThreadAffinity&) = delete;
+  ScopedThreadAffinity& operator=(ScopedThreadAffinity&&) = delete;
+
+  ~ScopedThreadAffinity();
+};
+
+} // namespace rawspeed
@@ -0,0 +1,93 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "common/ExecutionPolicy.h"
+#include "common/CpuSet.h"            // for CpuSet, ScopedThreadAffinity
+#include "common/Executor.h"          // for Executor, LimitedExecutor, get...
+#include "common/RawspeedException.h" // for ThrowRSE
+#include <algorithm>                  // for min
+#include <functional>                 // for function
+#include <memory>                     // for unique_ptr, make_unique
+#include <utility>                    // for move
+
+namespace rawspeed {
+
+namespace {
+
+// Runs the loops on another executor, whose threads may run anywhere, with
+// each one of them restricted to the given CPUs while it runs a chunk.
+class AffineExecutor final : public Executor {
+  LimitedExecutor executor;
+  CpuSet cpus;
+
+public:
+  AffineExecutor(Executor* executor_, int maxThreads, CpuSet cpus_)
+      : executor(executor_, maxThreads), cpus(std::move(cpus_)) {}
+
+  int getConcurrency() const override { return executor.getConcurrency(); }
+
+  using Executor::parallelFor;
+  void parallelFor(int begin, int end, int grainSize, int maxThreads,
+                   const std::function<void(int, int)>& body) override {
+    executor.parallelFor(begin, end, grainSize, maxThreads,
+                         [this, &body](int chunkBegin, int chunkEnd) {
+                           const ScopedThreadAffinity affinity(cpus);
+                           body(chunkBegin, chunkEnd);
+                         });
+  }
+};
+
+} // namespace
+
+CpuSet ExecutionPolicy::getAllowedCpus() const {
+  const CpuSet node = CpuSet::ofNumaNode(numaNode);
+  if (node.empty())
+    return cpus;
+  if (cpus.empty())
+    return node;
+
+  CpuSet allowed = cpus.intersect(node);
+  if (allowed.empty()) {
+    ThrowRSE("None of the CPUs %s are on the NUMA node %i",
+             cpus.toString().c_str(), numaNode);
+  }
+  return allowed;
+}
+
+std::unique_ptr<Executor>
+ExecutionPolicy::makeExecutor(Executor* executor) const {
+  if (!executor)
+    executor = &getDefaultExecutor();
+
+  const CpuSet allowed = getAllowedCpus();
+
+  if (allowed.empty()) {
+    if (maxThreads <= 0)
+      return nullptr;
+    return std::make_unique<LimitedExecutor>(executor, maxThreads);
+  }
+
+  int numThreads = allowed.size();
+  if (maxThreads > 0)
+    numThreads = std::min(numThreads, maxThreads);
+  return std::make_unique<AffineExecutor>(executor, numThreads, allowed);
+}
+
+} // namespace rawspeed
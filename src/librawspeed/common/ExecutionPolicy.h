@@ -0,0 +1,57 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "common/CpuSet.h" // for CpuSet
+#include <memory>          // for unique_ptr
+
+namespace rawspeed {
+
+class Executor;
+
+// Where, and with how many threads, the parallel parts of a decode may run.
+// By default, anywhere, with as many threads as the executor has.
+struct ExecutionPolicy final {
+  // If positive, at most that many threads.
+  int maxThreads = 0;
+
+  // If not empty, only on these CPUs.
+  CpuSet cpus;
+
+  // If not negative, only on the CPUs of that NUMA node. Since the memory is
+  // placed on the node of the thread that first touches it, that is where
+  // the decoded image ends up too.
+  int numaNode = -1;
+
+  // The CPUs the decode may run on, i.e. cpus, restricted to the numaNode.
+  // Empty only if neither is restricted (a node nothing is known about does
+  // not restrict anything).
+  CpuSet getAllowedCpus() const;
+
+  // An executor that runs the loops as this policy says, on top of the given
+  // one (or getDefaultExecutor()), or nullptr if that one is fine as-is.
+  // No threads are started: if the CPUs are restricted, the threads of the
+  // given executor are restricted to them while they work on a loop, and no
+  // more of them than there are such CPUs.
+  std::unique_ptr<Executor> makeExecutor(Executor* executor) const;
+};
+
+} // namespace rawspeed
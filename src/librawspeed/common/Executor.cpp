@@ -0,0 +1,57 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "rawspeedconfig.h" // for HAVE_OPENMP
+#include "common/Executor.h"
+#include "common/Common.h"             // for rawspeed_get_number_of_proce...
+#include "common/OpenMPExecutor.h"     // for OpenMPExecutor
+#include "common/ThreadPoolExecutor.h" // for ThreadPoolExecutor
+#include <functional>                  // for function
+#include <utility>                     // for swap
+#include <vector>                      // for vector
+
+namespace rawspeed {
+
+void TaskGroup::wait() {
+  std::vector<std::function<void()>> queued;
+  std::swap(queued, tasks);
+
+  executor->parallelForEach(0, queued.size(), [this, &queued](int i) {
+    if (cancelled)
+      return;
+    try {
+      queued[i]();
+    } catch (...) {
+      cancelled = true;
+      throw;
+    }
+  });
+}
+
+Executor& getDefaultExecutor() {
+#ifdef HAVE_OPENMP
+  static OpenMPExecutor executor;
+#else
+  static ThreadPoolExecutor executor(rawspeed_get_number_of_processor_cores());
+#endif
+  return executor;
+}
+
+} // namespace rawspeed
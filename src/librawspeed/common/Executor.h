@@ -0,0 +1,147 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "common/Common.h" // for roundUpDivision
+#include <algorithm>       // for max, min, stable_sort
+#include <atomic>          // for atomic
+#include <functional>      // for function
+#include <numeric>         // for iota
+#include <utility>         // for move
+#include <vector>          // for vector
+
+namespace rawspeed {
+
+// Runs the parallel parts of the decoding. All the decompressors ever need is
+// "do this for each of these items, maybe concurrently, and come back once all
+// of them are done", so that is all an executor has to provide. Whoever embeds
+// the library and already has a scheduler of its own can implement it on top
+// of that one, instead of having a second thread pool compete with it.
+class Executor {
+public:
+  virtual ~Executor() = default;
+
+  // How many of the chunks may be running at the same time, at most.
+  virtual int getConcurrency() const = 0;
+
+  // Splits [begin, end) into chunks of (at most) grainSize consecutive
+  // indices, calls body(chunkBegin, chunkEnd) for each chunk, possibly
+  // concurrently, and returns once all of them are done.
+  // No more than maxThreads threads (the calling one included) work on the
+  // loop at the same time.
+  // If a body throws, the chunks that have not started yet are skipped,
+  // and once the running ones are done, the first exception is rethrown.
+  // May be called from within a body, such nested loops may run serially.
+  virtual void parallelFor(int begin, int end, int grainSize, int maxThreads,
+                           const std::function<void(int, int)>& body) = 0;
+
+  void parallelFor(int begin, int end, int grainSize,
+                   const std::function<void(int, int)>& body) {
+    parallelFor(begin, end, grainSize, getConcurrency(), body);
+  }
+
+  // A grain size that splits numItems (similarly expensive) items into a few
+  // chunks per thread: few enough to be cheap to schedule, yet enough for
+  // the threads to even out the differences between them.
+  int getGrainSize(int numItems) const {
+    static constexpr int ChunksPerThread = 4;
+    return std::max<int>(
+        1, roundUpDivision(numItems,
+                           ChunksPerThread * std::max(getConcurrency(), 1)));
+  }
+
+  // Calls body(i) for each i in [begin, end), possibly concurrently.
+  template <typename Lambda>
+  void parallelForEach(int begin, int end, Lambda body) {
+    parallelFor(begin, end, /*grainSize=*/1, [&body](int b, int e) {
+      for (int i = b; i < e; ++i)
+        body(i);
+    });
+  }
+};
+
+// Runs the loops on another executor, but with at most maxThreads threads
+// working on each one of them. E.g. several decodes that run at the same time
+// may then share one executor, without any one of them taking all of it.
+class LimitedExecutor final : public Executor {
+  Executor* executor;
+  int maxThreads;
+
+public:
+  LimitedExecutor(Executor* executor_, int maxThreads_)
+      : executor(executor_), maxThreads(std::max(maxThreads_, 1)) {}
+
+  int getConcurrency() const override {
+    return std::min(maxThreads, executor->getConcurrency());
+  }
+
+  using Executor::parallelFor;
+  void parallelFor(int begin, int end, int grainSize, int maxThreads_,
+                   const std::function<void(int, int)>& body) override {
+    executor->parallelFor(begin, end, grainSize,
+                          std::min(maxThreads_, getConcurrency()), body);
+  }
+};
+
+// A set of independent tasks. run() only queues a task, wait() then runs all
+// of them with the executor. Once the group is cancel()'ed, or one of the
+// tasks throws, the tasks that have not started yet are skipped. The ones
+// that are already running may poll isCancelled() to finish early.
+class TaskGroup final {
+  Executor* executor;
+  std::vector<std::function<void()>> tasks;
+  std::atomic<bool> cancelled{false};
+
+public:
+  explicit TaskGroup(Executor* executor_) : executor(executor_) {}
+
+  void run(std::function<void()> task) { tasks.emplace_back(std::move(task)); }
+
+  void cancel() { cancelled = true; }
+  bool isCancelled() const { return cancelled; }
+
+  // Runs the queued tasks. Rethrows the first exception, if any task threw.
+  void wait();
+};
+
+// The order in which to process items of (very) different costs, e.g. the
+// tiles of a DNG, some of which compress much better than the others: the
+// most expensive ones first, ties in their original order. Once the threads
+// run out of those, the cheap ones fill the gaps, so that the threads finish
+// at about the same time. A loop over such an order should have a grain size
+// of 1, and the executor takes care of the rest (both OpenMPExecutor and
+// ThreadPoolExecutor hand the chunks out in order).
+template <typename T, typename Cost>
+std::vector<int> getLargestFirstOrder(const std::vector<T>& items, Cost cost) {
+  std::vector<int> order(items.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&items, &cost](int a, int b) {
+                     return cost(items[a]) > cost(items[b]);
+                   });
+  return order;
+}
+
+// The one that is used unless the caller provides another one.
+// With OpenMP, that is OpenMPExecutor, otherwise ThreadPoolExecutor.
+Executor& getDefaultExecutor();
+
+} // namespace rawspeed
@@ -20,50 +20,18 @@
 
 #pragma once
 
-#include "rawspeedconfig.h"
 #include "ThreadSafetyAnalysis.h"
-
-#ifdef HAVE_OPENMP
-#include <omp.h>
-#endif
+#include <mutex>
 
 namespace rawspeed {
 
 // Defines an annotated interface for mutexes.
 // These methods can be implemented to use any internal mutex implementation.
-#ifdef HAVE_OPENMP
-
+// Not only the OpenMP threads may be decoding (see Executor), so this is a
+// plain std::mutex, regardless of whether OpenMP is used.
 class CAPABILITY("mutex") Mutex final {
-  omp_lock_t mutex;
+  std::mutex mutex;
 
-public:
-  explicit Mutex() { omp_init_lock(&mutex); }
-
-  Mutex(const Mutex&) = delete;
-  Mutex(Mutex&&) = delete;
-  Mutex& operator=(const Mutex&) = delete;
-  Mutex& operator=(Mutex&&) = delete;
-
-  ~Mutex() { omp_destroy_lock(&mutex); }
-
-  // Acquire/lock this mutex exclusively.  Only one thread can have exclusive
-  // access at any one time.  Write operations to guarded data require an
-  // exclusive lock.
-  void Lock() ACQUIRE() { omp_set_lock(&mutex); }
-
-  // Release/unlock an exclusive mutex.
-  void Unlock() RELEASE() { omp_unset_lock(&mutex); }
-
-  // Try to acquire the mutex.  Returns true on success, and false on failure.
-  bool TryLock() TRY_ACQUIRE(true) { return omp_test_lock(&mutex); }
-
-  // For negative capabilities.
-  const Mutex& operator!() const { return *this; }
-};
-
-#else
-
-class CAPABILITY("mutex") Mutex final {
 public:
   explicit Mutex() = default;
 
@@ -77,27 +45,18 @@ public:
   // Acquire/lock this mutex exclusively.  Only one thread can have exclusive
   // access at any one time.  Write operations to guarded data require an
   // exclusive lock.
-  void Lock() const ACQUIRE() {
-    // NOP, since there is no mutex. only here to still check for proper locking
-  }
+  void Lock() ACQUIRE() { mutex.lock(); }
 
   // Release/unlock an exclusive mutex.
-  void Unlock() const RELEASE() {
-    // NOP, since there is no mutex. only here to still check for proper locking
-  }
+  void Unlock() RELEASE() { mutex.unlock(); }
 
   // Try to acquire the mutex.  Returns true on success, and false on failure.
-  bool TryLock() const TRY_ACQUIRE(true) {
-    // NOP, since there is no mutex. only here to still check for proper locking
-    return true;
-  }
+  bool TryLock() TRY_ACQUIRE(true) { return mutex.try_lock(); }
 
   // For negative capabilities.
   const Mutex& operator!() const { return *this; }
 };
 
-#endif
-
 // MutexLocker is an RAII class that acquires a mutex in its constructor, and
 // releases it in its destructor.
 class SCOPED_CAPABILITY MutexLocker final {
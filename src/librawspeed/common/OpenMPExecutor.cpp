@@ -0,0 +1,73 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "rawspeedconfig.h" // for HAVE_OPENMP
+#include "common/OpenMPExecutor.h"
+#include "common/Common.h" // for roundUpDivision, rawspeed_get_number_of...
+#include <algorithm>       // for min
+#include <atomic>          // for atomic
+#include <cassert>         // for assert
+#include <exception>       // for exception_ptr, current_exception, reth...
+#include <functional>      // for function
+
+namespace rawspeed {
+
+int OpenMPExecutor::getConcurrency() const {
+  return numThreads > 0 ? numThreads : rawspeed_get_number_of_processor_cores();
+}
+
+void OpenMPExecutor::parallelFor(int begin, int end, int grainSize,
+                                 int maxThreads,
+                                 const std::function<void(int, int)>& body) {
+  assert(grainSize > 0);
+  if (begin >= end)
+    return;
+
+  const int numChunks = roundUpDivision(end - begin, grainSize);
+
+  std::atomic<bool> failed{false};
+  std::exception_ptr firstException;
+
+#ifdef HAVE_OPENMP
+  const int loopThreads = std::min(maxThreads, getConcurrency());
+#pragma omp parallel for default(none) shared(body, failed, firstException)   \
+    OMPFIRSTPRIVATECLAUSE(begin, end, grainSize, numChunks)                    \
+        num_threads(loopThreads) schedule(dynamic)                             \
+            if (numChunks > 1 && loopThreads > 1)
+#endif
+  for (int chunk = 0; chunk < numChunks; ++chunk) {
+    if (failed)
+      continue;
+    const int chunkBegin = begin + chunk * grainSize;
+    const int chunkEnd = std::min(chunkBegin + grainSize, end);
+    try {
+      body(chunkBegin, chunkEnd);
+    } catch (...) {
+      // Propagate the exception out of OpenMP magic.
+      if (!failed.exchange(true))
+        firstException = std::current_exception();
+    }
+  }
+
+  if (firstException)
+    std::rethrow_exception(firstException);
+}
+
+} // namespace rawspeed
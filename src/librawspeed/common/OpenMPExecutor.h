@@ -0,0 +1,47 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "common/Executor.h" // for Executor
+#include <functional>        // for function
+
+namespace rawspeed {
+
+// Runs the loops as OpenMP parallel regions, with dynamic scheduling.
+// Without OpenMP, runs everything serially, in the calling thread.
+// Nested loops get more threads only if nested parallelism is enabled
+// (OMP_MAX_ACTIVE_LEVELS), and then those are new threads, on top of the ones
+// that are already busy with the outer loop.
+class OpenMPExecutor final : public Executor {
+  // If not positive, rawspeed_get_number_of_processor_cores() at each loop.
+  int numThreads;
+
+public:
+  explicit OpenMPExecutor(int numThreads_ = 0) : numThreads(numThreads_) {}
+
+  int getConcurrency() const override;
+
+  using Executor::parallelFor;
+  void parallelFor(int begin, int end, int grainSize, int maxThreads,
+                   const std::function<void(int, int)>& body) override;
+};
+
+} // namespace rawspeed
@@ -0,0 +1,178 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "rawspeedconfig.h" // for WITH_SSE2
+#include <array>            // for array
+#include <cassert>          // for assert
+#include <cstddef>          // for size_t
+#include <cstdint>          // for int16_t, uint16_t, int32_t
+#include <type_traits>      // for integral_constant, true_type, false_type
+
+#ifdef WITH_SSE2
+#include <emmintrin.h> // for __m128i, _mm_add_epi16, _mm_slli_si128, ...
+#endif
+
+namespace rawspeed {
+
+// Reconstructs the values from the differences of N interleaved components,
+// each one predicted from its own previous value (i.e. LJpeg predictor 1):
+//   out[i] = (*pred)[i % N] + in[i % N] + in[i % N + N] + ... + in[i]
+// with the arithmetic of T (so it wraps around for uint16_t).
+// *pred is then updated with the last values of each component.
+// The count must be a multiple of N.
+template <int N, typename T>
+inline void interleavedPrefixSumScalar(T* out, const int16_t* in, size_t count,
+                                       std::array<T, N>* pred) {
+  assert(count % N == 0);
+  for (size_t i = 0; i < count; i += N) {
+    for (int c = 0; c < N; ++c)
+      out[i + c] = (*pred)[c] = T((*pred)[c] + in[i + c]);
+  }
+}
+
+#ifdef WITH_SSE2
+
+namespace impl {
+
+// Sets every lane to the value of the last lane of the same component.
+template <int N> inline __m128i broadcastLastComponents16(__m128i v);
+template <> inline __m128i broadcastLastComponents16<1>(__m128i v) {
+  v = _mm_shufflehi_epi16(v, 0xFF);
+  return _mm_unpackhi_epi64(v, v);
+}
+template <> inline __m128i broadcastLastComponents16<2>(__m128i v) {
+  return _mm_shuffle_epi32(v, 0xFF);
+}
+template <> inline __m128i broadcastLastComponents16<4>(__m128i v) {
+  return _mm_shuffle_epi32(v, 0xEE);
+}
+
+template <int N> inline __m128i broadcastLastComponents32(__m128i v);
+template <> inline __m128i broadcastLastComponents32<1>(__m128i v) {
+  return _mm_shuffle_epi32(v, 0xFF);
+}
+template <> inline __m128i broadcastLastComponents32<2>(__m128i v) {
+  return _mm_shuffle_epi32(v, 0xEE);
+}
+template <> inline __m128i broadcastLastComponents32<4>(__m128i v) {
+  return v;
+}
+
+template <int N>
+inline void interleavedPrefixSumSSE2(uint16_t* out, const int16_t* in,
+                                     size_t count,
+                                     std::array<uint16_t, N>* pred) {
+  constexpr int Lanes = sizeof(__m128i) / sizeof(uint16_t);
+
+  alignas(16) std::array<uint16_t, Lanes> init;
+  for (int i = 0; i < Lanes; ++i)
+    init[i] = (*pred)[i % N];
+  __m128i carry = _mm_load_si128(reinterpret_cast<const __m128i*>(&init));
+
+  size_t i = 0;
+  for (; i + Lanes <= count; i += Lanes) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&in[i]));
+    // The log-step prefix sum, only within each component.
+    v = _mm_add_epi16(v, _mm_slli_si128(v, 2 * N));
+    if (4 * N < 16)
+      v = _mm_add_epi16(v, _mm_slli_si128(v, 4 * N));
+    if (8 * N < 16)
+      v = _mm_add_epi16(v, _mm_slli_si128(v, 8 * N));
+    v = _mm_add_epi16(v, carry);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), v);
+    carry = impl::broadcastLastComponents16<N>(v);
+  }
+
+  alignas(16) std::array<uint16_t, Lanes> last;
+  _mm_store_si128(reinterpret_cast<__m128i*>(&last), carry);
+  for (int c = 0; c < N; ++c)
+    (*pred)[c] = last[c];
+
+  interleavedPrefixSumScalar<N>(out + i, in + i, count - i, pred);
+}
+
+template <int N>
+inline void interleavedPrefixSumSSE2(int32_t* out, const int16_t* in,
+                                     size_t count,
+                                     std::array<int32_t, N>* pred) {
+  constexpr int Lanes = sizeof(__m128i) / sizeof(int32_t);
+
+  alignas(16) std::array<int32_t, Lanes> init;
+  for (int i = 0; i < Lanes; ++i)
+    init[i] = (*pred)[i % N];
+  __m128i carry = _mm_load_si128(reinterpret_cast<const __m128i*>(&init));
+
+  size_t i = 0;
+  for (; i + Lanes <= count; i += Lanes) {
+    // Sign-extend the differences to 32 bits.
+    __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&in[i]));
+    v = _mm_srai_epi32(_mm_unpacklo_epi16(v, v), 16);
+    // The log-step prefix sum, only within each component.
+    if (4 * N < 16)
+      v = _mm_add_epi32(v, _mm_slli_si128(v, 4 * N));
+    if (8 * N < 16)
+      v = _mm_add_epi32(v, _mm_slli_si128(v, 8 * N));
+    v = _mm_add_epi32(v, carry);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&out[i]), v);
+    carry = impl::broadcastLastComponents32<N>(v);
+  }
+
+  alignas(16) std::array<int32_t, Lanes> last;
+  _mm_store_si128(reinterpret_cast<__m128i*>(&last), carry);
+  for (int c = 0; c < N; ++c)
+    (*pred)[c] = last[c];
+
+  interleavedPrefixSumScalar<N>(out + i, in + i, count - i, pred);
+}
+
+template <int N, typename T>
+inline void interleavedPrefixSum(T* out, const int16_t* in, size_t count,
+                                 std::array<T, N>* pred,
+                                 std::true_type /*vectorizable*/) {
+  interleavedPrefixSumSSE2<N>(out, in, count, pred);
+}
+
+template <int N, typename T>
+inline void interleavedPrefixSum(T* out, const int16_t* in, size_t count,
+                                 std::array<T, N>* pred,
+                                 std::false_type /*vectorizable*/) {
+  interleavedPrefixSumScalar<N>(out, in, count, pred);
+}
+
+} // namespace impl
+
+#endif
+
+template <int N, typename T>
+inline void interleavedPrefixSum(T* out, const int16_t* in, size_t count,
+                                 std::array<T, N>* pred) {
+  static_assert(N >= 1 && N <= 4, "unexpected component count");
+#ifdef WITH_SSE2
+  // With 3 components, they do not line up with the vector lanes.
+  impl::interleavedPrefixSum<N>(out, in, count, pred,
+                                std::integral_constant<bool, N != 3>());
+#else
+  interleavedPrefixSumScalar<N>(out, in, count, pred);
+#endif
+}
+
+} // namespace rawspeed
@@ -21,7 +21,9 @@
 #include "rawspeedconfig.h"
 #include "common/RawImage.h"
 #include "MemorySanitizer.h"              // for MSan
+#include "common/Executor.h"              // for Executor, getDefaultExecutor
 #include "common/Memory.h"                // for alignedFree, alignedMalloc...
+#include "common/RawImagePool.h"          // for RawImagePool
 #include "decoders/RawDecoderException.h" // for ThrowRDE, RawDecoderException
 #include "io/IOException.h"               // for IOException
 #include "parsers/TiffParserException.h"  // for TiffParserException
@@ -58,6 +60,10 @@ RawImageData::RawImageData(const iPoint2D& _dim, int _bpc, int _cpp)
   createData();
 }
 
+Executor& RawImageData::getExecutor() const {
+  return executor ? *executor : getDefaultExecutor();
+}
+
 RawImageData::~RawImageData() {
   assert(dataRefCount == 0);
   mOffset = iPoint2D(0, 0);
@@ -68,6 +74,7 @@ RawImageData::~RawImageData() {
 
 void RawImageData::createData() {
   static constexpr const auto alignment = 16;
+  static_assert(alignment == RawImagePool::alignment, "");
 
   if (dim.x > 65535 || dim.y > 65535)
     ThrowRDE("Dimensions too large for allocation.");
@@ -94,7 +101,10 @@ void RawImageData::createData() {
   assert(padding > 0);
 #endif
 
-  data = alignedMallocArray<uint8_t, alignment>(dim.y, pitch);
+  if (pool)
+    data = pool->acquire(dim.y, pitch);
+  else
+    data = alignedMallocArray<uint8_t, alignment>(dim.y, pitch);
 
   if (!data)
     ThrowRDE("Memory Allocation failed.");
@@ -184,7 +194,9 @@ void RawImageData::checkMemIsInitialized() {
 #endif
 
 void RawImageData::destroyData() {
-  if (data)
+  if (data && pool)
+    pool->release(data, uncropped_dim.y, pitch);
+  else if (data)
     alignedFree(data);
   if (mBadPixelMap)
     alignedFree(mBadPixelMap);
@@ -389,20 +401,11 @@ void RawImageData::startWorker(const RawImageWorker::RawImageWorkerTask task,
     return h;
   }();
 
-  const int threads = rawspeed_get_number_of_processor_cores();
-  const int y_per_thread = (height + threads - 1) / threads;
-
-#ifdef HAVE_OPENMP
-#pragma omp parallel for default(none)                                         \
-    OMPFIRSTPRIVATECLAUSE(threads, y_per_thread, height, task)                 \
-        num_threads(threads) schedule(static)
-#endif
-  for (int i = 0; i < threads; i++) {
-    int y_offset = std::min(i * y_per_thread, height);
-    int y_end = std::min((i + 1) * y_per_thread, height);
-
-    RawImageWorker worker(this, task, y_offset, y_end);
-  }
+  Executor& workers = getExecutor();
+  workers.parallelFor(0, height, workers.getGrainSize(height),
+                      [this, task](int y_offset, int y_end) {
+                        RawImageWorker worker(this, task, y_offset, y_end);
+                      });
 }
 
 void RawImageData::fixBadPixelsThread(int start_y, int end_y) {
@@ -40,10 +40,14 @@
 
 namespace rawspeed {
 
+class Executor;
+
 class RawImage;
 
 class RawImageData;
 
+class RawImagePool;
+
 enum RawImageType { TYPE_USHORT16, TYPE_FLOAT32 };
 
 class RawImageWorker {
@@ -131,6 +135,15 @@ public:
   void setTable(const std::vector<uint16_t>& table_, bool dither);
   void setTable(std::unique_ptr<TableLookUp> t);
 
+  // What runs the parallel parts of the decoding and processing of the image.
+  // Not owned. Unless set, that is the default one, see getDefaultExecutor().
+  void setExecutor(Executor* executor_) { executor = executor_; }
+  Executor& getExecutor() const;
+
+  // Where createData() gets the buffer from, and destroyData() returns it to.
+  // Not owned, must outlive the image. Unless set, it is allocated and freed.
+  void setPool(RawImagePool* pool_) { pool = pool_; }
+
   bool isAllocated() {return !!data;}
   void createBadPixelMap();
   iPoint2D dim;
@@ -179,6 +192,8 @@ protected:
   iPoint2D mOffset;
   iPoint2D uncropped_dim;
   std::unique_ptr<TableLookUp> table;
+  Executor* executor = nullptr;
+  RawImagePool* pool = nullptr;
   Mutex mymutex;
 };
 
@@ -0,0 +1,139 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#include "common/RawImagePool.h"
+#include "AddressSanitizer.h" // for ASan
+#include "MemorySanitizer.h"  // for MSan
+#include "common/CpuSet.h"    // for getNumaNodeOfCurrentThread
+#include "common/Memory.h"    // for alignedFree, alignedMallocArray
+#include <algorithm>          // for find_if
+#include <chrono>             // for steady_clock
+#include <cstdint>            // for uint8_t, SIZE_MAX
+#include <iterator>           // for next
+#include <mutex>              // for mutex, lock_guard
+
+namespace rawspeed {
+
+RawImagePool::RawImagePool(size_t maxIdleBytes_)
+    : maxIdleBytes(maxIdleBytes_) {}
+
+RawImagePool::~RawImagePool() { releaseIdle(); }
+
+void RawImagePool::evictOldest() {
+  const IdleBuffer oldest = idle.front();
+  idle.erase(idle.begin());
+  stats.idleBuffers--;
+  stats.idleBytes -= oldest.size;
+  stats.evictions++;
+
+  ASan::UnPoisonMemoryRegion(oldest.buffer, oldest.size);
+  alignedFree(oldest.buffer);
+}
+
+uint8_t* RawImagePool::acquire(size_t height, size_t pitch) {
+  if (pitch && height > SIZE_MAX / pitch)
+    return nullptr;
+  const size_t size = height * pitch;
+
+  const int numaNode = getNumaNodeOfCurrentThread();
+
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    // The most recently used one is the most likely to still be in the cache.
+    const auto it = std::find_if(idle.rbegin(), idle.rend(),
+                                 [size, numaNode](const IdleBuffer& buffer) {
+                                   return buffer.size == size &&
+                                          buffer.numaNode == numaNode;
+                                 });
+    if (it != idle.rend()) {
+      uint8_t* const buffer = it->buffer;
+      idle.erase(std::next(it).base());
+      stats.idleBuffers--;
+      stats.idleBytes -= size;
+      stats.hits++;
+      numaNodes[buffer] = numaNode;
+
+      // Just like a newly allocated one, so e.g. the previous image's pixels
+      // do not pass for initialized ones.
+      ASan::UnPoisonMemoryRegion(buffer, size);
+      MSan::Allocated(buffer, size);
+      return buffer;
+    }
+    stats.misses++;
+  }
+
+  uint8_t* const buffer = alignedMallocArray<uint8_t, alignment>(height, pitch);
+  if (buffer) {
+    std::lock_guard<std::mutex> guard(mutex);
+    numaNodes[buffer] = numaNode;
+  }
+  return buffer;
+}
+
+void RawImagePool::release(uint8_t* buffer, size_t height, size_t pitch) {
+  if (!buffer)
+    return;
+
+  const size_t size = height * pitch;
+
+  std::lock_guard<std::mutex> guard(mutex);
+
+  // Not acquire()'d, so it is not known where it is, treat it as if it was
+  // acquire()'d on no particular node.
+  int numaNode = -1;
+  const auto it = numaNodes.find(buffer);
+  if (it != numaNodes.end()) {
+    numaNode = it->second;
+    numaNodes.erase(it);
+  }
+
+  if (size > maxIdleBytes) {
+    stats.evictions++;
+    alignedFree(buffer);
+    return;
+  }
+
+  // Nothing may touch it until it is acquire()'d again.
+  ASan::PoisonMemoryRegion(buffer, size);
+
+  idle.push_back({buffer, size, numaNode, std::chrono::steady_clock::now()});
+  stats.idleBuffers++;
+  stats.idleBytes += size;
+
+  while (stats.idleBytes > maxIdleBytes)
+    evictOldest();
+}
+
+void RawImagePool::releaseIdle(
+    std::chrono::steady_clock::duration minIdleTime) {
+  const auto now = std::chrono::steady_clock::now();
+
+  std::lock_guard<std::mutex> guard(mutex);
+  while (!idle.empty() && now - idle.front().since >= minIdleTime)
+    evictOldest();
+}
+
+RawImagePool::Stats RawImagePool::getStats() {
+  std::lock_guard<std::mutex> guard(mutex);
+  return stats;
+}
+
+} // namespace rawspeed
@@ -0,0 +1,102 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#pragma once
+
+#include <chrono>        // for steady_clock
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint8_t, uint64_t
+#include <mutex>         // for mutex
+#include <unordered_map> // for unordered_map
+#include <vector>        // for vector
+
+namespace rawspeed {
+
+// Recycles the pixel buffers of the images. When decoding many raws of the
+// same camera one after another, each one would otherwise allocate a buffer
+// of the very same size (and have the kernel map and zero it, page by page,
+// as the decoder first touches it), only to free it again right after.
+// Once an image is destroyed, its buffer is kept around (idle), and is handed
+// out to the next image that needs a buffer of the same pitch * height, and
+// that is acquire()'d on the same NUMA node (see getNumaNodeOfCurrentThread()),
+// since the memory stays on the node of the thread that first touched it.
+// Thread-safe. Must outlive the images that use it.
+class RawImagePool final {
+public:
+  // What alignedMalloc() the buffers are (to be) allocated with.
+  static constexpr size_t alignment = 16;
+
+  struct Stats {
+    uint64_t hits = 0;      // Idle buffers that were reused.
+    uint64_t misses = 0;    // Buffers that had to be allocated.
+    uint64_t evictions = 0; // Idle buffers that were freed.
+    size_t idleBuffers = 0;
+    size_t idleBytes = 0;
+  };
+
+  // Keeps at most maxIdleBytes in idle buffers. If there would be more, the
+  // ones that were idle for the longest are freed first.
+  explicit RawImagePool(size_t maxIdleBytes_);
+
+  RawImagePool(const RawImagePool&) = delete;
+  RawImagePool(RawImagePool&&) = delete;
+  RawImagePool& operator=(const RawImagePool&) = delete;
+  RawImagePool& operator=(RawImagePool&&) = delete;
+
+  ~RawImagePool();
+
+  // A buffer for height rows of pitch bytes. nullptr if it could not be
+  // allocated. Its contents are unspecified, and are to be treated as not
+  // initialized (as far as the sanitizers are concerned, they are not).
+  uint8_t* acquire(size_t height, size_t pitch);
+
+  // Takes the buffer back. It does not need to have been acquire()'d, but it
+  // must have been allocated with alignedMallocArray<uint8_t, alignment>().
+  void release(uint8_t* buffer, size_t height, size_t pitch);
+
+  // Frees the buffers that have been idle for at least that long,
+  // e.g. once the batch of raws is done, or periodically.
+  void releaseIdle(std::chrono::steady_clock::duration minIdleTime =
+                       std::chrono::steady_clock::duration::zero());
+
+  Stats getStats();
+
+private:
+  struct IdleBuffer {
+    uint8_t* buffer;
+    size_t size;
+    int numaNode;
+    std::chrono::steady_clock::time_point since;
+  };
+
+  const size_t maxIdleBytes;
+
+  std::mutex mutex;             // For everything below.
+  std::vector<IdleBuffer> idle; // The longest idle ones first.
+  Stats stats;
+
+  // Of the acquire()'d ones.
+  std::unordered_map<const uint8_t*, int> numaNodes;
+
+  void evictOldest();
+};
+
+} // namespace rawspeed
@@ -0,0 +1,168 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "common/ThreadPoolExecutor.h"
+#include "common/Common.h"  // for roundUpDivision
+#include <algorithm>        // for min, find, find_if, max
+#include <atomic>           // for atomic
+#include <cassert>          // for assert
+#include <exception>        // for exception_ptr, current_exception, reth...
+#include <functional>       // for function
+#include <initializer_list> // for initializer_list
+#include <mutex>            // for mutex, lock_guard, unique_lock
+#include <utility>          // for move
+#include <vector>           // for vector
+
+namespace rawspeed {
+
+class ThreadPoolExecutor::Loop final {
+  const std::function<void(int, int)>& body;
+  const int begin;
+  const int end;
+  const int grainSize;
+  const int numChunks;
+  const int maxParticipants;
+
+  std::atomic<int> nextChunk{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr firstException;
+
+public:
+  // Guarded by the mutex of the pool.
+  int numParticipants = 1; // The thread that runs the loop is the first one.
+  int numHelpers = 0;      // The pool threads that are working on it now.
+
+  Loop(const std::function<void(int, int)>& body_, int begin_, int end_,
+       int grainSize_, int numChunks_, int maxParticipants_)
+      : body(body_), begin(begin_), end(end_), grainSize(grainSize_),
+        numChunks(numChunks_), maxParticipants(maxParticipants_) {}
+
+  // Would one more participant have anything to do?
+  bool wantsHelp() const {
+    return numParticipants < maxParticipants && nextChunk < numChunks &&
+           !failed;
+  }
+
+  void participate() noexcept {
+    while (!failed) {
+      const int chunk = nextChunk++;
+      if (chunk >= numChunks)
+        break;
+
+      const int chunkBegin = begin + chunk * grainSize;
+      const int chunkEnd = std::min(chunkBegin + grainSize, end);
+      try {
+        body(chunkBegin, chunkEnd);
+      } catch (...) {
+        if (!failed.exchange(true))
+          firstException = std::current_exception();
+      }
+    }
+  }
+
+  void rethrowIfFailed() const {
+    if (firstException)
+      std::rethrow_exception(firstException);
+  }
+};
+
+ThreadPoolExecutor::ThreadPoolExecutor(int numThreads, CpuSet cpus_)
+    : cpus(std::move(cpus_)) {
+  numThreads = std::max(numThreads, 1);
+  threads.reserve(numThreads - 1);
+  for (int i = 1; i < numThreads; ++i)
+    threads.emplace_back(&ThreadPoolExecutor::threadMain, this);
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    stopping = true;
+  }
+  loopStarted.notify_all();
+  for (std::thread& thread : threads)
+    thread.join();
+}
+
+int ThreadPoolExecutor::getConcurrency() const { return threads.size() + 1; }
+
+void ThreadPoolExecutor::threadMain() {
+  if (!cpus.empty())
+    cpus.applyToCurrentThread();
+
+  std::unique_lock<std::mutex> lock(mutex);
+  while (!stopping) {
+    const auto it = std::find_if(loops.begin(), loops.end(),
+                                 [](const Loop* l) { return l->wantsHelp(); });
+    if (it == loops.end()) {
+      loopStarted.wait(lock);
+      continue;
+    }
+
+    Loop* const current = *it;
+    current->numParticipants++;
+    current->numHelpers++;
+
+    lock.unlock();
+    current->participate();
+    lock.lock();
+
+    if (--current->numHelpers == 0)
+      helperFinished.notify_all();
+  }
+}
+
+void ThreadPoolExecutor::parallelFor(
+    int begin, int end, int grainSize, int maxThreads,
+    const std::function<void(int, int)>& body) {
+  assert(grainSize > 0);
+  if (begin >= end)
+    return;
+
+  const int numChunks = roundUpDivision(end - begin, grainSize);
+  const int maxParticipants =
+      std::min({maxThreads, getConcurrency(), numChunks});
+
+  // Nothing to parallelize.
+  if (maxParticipants <= 1) {
+    for (int chunkBegin = begin; chunkBegin < end; chunkBegin += grainSize)
+      body(chunkBegin, std::min(chunkBegin + grainSize, end));
+    return;
+  }
+
+  Loop current(body, begin, end, grainSize, numChunks, maxParticipants);
+  {
+    std::lock_guard<std::mutex> guard(mutex);
+    loops.emplace_back(&current);
+  }
+  loopStarted.notify_all();
+
+  current.participate();
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    loops.erase(std::find(loops.begin(), loops.end(), &current));
+    helperFinished.wait(lock, [&current]() { return current.numHelpers == 0; });
+  }
+
+  current.rethrowIfFailed();
+}
+
+} // namespace rawspeed
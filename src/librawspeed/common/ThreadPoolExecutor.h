@@ -0,0 +1,76 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "common/CpuSet.h"    // for CpuSet
+#include "common/Executor.h"  // for Executor
+#include <condition_variable> // for condition_variable
+#include <functional>         // for function
+#include <mutex>              // for mutex
+#include <thread>             // for thread
+#include <vector>             // for vector
+
+namespace rawspeed {
+
+// A fixed set of std::thread's. The thread that calls parallelFor() works on
+// the loop too, so numThreads includes it, and only numThreads - 1 threads
+// are actually started.
+// Several loops may be running at the same time, be it because they were
+// started from different threads, or because they are nested. An idle thread
+// joins the oldest running loop that still wants (maxThreads) more threads.
+// The threads of a loop take its chunks one at a time, in order, from a
+// shared cursor. So the chunks start in the order they are in, e.g. the
+// most expensive ones first (see getLargestFirstOrder()), and the threads
+// that got the cheap chunks simply take more of them.
+// If a CpuSet is given, the started threads are restricted to those CPUs.
+// (The threads that call parallelFor() are not, they are not ours.)
+class ThreadPoolExecutor final : public Executor {
+  class Loop;
+
+  const CpuSet cpus;
+  std::vector<std::thread> threads;
+
+  std::mutex mutex; // For everything below.
+  std::condition_variable loopStarted;
+  std::condition_variable helperFinished;
+  std::vector<Loop*> loops; // The running loops, oldest first.
+  bool stopping = false;
+
+  void threadMain();
+
+public:
+  explicit ThreadPoolExecutor(int numThreads, CpuSet cpus_ = CpuSet());
+
+  ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+  ThreadPoolExecutor(ThreadPoolExecutor&&) = delete;
+  ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+  ThreadPoolExecutor& operator=(ThreadPoolExecutor&&) = delete;
+
+  ~ThreadPoolExecutor() override;
+
+  int getConcurrency() const override;
+
+  using Executor::parallelFor;
+  void parallelFor(int begin, int end, int grainSize, int maxThreads,
+                   const std::function<void(int, int)>& body) override;
+};
+
+} // namespace rawspeed
@@ -24,6 +24,7 @@
 #include "common/Point.h"                           // for iPoint2D
 #include "common/RawspeedException.h"               // for RawspeedException
 #include "decoders/RawDecoderException.h"           // for ThrowRDE
+#include "decompressors/DecodeCheckpointIndex.h"    // for DecodeCheckpoint...
 #include "decompressors/SonyArw1Decompressor.h"     // for SonyArw1Decompre...
 #include "decompressors/SonyArw2Decompressor.h"     // for SonyArw2Decompre...
 #include "decompressors/UncompressedDecompressor.h" // for UncompressedDeco...
@@ -106,6 +107,61 @@ RawImage ArwDecoder::decodeSRF(const TiffIFD* raw) {
   return mRaw;
 }
 
+uint32_t ArwDecoder::getBitsPerPixel(const TiffIFD* raw) const {
+  uint32_t bitPerPixel = raw->getEntry(BITSPERSAMPLE)->getU32();
+
+  switch (bitPerPixel) {
+  case 8:
+  case 12:
+  case 14:
+    break;
+  default:
+    ThrowRDE("Unexpected bits per pixel: %u", bitPerPixel);
+  }
+
+  // Sony E-550 marks compressed 8bpp ARW with 12 bit per pixel
+  // this makes the compression detect it as a ARW v1.
+  // This camera has however another MAKER entry, so we MAY be able
+  // to detect it this way in the future.
+  const vector<const TiffIFD*> data = mRootIFD->getIFDsWithTag(MAKE);
+  if (data.size() > 1) {
+    for (auto &i : data) {
+      string make = i->getEntry(MAKE)->getString();
+      /* Check for maker "SONY" without spaces */
+      if (make == "SONY")
+        bitPerPixel = 8;
+    }
+  }
+
+  return bitPerPixel;
+}
+
+bool ArwDecoder::isArw1(const TiffIFD* raw, uint32_t bitPerPixel) {
+  const uint32_t width = raw->getEntry(IMAGEWIDTH)->getU32();
+  const uint32_t height = raw->getEntry(IMAGELENGTH)->getU32();
+  const uint32_t count = raw->getEntry(STRIPBYTECOUNTS)->getU32();
+  return uint64_t(count) * 8 != width * height * bitPerPixel;
+}
+
+bool ArwDecoder::hasParallelDecompression() {
+  const vector<const TiffIFD*> data = mRootIFD->getIFDsWithTag(STRIPOFFSETS);
+
+  if (!data.empty()) {
+    // Uncompressed.
+    if (data[0]->getEntry(COMPRESSION)->getU32() != 32767)
+      return false;
+    // ARW2, its rows are decoded in parallel.
+    if (!isArw1(data[0], getBitsPerPixel(data[0])))
+      return true;
+  } else if (hints.has("srf_format"))
+    return false;
+
+  // ARW1 (e.g. the A100 one) is a single stream, unless where it is at every
+  // few columns is already known.
+  using Format = DecodeCheckpointIndex::Format;
+  return checkpointIndex && checkpointIndex->isRecordedBy(Format::SONY_ARW1);
+}
+
 RawImage ArwDecoder::decodeRawInternal() {
   const TiffIFD* raw = nullptr;
   vector<const TiffIFD*> data = mRootIFD->getIFDsWithTag(STRIPOFFSETS);
@@ -126,6 +182,7 @@ RawImage ArwDecoder::decodeRawInternal() {
 
       ByteStream input(DataBuffer(mFile->getSubView(off), Endianness::little));
       SonyArw1Decompressor a(mRaw);
+      a.setCheckpointIndex(checkpointIndex);
       mRaw->createData();
       a.decompress(input);
 
@@ -161,36 +218,13 @@ RawImage ArwDecoder::decodeRawInternal() {
   }
   uint32_t width = raw->getEntry(IMAGEWIDTH)->getU32();
   uint32_t height = raw->getEntry(IMAGELENGTH)->getU32();
-  uint32_t bitPerPixel = raw->getEntry(BITSPERSAMPLE)->getU32();
-
-  switch (bitPerPixel) {
-  case 8:
-  case 12:
-  case 14:
-    break;
-  default:
-    ThrowRDE("Unexpected bits per pixel: %u", bitPerPixel);
-  }
-
-  // Sony E-550 marks compressed 8bpp ARW with 12 bit per pixel
-  // this makes the compression detect it as a ARW v1.
-  // This camera has however another MAKER entry, so we MAY be able
-  // to detect it this way in the future.
-  data = mRootIFD->getIFDsWithTag(MAKE);
-  if (data.size() > 1) {
-    for (auto &i : data) {
-      string make = i->getEntry(MAKE)->getString();
-      /* Check for maker "SONY" without spaces */
-      if (make == "SONY")
-        bitPerPixel = 8;
-    }
-  }
+  const uint32_t bitPerPixel = getBitsPerPixel(raw);
 
   if (width == 0 || height == 0 || height % 2 != 0 || width > 9600 ||
       height > 6376)
     ThrowRDE("Unexpected image dimensions found: (%u; %u)", width, height);
 
-  bool arw1 = uint64_t(counts->getU32()) * 8 != width * height * bitPerPixel;
+  const bool arw1 = isArw1(raw, bitPerPixel);
   if (arw1)
     height += 8;
 
@@ -225,6 +259,7 @@ RawImage ArwDecoder::decodeRawInternal() {
 
   if (arw1) {
     SonyArw1Decompressor a(mRaw);
+    a.setCheckpointIndex(checkpointIndex);
     mRaw->createData();
     a.decompress(input);
   } else
@@ -44,12 +44,15 @@ public:
 
   RawImage decodeRawInternal() override;
   void decodeMetaDataInternal(const CameraMetaData* meta) override;
+  bool hasParallelDecompression() override;
 
 protected:
   void ParseA100WB();
 
   int getDecoderVersion() const override { return 1; }
   RawImage decodeSRF(const TiffIFD* raw);
+  uint32_t getBitsPerPixel(const TiffIFD* raw) const;
+  static bool isArw1(const TiffIFD* raw, uint32_t bitPerPixel);
   void DecodeARW2(const ByteStream& input, uint32_t w, uint32_t h,
                   uint32_t bpp);
   void DecodeUncompressed(const TiffIFD* raw);
@@ -0,0 +1,166 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decoders/BatchDecoder.h"
+#include "common/Executor.h"          // for Executor, LimitedExecutor, get...
+#include "common/Point.h"             // for iPoint2D
+#include "common/RawspeedException.h" // for RawspeedException
+#include "decoders/RawDecoder.h"      // for RawDecoder
+#include "io/BatchFileReader.h"       // for BatchFileReader, BatchFileRead...
+#include "io/Buffer.h"                // for Buffer
+#include "parsers/RawParser.h"        // for RawParser
+#include <algorithm>                  // for max
+#include <atomic>                     // for atomic
+#include <chrono>                     // for steady_clock, duration
+#include <exception>                  // for current_exception
+#include <functional>                 // for function
+#include <memory>                     // for unique_ptr
+#include <mutex>                      // for mutex, lock_guard
+#include <string>                     // for string
+#include <utility>                    // for move
+
+using std::chrono::steady_clock;
+
+namespace rawspeed {
+
+namespace {
+
+double toSeconds(steady_clock::duration duration) {
+  return std::chrono::duration<double>(duration).count();
+}
+
+// Decodes one file, with at most the given number of threads.
+void decodeFile(BatchFileReader::File* file, const CameraMetaData* metaData,
+                Executor* executor, int numCompeting,
+                const std::function<void(const std::string&, RawDecoder*)>&
+                    configureDecoder,
+                BatchDecoder::Result* result) {
+  const auto start = steady_clock::now();
+
+  try {
+    const std::unique_ptr<const Buffer> buffer = file->release();
+    result->fileSize = buffer->getSize();
+
+    RawParser parser(buffer.get());
+    const std::unique_ptr<RawDecoder> decoder = parser.getDecoder(metaData);
+    if (configureDecoder)
+      configureDecoder(result->fileName, decoder.get());
+
+    decoder->checkSupport(metaData);
+
+    result->threads = BatchDecoder::getThreadBudget(
+        executor->getConcurrency(), decoder->hasParallelDecompression(),
+        numCompeting);
+    LimitedExecutor budget(executor, result->threads);
+    decoder->executor = &budget;
+
+    decoder->decodeRaw();
+    decoder->decodeMetaData(metaData);
+
+    // The budget is gone once we return, the image is not.
+    decoder->mRaw->setExecutor(executor);
+    result->image = decoder->mRaw;
+  } catch (const RawspeedException&) {
+    result->error = std::current_exception();
+  }
+
+  result->decodeTime = steady_clock::now() - start;
+}
+
+} // namespace
+
+double BatchDecoder::Stats::getMegabytesPerSecond() const {
+  const double seconds = toSeconds(wallTime);
+  return seconds > 0 ? bytes / 1.0E6 / seconds : 0;
+}
+
+double BatchDecoder::Stats::getMegapixelsPerSecond() const {
+  const double seconds = toSeconds(wallTime);
+  return seconds > 0 ? pixels / 1.0E6 / seconds : 0;
+}
+
+BatchDecoder::BatchDecoder(const CameraMetaData* metaData_,
+                           Executor* executor_)
+    : metaData(metaData_),
+      executor(executor_ ? executor_ : &getDefaultExecutor()) {}
+
+int BatchDecoder::getThreadBudget(int concurrency, bool parallelDecompression,
+                                  int numCompeting) {
+  // A serial stream would not make use of any more threads anyway.
+  if (!parallelDecompression)
+    return 1;
+  return std::max(1, concurrency / std::max(1, numCompeting));
+}
+
+BatchDecoder::Stats BatchDecoder::decode(BatchFileReader* reader,
+                                         const Callback& callback) {
+  const auto start = steady_clock::now();
+
+  const int numLanes = executor->getConcurrency();
+
+  std::atomic<int> numRunning{0};
+  std::atomic<bool> stopped{false};
+
+  std::mutex statsMutex;
+  Stats stats;
+
+  // Each lane decodes the files one after another, until there are none left.
+  // Once a lane is done, its thread is free to help the remaining decodes.
+  executor->parallelFor(
+      0, numLanes, /*grainSize=*/1,
+      [this, reader, &callback, &numRunning, &stopped, &statsMutex,
+       &stats](int /*laneBegin*/, int /*laneEnd*/) {
+        for (BatchFileReader::File file; !stopped && reader->next(&file);) {
+          const int numCompeting =
+              ++numRunning + static_cast<int>(reader->getNumRemaining());
+
+          Result result;
+          result.fileName = file.fileName;
+          decodeFile(&file, metaData, executor, numCompeting,
+                     configureDecoder, &result);
+
+          {
+            std::lock_guard<std::mutex> guard(statsMutex);
+            if (result.error) {
+              stats.numFailed++;
+            } else {
+              stats.numDecoded++;
+              stats.bytes += result.fileSize;
+              stats.pixels += result.image->dim.area();
+            }
+            stats.decodeTime += result.decodeTime;
+          }
+
+          try {
+            callback(std::move(result));
+          } catch (...) {
+            stopped = true;
+            throw;
+          }
+
+          --numRunning;
+        }
+      });
+
+  stats.wallTime = steady_clock::now() - start;
+  return stats;
+}
+
+} // namespace rawspeed
@@ -0,0 +1,101 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "common/RawImage.h" // for RawImage
+#include <chrono>            // for steady_clock
+#include <cstddef>           // for size_t
+#include <cstdint>           // for uint64_t
+#include <exception>         // for exception_ptr
+#include <functional>        // for function
+#include <string>            // for string
+
+namespace rawspeed {
+
+class BatchFileReader;
+
+class CameraMetaData;
+
+class Executor;
+
+class RawDecoder;
+
+// Decodes many raws, several of them at once, and each one of them possibly
+// with several threads, all on one executor, so the two kinds of parallelism
+// do not oversubscribe the machine.
+// Each decode is given a budget of threads (see getThreadBudget()): one, if
+// the format is a serial stream, else a share of the executor that depends on
+// how many other decodes are running or are still queued. So while there are
+// plenty of files, each one is decoded by one thread, and only at the tail of
+// the batch the remaining (parallelizable) decodes take over the idle threads.
+// NOTE: with OpenMPExecutor, the nested loops run serially, so there the batch
+// is only parallelized across the files.
+class BatchDecoder final {
+public:
+  struct Result {
+    std::string fileName;
+    size_t fileSize = 0;
+    RawImage image = RawImage::create(); // Without data, unless decoded.
+    std::exception_ptr error;            // If it could not be decoded.
+    int threads = 0;                     // The budget the decode was given.
+    std::chrono::steady_clock::duration decodeTime{0};
+  };
+
+  struct Stats {
+    size_t numDecoded = 0;
+    size_t numFailed = 0;
+    uint64_t bytes = 0;  // Of the decoded files.
+    uint64_t pixels = 0; // Ditto.
+    std::chrono::steady_clock::duration decodeTime{0}; // Summed up.
+    std::chrono::steady_clock::duration wallTime{0};
+
+    double getMegabytesPerSecond() const;
+    double getMegapixelsPerSecond() const;
+  };
+
+  // Called once per file, as soon as its decode is done, so not necessarily
+  // in the input order, and possibly concurrently. If it throws, the files
+  // that were not started yet are skipped, and decode() rethrows.
+  using Callback = std::function<void(Result&& result)>;
+
+  // If set, called for each decoder right after it was created,
+  // e.g. to set its options.
+  std::function<void(const std::string& fileName, RawDecoder* decoder)>
+      configureDecoder;
+
+  // If executor is not set, getDefaultExecutor().
+  explicit BatchDecoder(const CameraMetaData* metaData_,
+                        Executor* executor_ = nullptr);
+
+  // Decodes all the files of the reader, and returns once all are done.
+  Stats decode(BatchFileReader* reader, const Callback& callback);
+
+  // How many threads to give to a decode, if there are numCompeting decodes
+  // (this one included) that are running or are still queued.
+  static int getThreadBudget(int concurrency, bool parallelDecompression,
+                             int numCompeting);
+
+private:
+  const CameraMetaData* metaData;
+  Executor* executor;
+};
+
+} // namespace rawspeed
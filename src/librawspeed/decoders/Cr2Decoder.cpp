@@ -90,6 +90,7 @@ RawImage Cr2Decoder::decodeOldFormat() {
       DataBuffer(mFile->getSubView(offset), Endianness::little));
 
   Cr2Decompressor l(bs, mRaw);
+  l.setSpeculativeParallelDecode(cr2.speculativeParallelDecode);
   mRaw->createData();
 
   Cr2Slicing slicing(/*numSlices=*/1, /*sliceWidth=don't care*/ 0,
@@ -178,6 +179,7 @@ RawImage Cr2Decoder::decodeNewFormat() {
       DataBuffer(mFile->getSubView(offset, count), Endianness::little));
 
   Cr2Decompressor d(bs, mRaw);
+  d.setSpeculativeParallelDecode(cr2.speculativeParallelDecode);
   mRaw->createData();
   d.decode(slicing);
 
@@ -350,7 +352,12 @@ void Cr2Decoder::sRawInterpolate() {
                     subsampledRaw->metadata.subsampling.y)),
       subsampledRaw->metadata.subsampling.y * subsampledRaw->dim.y};
 
-  mRaw = RawImage::create(interpolatedDims, TYPE_USHORT16, 3);
+  mRaw = RawImage::create(TYPE_USHORT16);
+  mRaw->setExecutor(getExecutor());
+  mRaw->setPool(imagePool);
+  mRaw->dim = interpolatedDims;
+  mRaw->setCpp(3);
+  mRaw->createData();
   mRaw->metadata.subsampling = subsampledRaw->metadata.subsampling;
   mRaw->isCFA = false;
 
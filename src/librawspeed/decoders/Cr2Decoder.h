@@ -42,6 +42,9 @@ public:
   RawImage decodeRawInternal() override;
   void checkSupportInternal(const CameraMetaData* meta) override;
   void decodeMetaDataInternal(const CameraMetaData* meta) override;
+  bool hasParallelDecompression() override {
+    return cr2.speculativeParallelDecode;
+  }
 
 protected:
   int getDecoderVersion() const override { return 9; }
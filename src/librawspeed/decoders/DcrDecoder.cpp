@@ -20,19 +20,20 @@
 */
 
 #include "decoders/DcrDecoder.h"
-#include "common/NORangesSet.h"              // for set
-#include "decoders/RawDecoderException.h"    // for ThrowRDE
-#include "decompressors/KodakDecompressor.h" // for KodakDecompressor
-#include "io/Buffer.h"                       // for Buffer, DataBuffer
-#include "io/ByteStream.h"                   // for ByteStream
-#include "io/Endianness.h"                   // for Endianness, Endianness:...
-#include "tiff/TiffEntry.h"                  // for TiffEntry, TIFF_SHORT
-#include "tiff/TiffIFD.h"                    // for TiffRootIFD, TiffID
-#include "tiff/TiffTag.h"                    // for COMPRESSION, KODAK_IFD
-#include <array>                             // for array
-#include <cassert>                           // for assert
-#include <memory>                            // for unique_ptr
-#include <string>                            // for operator==, string
+#include "common/NORangesSet.h"                  // for set
+#include "decoders/RawDecoderException.h"        // for ThrowRDE
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex...
+#include "decompressors/KodakDecompressor.h"     // for KodakDecompressor
+#include "io/Buffer.h"                           // for Buffer, DataBuffer
+#include "io/ByteStream.h"                       // for ByteStream
+#include "io/Endianness.h"                       // for Endianness, Endiannes...
+#include "tiff/TiffEntry.h"                      // for TiffEntry, TIFF_SHORT
+#include "tiff/TiffIFD.h"                        // for TiffRootIFD, TiffID
+#include "tiff/TiffTag.h"                        // for COMPRESSION, KODAK_IFD
+#include <array>                                 // for array
+#include <cassert>                               // for assert
+#include <memory>                                // for unique_ptr
+#include <string>                                // for operator==, string
 
 namespace rawspeed {
 
@@ -53,6 +54,12 @@ void DcrDecoder::checkImageDimensions() {
     ThrowRDE("Unexpected image dimensions found: (%u; %u)", width, height);
 }
 
+bool DcrDecoder::hasParallelDecompression() {
+  // A single stream, unless where it is at every few lines is already known.
+  return checkpointIndex &&
+         checkpointIndex->isRecordedBy(DecodeCheckpointIndex::Format::KODAK);
+}
+
 RawImage DcrDecoder::decodeRawInternal() {
   SimpleTiffDecoder::prepareForRawDecoding();
 
@@ -108,6 +115,7 @@ RawImage DcrDecoder::decodeRawInternal() {
   }();
 
   KodakDecompressor k(mRaw, input, bps, uncorrectedRawValues);
+  k.setCheckpointIndex(checkpointIndex);
   k.decompress();
 
   return mRaw;
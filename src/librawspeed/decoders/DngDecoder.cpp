@@ -370,6 +370,8 @@ RawImage DngDecoder::decodeRawInternal() {
              "format %u is not supported.",
              sample_format);
   }
+  mRaw->setExecutor(getExecutor());
+  mRaw->setPool(imagePool);
 
   mRaw->isCFA = (raw->getEntry(PHOTOMETRICINTERPRETATION)->getU16() == 32803);
 
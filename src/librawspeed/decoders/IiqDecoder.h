@@ -59,6 +59,7 @@ public:
   RawImage decodeRawInternal() override;
   void checkSupportInternal(const CameraMetaData* meta) override;
   void decodeMetaDataInternal(const CameraMetaData* meta) override;
+  bool hasParallelDecompression() override { return true; }
 
 protected:
   int getDecoderVersion() const override { return 0; }
@@ -24,6 +24,7 @@
 #include "common/Common.h"                          // for clampBits, round...
 #include "common/Point.h"                           // for iPoint2D
 #include "decoders/RawDecoderException.h"           // for ThrowRDE
+#include "decompressors/DecodeCheckpointIndex.h"    // for DecodeCheckpointIn...
 #include "decompressors/NikonDecompressor.h"        // for NikonDecompressor
 #include "decompressors/UncompressedDecompressor.h" // for UncompressedDeco...
 #include "io/BitPumpMSB.h"                          // for BitPumpMSB
@@ -63,6 +64,12 @@ bool NefDecoder::isAppropriateDecoder(const TiffRootIFD* rootIFD,
   return make == "NIKON CORPORATION" || make == "NIKON";
 }
 
+bool NefDecoder::hasParallelDecompression() {
+  // A single stream, unless where it is at every few lines is already known.
+  return checkpointIndex &&
+         checkpointIndex->isRecordedBy(DecodeCheckpointIndex::Format::NIKON);
+}
+
 RawImage NefDecoder::decodeRawInternal() {
   const auto* raw = mRootIFD->getIFDWithTag(CFAPATTERN);
   auto compression = raw->getEntry(COMPRESSION)->getU32();
@@ -124,6 +131,7 @@ RawImage NefDecoder::decodeRawInternal() {
                  Endianness::little));
 
   NikonDecompressor n(mRaw, meta->getData(), bitPerPixel);
+  n.setCheckpointIndex(checkpointIndex);
   mRaw->createData();
   n.decompress(rawData, uncorrectedRawValues);
 
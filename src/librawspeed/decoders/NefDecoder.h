@@ -48,6 +48,7 @@ public:
   RawImage decodeRawInternal() override;
   void decodeMetaDataInternal(const CameraMetaData* meta) override;
   void checkSupportInternal(const CameraMetaData* meta) override;
+  bool hasParallelDecompression() override;
 
 protected:
   struct NefSlice final : RawSlice {};
@@ -25,6 +25,7 @@
 #include "common/NORangesSet.h"                     // for set
 #include "common/Point.h"                           // for iPoint2D
 #include "decoders/RawDecoderException.h"           // for ThrowRDE
+#include "decompressors/DecodeCheckpointIndex.h"    // for DecodeCheckpointIn...
 #include "decompressors/OlympusDecompressor.h"      // for OlympusDecompressor
 #include "decompressors/UncompressedDecompressor.h" // for UncompressedDeco...
 #include "io/Buffer.h"                              // for Buffer
@@ -99,6 +100,12 @@ ByteStream OrfDecoder::handleSlices() const {
   return input.getStream(size);
 }
 
+bool OrfDecoder::hasParallelDecompression() {
+  // A single stream, unless where it is at every few lines is already known.
+  return checkpointIndex &&
+         checkpointIndex->isRecordedBy(DecodeCheckpointIndex::Format::OLYMPUS);
+}
+
 RawImage OrfDecoder::decodeRawInternal() {
   const auto* raw = mRootIFD->getIFDWithTag(STRIPOFFSETS);
 
@@ -124,6 +131,7 @@ RawImage OrfDecoder::decodeRawInternal() {
              raw->getEntry(STRIPOFFSETS)->count);
 
   OlympusDecompressor o(mRaw);
+  o.setCheckpointIndex(checkpointIndex);
   mRaw->createData();
   o.decompress(std::move(input));
 
@@ -45,6 +45,7 @@ public:
 
   RawImage decodeRawInternal() override;
   void decodeMetaDataInternal(const CameraMetaData* meta) override;
+  bool hasParallelDecompression() override;
 
 private:
   void parseCFA();
@@ -237,7 +237,11 @@ void RafDecoder::decodeMetaDataInternal(const CameraMetaData* meta) {
     }
 
     iPoint2D final_size(rotatedsize, rotatedsize-1);
-    RawImage rotated = RawImage::create(final_size, TYPE_USHORT16, 1);
+    RawImage rotated = RawImage::create(TYPE_USHORT16);
+    rotated->setExecutor(getExecutor());
+    rotated->setPool(imagePool);
+    rotated->dim = final_size;
+    rotated->createData();
     rotated->clearArea(iRectangle2D(iPoint2D(0,0), rotated->dim));
     rotated->metadata = mRaw->metadata;
     rotated->metadata.fujiRotationPos = rotationPos;
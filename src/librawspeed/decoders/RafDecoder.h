@@ -44,6 +44,7 @@ public:
   RawImage decodeRawInternal() override;
   void decodeMetaDataInternal(const CameraMetaData* meta) override;
   void checkSupportInternal(const CameraMetaData* meta) override;
+  bool hasParallelDecompression() override { return isCompressed(); }
   static bool isRAF(const Buffer* input);
 
 protected:
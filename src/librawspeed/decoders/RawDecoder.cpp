@@ -21,6 +21,8 @@
 
 #include "decoders/RawDecoder.h"
 #include "common/Common.h"                          // for roundUpDivision
+#include "common/CpuSet.h"                          // for ScopedThreadAff...
+#include "common/Executor.h"                        // for Executor
 #include "common/Point.h"                           // for iPoint2D, iRecta...
 #include "decoders/RawDecoderException.h"           // for ThrowRDE
 #include "decompressors/UncompressedDecompressor.h" // for UncompressedDeco...
@@ -54,6 +56,18 @@ RawDecoder::RawDecoder(const Buffer* file)
       interpolateBadPixels(true), applyStage1DngOpcodes(true), applyCrop(true),
       uncorrectedRawValues(false), fujiRotate(true), mFile(file) {}
 
+RawDecoder::~RawDecoder() {
+  // The image may well outlive us, the executor we made for it does not.
+  if (policyExecutor && &mRaw->getExecutor() == policyExecutor.get())
+    mRaw->setExecutor(executor);
+}
+
+Executor* RawDecoder::getExecutor() {
+  if (!policyExecutor)
+    policyExecutor = executionPolicy.makeExecutor(executor);
+  return policyExecutor ? policyExecutor.get() : executor;
+}
+
 void RawDecoder::decodeUncompressed(const TiffIFD *rawIFD, BitOrder order) {
   TiffEntry *offsets = rawIFD->getEntry(STRIPOFFSETS);
   TiffEntry *counts = rawIFD->getEntry(STRIPBYTECOUNTS);
@@ -258,6 +272,10 @@ void RawDecoder::setMetaData(const CameraMetaData* meta, const string& make,
 
 rawspeed::RawImage RawDecoder::decodeRaw() {
   try {
+    const ScopedThreadAffinity affinity(executionPolicy.getAllowedCpus());
+    mRaw->setExecutor(getExecutor());
+    mRaw->setPool(imagePool);
+
     RawImage raw = decodeRawInternal();
     raw->checkMemIsInitialized();
 
@@ -280,6 +298,7 @@ rawspeed::RawImage RawDecoder::decodeRaw() {
 
 void RawDecoder::decodeMetaData(const CameraMetaData* meta) {
   try {
+    const ScopedThreadAffinity affinity(executionPolicy.getAllowedCpus());
     decodeMetaDataInternal(meta);
   } catch (TiffParserException &e) {
     ThrowRDE("%s", e.what());
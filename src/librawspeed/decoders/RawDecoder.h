@@ -21,11 +21,13 @@
 
 #pragma once
 
-#include "common/Common.h"   // for BitOrder
-#include "common/RawImage.h" // for RawImage
-#include "metadata/Camera.h" // for Hints
-#include <cstdint>           // for uint32_t
-#include <string>            // for string
+#include "common/Common.h"          // for BitOrder
+#include "common/ExecutionPolicy.h" // for ExecutionPolicy
+#include "common/RawImage.h"        // for RawImage
+#include "metadata/Camera.h"        // for Hints
+#include <cstdint>                  // for uint32_t
+#include <memory>                   // for unique_ptr
+#include <string>                   // for string
 
 namespace rawspeed {
 
@@ -33,6 +35,12 @@ class Buffer;
 
 class CameraMetaData;
 
+class DecodeCheckpointIndex;
+
+class Executor;
+
+class RawImagePool;
+
 class TiffIFD;
 
 class RawDecoder
@@ -44,7 +52,7 @@ public:
    */
   /* valid while this object exists */
   explicit RawDecoder(const Buffer* file);
-  virtual ~RawDecoder() = default;
+  virtual ~RawDecoder();
 
   /* Check if the decoder can decode the image from this camera */
   /* A RawDecoderException will be thrown if the camera isn't supported */
@@ -109,6 +117,46 @@ public:
     explicit operator bool() const { return quadrantMultipliers /*|| ...*/; }
   } iiq;
 
+  struct {
+    /* Should the (single, serial) Huffman stream of the Cr2 images be */
+    /* decoded speculatively in parallel? Costs memory for the decoded */
+    /* differences (2 bytes per sample), so it is not enabled by default. */
+    bool speculativeParallelDecode = false;
+  } cr2;
+
+  /* Some formats (NEF, ORF, ARW1, SRW v1, DCR, 3FR) are a single stream, */
+  /* which can normally only be decoded by one thread. If this is set, the */
+  /* first decode records into it where the stream is at every few rows, */
+  /* and the later decodes of the same image use that to decode in parallel. */
+  /* Not owned; the caller may keep it, e.g. keyed by the hash of the file. */
+  DecodeCheckpointIndex* checkpointIndex = nullptr;
+
+  /* What runs the parallel parts of the decoding, and of the later */
+  /* processing of the decoded image (e.g. scaleBlackWhite()). */
+  /* Not owned, must outlive the image. If not set, getDefaultExecutor(). */
+  Executor* executor = nullptr;
+
+  /* How many threads, and which CPUs, the parallel parts of the decoding */
+  /* may use. Applied on top of the executor. If the CPUs are restricted, */
+  /* the threads of the executor, and the thread that calls decodeRaw() and */
+  /* decodeMetaData(), are restricted to them while they work on the image, */
+  /* so the memory of the image ends up on the NUMA node of those CPUs. */
+  /* Must be set before decodeRaw(). */
+  ExecutionPolicy executionPolicy;
+
+  /* Where the buffers of the decoded images come from, and go back to, so */
+  /* that decoding many raws in a row does not allocate a new one for each */
+  /* of them. Not owned, must outlive the images. If not set, allocated. */
+  RawImagePool* imagePool = nullptr;
+
+  /* Can the decompression make use of more than one thread? Most formats */
+  /* are a single serial stream, but e.g. the tiled DNG's or the ARW2 rows */
+  /* are decoded in parallel, and so are the streams that already have a */
+  /* checkpointIndex, or the Cr2 ones with cr2.speculativeParallelDecode, */
+  /* so ask once those are set. A hint, used to decide how many threads to */
+  /* give to each decode, see BatchDecoder. May throw, like decodeRaw(). */
+  virtual bool hasParallelDecompression() { return false; }
+
   /* Retrieve the main RAW chunk */
   /* Returns NULL if unknown */
   virtual Buffer* getCompressedData() { return nullptr; }
@@ -138,6 +186,9 @@ protected:
                            const std::string& model, const std::string& mode,
                            int iso_speed = 0);
 
+  /* The executor, with the executionPolicy applied. */
+  Executor* getExecutor();
+
   /* Generic decompressor for uncompressed images */
   /* order: Order of the bits - see Common.h for possibilities. */
   void decodeUncompressed(const TiffIFD* rawIFD, BitOrder order);
@@ -156,6 +207,10 @@ protected:
   Hints hints;
 
   struct RawSlice;
+
+private:
+  /* Made by getExecutor(), if the executionPolicy needs one. */
+  std::unique_ptr<Executor> policyExecutor;
 };
 
 struct RawDecoder::RawSlice {
@@ -86,7 +86,7 @@ RawImage Rw2Decoder::decodeRawInternal() {
 
     mRaw->dim = iPoint2D(width, height);
 
-    uint32_t size = mFile->getSize() - offset;
+    const Buffer::size_type size = mFile->getSize() - offset;
 
     UncompressedDecompressor u(
         ByteStream(DataBuffer(mFile->getSubView(offset), Endianness::little)),
@@ -155,6 +155,11 @@ RawImage Rw2Decoder::decodeRawInternal() {
   return mRaw;
 }
 
+bool Rw2Decoder::hasParallelDecompression() {
+  // All the (V4, V5, V6) decompressors of the new-style RW2 are block-based.
+  return mRootIFD->hasEntryRecursive(PANASONIC_STRIPOFFSET);
+}
+
 void Rw2Decoder::checkSupportInternal(const CameraMetaData* meta) {
   auto id = mRootIFD->getID();
   if (!checkCameraSupported(meta, id, guessMode()))
@@ -43,6 +43,7 @@ public:
   RawImage decodeRawInternal() override;
   void decodeMetaDataInternal(const CameraMetaData* meta) override;
   void checkSupportInternal(const CameraMetaData* meta) override;
+  bool hasParallelDecompression() override;
 
 protected:
   int getDecoderVersion() const override { return 3; }
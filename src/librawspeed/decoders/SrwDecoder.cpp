@@ -23,6 +23,7 @@
 #include "common/Common.h"                       // for BitOrder_LSB, BitOr...
 #include "common/Point.h"                        // for iPoint2D
 #include "decoders/RawDecoderException.h"        // for ThrowRDE
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex...
 #include "decompressors/SamsungV0Decompressor.h" // for SamsungV0Decompressor
 #include "decompressors/SamsungV1Decompressor.h" // for SamsungV1Decompressor
 #include "decompressors/SamsungV2Decompressor.h" // for SamsungV2Decompressor
@@ -53,6 +54,12 @@ bool SrwDecoder::isAppropriateDecoder(const TiffRootIFD* rootIFD,
   return make == "SAMSUNG";
 }
 
+bool SrwDecoder::hasParallelDecompression() {
+  // A single stream, unless where it is at every few lines is already known.
+  return checkpointIndex &&
+         checkpointIndex->isRecordedBy(DecodeCheckpointIndex::Format::SAMSUNG_V1);
+}
+
 RawImage SrwDecoder::decodeRawInternal() {
   const auto* raw = mRootIFD->getIFDWithTag(STRIPOFFSETS);
 
@@ -112,6 +119,7 @@ RawImage SrwDecoder::decodeRawInternal() {
         DataBuffer(mFile->getSubView(offset, count), Endianness::little));
 
     SamsungV1Decompressor s1(mRaw, &bs, bits);
+    s1.setCheckpointIndex(checkpointIndex);
 
     mRaw->createData();
 
@@ -42,6 +42,7 @@ public:
   RawImage decodeRawInternal() override;
   void decodeMetaDataInternal(const CameraMetaData* meta) override;
   void checkSupportInternal(const CameraMetaData* meta) override;
+  bool hasParallelDecompression() override;
 
 private:
   int getDecoderVersion() const override { return 3; }
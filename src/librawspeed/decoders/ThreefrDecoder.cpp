@@ -22,6 +22,7 @@
 #include "decoders/ThreefrDecoder.h"
 #include "common/Point.h"                         // for iPoint2D
 #include "decoders/RawDecoderException.h"         // for ThrowRDE
+#include "decompressors/DecodeCheckpointIndex.h"  // for DecodeCheckpointInde...
 #include "decompressors/HasselbladDecompressor.h" // for HasselbladDecompre...
 #include "io/Buffer.h"                            // for Buffer, DataBuffer
 #include "io/ByteStream.h"                        // for ByteStream
@@ -50,6 +51,12 @@ bool ThreefrDecoder::isAppropriateDecoder(const TiffRootIFD* rootIFD,
   return make == "Hasselblad";
 }
 
+bool ThreefrDecoder::hasParallelDecompression() {
+  // A single stream, unless where it is at every few lines is already known.
+  return checkpointIndex &&
+         checkpointIndex->isRecordedBy(DecodeCheckpointIndex::Format::HASSELBLAD);
+}
+
 RawImage ThreefrDecoder::decodeRawInternal() {
   const auto* raw = mRootIFD->getIFDWithTag(STRIPOFFSETS, 1);
   uint32_t width = raw->getEntry(IMAGEWIDTH)->getU32();
@@ -62,6 +69,7 @@ RawImage ThreefrDecoder::decodeRawInternal() {
   mRaw->dim = iPoint2D(width, height);
 
   HasselbladDecompressor l(bs, mRaw);
+  l.setCheckpointIndex(checkpointIndex);
   mRaw->createData();
 
   int pixelBaseOffset = hints.get("pixelBaseOffset", 0);
@@ -19,9 +19,10 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
-#include "rawspeedconfig.h" // for HAVE_OPENMP, HAV...
+#include "rawspeedconfig.h" // for HAVE_JPEG, HAVE_ZLIB
 #include "decompressors/AbstractDngDecompressor.h"
-#include "common/Common.h"                          // for rawspeed_get_num...
+#include "common/Executor.h"                        // for getLargestFirst...
+#include "common/Mutex.h"                           // for MutexLocker
 #include "common/Point.h"                           // for iPoint2D
 #include "common/RawImage.h"                        // for RawImageData
 #include "decoders/RawDecoderException.h"           // for RawDecoderException
@@ -37,15 +38,16 @@
 #include <limits>                                   // for numeric_limits
 #include <memory>                                   // for unique_ptr
 #include <string>                                   // for string
+#include <utility>                                  // for move
 #include <vector>                                   // for vector
 
 namespace rawspeed {
 
-template <> void AbstractDngDecompressor::decompressThread<1>() const noexcept {
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static)
-#endif
-  for (auto e = slices.cbegin(); e < slices.cend(); ++e) {
+template <>
+void AbstractDngDecompressor::decompressThread<1>(
+    const std::vector<int>& order, int begin, int end) const noexcept {
+  for (int i = begin; i < end; ++i) {
+    const DngSliceElement* e = &slices[order[i]];
     UncompressedDecompressor decompressor(e->bs, mRaw);
 
     iPoint2D tileSize(e->width, e->height);
@@ -87,13 +89,14 @@ template <> void AbstractDngDecompressor::decompressThread<1>() const noexcept {
   }
 }
 
-template <> void AbstractDngDecompressor::decompressThread<7>() const noexcept {
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static)
-#endif
-  for (auto e = slices.cbegin(); e < slices.cend(); ++e) {
+template <>
+void AbstractDngDecompressor::decompressThread<7>(
+    const std::vector<int>& order, int begin, int end) const noexcept {
+  for (int i = begin; i < end; ++i) {
+    const DngSliceElement* e = &slices[order[i]];
     try {
       LJpegDecompressor d(e->bs, mRaw);
+      d.setHuffmanTableCache(&huffmanTableCache);
       d.decode(e->offX, e->offY, e->width, e->height, mFixLjpeg);
     } catch (RawDecoderException& err) {
       mRaw->setError(err.what());
@@ -104,13 +107,20 @@ template <> void AbstractDngDecompressor::decompressThread<7>() const noexcept {
 }
 
 #ifdef HAVE_ZLIB
-template <> void AbstractDngDecompressor::decompressThread<8>() const noexcept {
+template <>
+void AbstractDngDecompressor::decompressThread<8>(
+    const std::vector<int>& order, int begin, int end) const noexcept {
   std::unique_ptr<unsigned char[]> uBuffer; // NOLINT
+  {
+    MutexLocker guard(&deflateBuffersMutex);
+    if (!idleDeflateBuffers.empty()) {
+      uBuffer = std::move(idleDeflateBuffers.back());
+      idleDeflateBuffers.pop_back();
+    }
+  }
 
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static)
-#endif
-  for (auto e = slices.cbegin(); e < slices.cend(); ++e) {
+  for (int i = begin; i < end; ++i) {
+    const DngSliceElement* e = &slices[order[i]];
     DeflateDecompressor z(e->bs, mRaw, mPredictor, mBps);
     try {
       z.decode(&uBuffer, iPoint2D(mRaw->getCpp() * e->dsc.tileW, e->dsc.tileH),
@@ -122,14 +132,19 @@ template <> void AbstractDngDecompressor::decompressThread<8>() const noexcept {
       mRaw->setError(err.what());
     }
   }
+
+  if (uBuffer) {
+    MutexLocker guard(&deflateBuffersMutex);
+    idleDeflateBuffers.emplace_back(std::move(uBuffer));
+  }
 }
 #endif
 
-template <> void AbstractDngDecompressor::decompressThread<9>() const noexcept {
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static)
-#endif
-  for (auto e = slices.cbegin(); e < slices.cend(); ++e) {
+template <>
+void AbstractDngDecompressor::decompressThread<9>(
+    const std::vector<int>& order, int begin, int end) const noexcept {
+  for (int i = begin; i < end; ++i) {
+    const DngSliceElement* e = &slices[order[i]];
     try {
       VC5Decompressor d(e->bs, mRaw);
       d.decode(e->offX, e->offY, e->width, e->height);
@@ -143,11 +158,10 @@ template <> void AbstractDngDecompressor::decompressThread<9>() const noexcept {
 
 #ifdef HAVE_JPEG
 template <>
-void AbstractDngDecompressor::decompressThread<0x884c>() const noexcept {
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static)
-#endif
-  for (auto e = slices.cbegin(); e < slices.cend(); ++e) {
+void AbstractDngDecompressor::decompressThread<0x884c>(
+    const std::vector<int>& order, int begin, int end) const noexcept {
+  for (int i = begin; i < end; ++i) {
+    const DngSliceElement* e = &slices[order[i]];
     JpegDecompressor j(e->bs, mRaw);
     try {
       j.decode(e->offX, e->offY);
@@ -160,7 +174,21 @@ void AbstractDngDecompressor::decompressThread<0x884c>() const noexcept {
 }
 #endif
 
-void AbstractDngDecompressor::decompressThread() const noexcept {
+template <int compression>
+void AbstractDngDecompressor::decompressInParallel() const {
+  // The state of a chunk of the slices (e.g. the Deflate buffer)
+  // is reused for all the slices of the chunk, and for the later chunks.
+  // The compressed size of a tile is the best guess of how long it will take.
+  const std::vector<int> order = getLargestFirstOrder(
+      slices, [](const DngSliceElement& e) { return e.bs.getSize(); });
+
+  mRaw->getExecutor().parallelFor(
+      0, order.size(), /*grainSize=*/1, [this, &order](int begin, int end) {
+        decompressThread<compression>(order, begin, end);
+      });
+}
+
+void AbstractDngDecompressor::decompress() const {
   assert(mRaw->dim.x > 0);
   assert(mRaw->dim.y > 0);
   assert(mRaw->getCpp() > 0 && mRaw->getCpp() <= 4);
@@ -168,14 +196,14 @@ void AbstractDngDecompressor::decompressThread() const noexcept {
 
   if (compression == 1) {
     /* Uncompressed */
-    decompressThread<1>();
+    decompressInParallel<1>();
   } else if (compression == 7) {
     /* Lossless JPEG */
-    decompressThread<7>();
+    decompressInParallel<7>();
   } else if (compression == 8) {
     /* Deflate compression */
 #ifdef HAVE_ZLIB
-    decompressThread<8>();
+    decompressInParallel<8>();
 #else
 #pragma message                                                                \
     "ZLIB is not present! Deflate compression will not be supported!"
@@ -183,25 +211,17 @@ void AbstractDngDecompressor::decompressThread() const noexcept {
 #endif
   } else if (compression == 9) {
     /* GOPRO VC-5 */
-    decompressThread<9>();
+    decompressInParallel<9>();
   } else if (compression == 0x884c) {
     /* Lossy DNG */
 #ifdef HAVE_JPEG
-    decompressThread<0x884c>();
+    decompressInParallel<0x884c>();
 #else
 #pragma message "JPEG is not present! Lossy JPEG DNG will not be supported!"
     mRaw->setError("jpeg support is disabled.");
 #endif
   } else
     mRaw->setError("AbstractDngDecompressor: Unknown compression");
-}
-
-void AbstractDngDecompressor::decompress() const {
-#ifdef HAVE_OPENMP
-#pragma omp parallel default(none) num_threads(                                \
-    rawspeed_get_number_of_processor_cores()) if (slices.size() > 1)
-#endif
-  decompressThread();
 
   std::string firstErr;
   if (mRaw->isTooManyErrors(1, &firstErr)) {
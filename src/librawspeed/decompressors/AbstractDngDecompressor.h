@@ -21,13 +21,17 @@
 
 #pragma once
 
+#include "ThreadSafetyAnalysis.h"               // for GUARDED_BY
 #include "common/Common.h"                      // for roundUpDivision
+#include "common/Mutex.h"                       // for Mutex
 #include "common/Point.h"                       // for iPoint2D
 #include "common/RawImage.h"                    // for RawImage
 #include "decompressors/AbstractDecompressor.h" // for AbstractDecompressor
+#include "decompressors/HuffmanTableCache.h"    // for HuffmanTableCache
 #include "io/ByteStream.h"                      // for ByteStream
 #include <cassert>                              // for assert
 #include <cstdint>                              // for uint32_t
+#include <memory>                               // for unique_ptr
 #include <utility>                              // for move
 #include <vector>                               // for vector
 
@@ -118,9 +122,22 @@ struct DngSliceElement final {
 class AbstractDngDecompressor final : public AbstractDecompressor {
   RawImage mRaw;
 
-  template <int compression> void decompressThread() const noexcept;
+  // All the LJpeg tiles usually have the same Huffman table(s).
+  mutable HuffmanTableCache huffmanTableCache;
 
-  void decompressThread() const noexcept;
+  // The Deflate buffers of the chunks that are done. All the tiles need one
+  // of the same size, so the later chunks reuse them, and there are no more
+  // of them than there were chunks running at the same time.
+  mutable Mutex deflateBuffersMutex;
+  mutable std::vector<std::unique_ptr<unsigned char[]>> // NOLINT
+      idleDeflateBuffers GUARDED_BY(deflateBuffersMutex);
+
+  // Decodes the slices order[begin], ..., order[end - 1].
+  template <int compression>
+  void decompressThread(const std::vector<int>& order, int begin,
+                        int end) const noexcept;
+
+  template <int compression> void decompressInParallel() const;
 
 public:
   AbstractDngDecompressor(const RawImage& img, DngTilingDescription dsc_,
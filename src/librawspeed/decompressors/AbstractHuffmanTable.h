@@ -64,7 +64,12 @@ public:
 
   void verifyCodeSymbolsAreValidDiffLenghts() const {
     for (const auto cValue : codeValues) {
-      if (cValue <= 16)
+      if (shiftedDiffs && cValue != 16 && (cValue >> 4) > (cValue & 15)) {
+        ThrowRDE("Corrupt Huffman code: difference shift %u longer than its "
+                 "length %u",
+                 cValue >> 4, cValue & 15);
+      }
+      if (diffBits(cValue) <= 16)
         continue;
       ThrowRDE("Corrupt Huffman code: difference length %u longer than 16",
                cValue);
@@ -72,13 +77,29 @@ public:
     assert(maxCodePlusDiffLength() <= 32U);
   }
 
+  // Nikon's "lossy after split" tables extend the meaning of the code values:
+  // the low nibble is still the length of the difference, but the high nibble
+  // is the count of its low bits that are not stored, but implied.
+  // Must be called before setup().
+  void enableShiftedDifferences() { shiftedDiffs = true; }
+
 protected:
   bool fullDecode = true;
   bool fixDNGBug16 = false;
+  bool shiftedDiffs = false;
+
+  // The count of the bits of the difference that are stored after the code.
+  inline unsigned __attribute__((pure)) diffBits(unsigned codeValue) const {
+    if (!shiftedDiffs || codeValue == 16)
+      return codeValue;
+    return (codeValue & 15) - (codeValue >> 4);
+  }
 
   inline size_t __attribute__((pure)) maxCodePlusDiffLength() const {
-    return nCodesPerLength.size() - 1 +
-           *(std::max_element(codeValues.cbegin(), codeValues.cend()));
+    unsigned maxDiffBits = 0;
+    for (const auto cValue : codeValues)
+      maxDiffBits = std::max(maxDiffBits, diffBits(cValue));
+    return nCodesPerLength.size() - 1 + maxDiffBits;
   }
 
   // These two fields directly represent the contents of a JPEG DHT field
@@ -170,7 +191,7 @@ protected:
 public:
   bool operator==(const AbstractHuffmanTable& other) const {
     return nCodesPerLength == other.nCodesPerLength &&
-           codeValues == other.codeValues;
+           codeValues == other.codeValues && shiftedDiffs == other.shiftedDiffs;
   }
 
   uint32_t setNCodesPerLength(const Buffer& data) {
@@ -248,17 +269,32 @@ public:
 
     // Else, treat it as the length of following difference
     // that we need to read and extend.
-    int diff_l = codeValue;
-    assert(diff_l >= 0 && diff_l <= 16);
-
-    if (diff_l == 16) {
+    if (codeValue == 16) {
       if (fixDNGBug16)
         bs.skipBitsNoFill(16);
       return -32768;
     }
 
+    const unsigned diff_l = diffBits(codeValue);
+    assert(diff_l <= 16);
     assert(symbol.code_len + diff_l <= 32);
-    return diff_l ? extend(bs.getBitsNoFill(diff_l), diff_l) : 0;
+    return extendDiff(diff_l ? bs.getBitsNoFill(diff_l) : 0, codeValue);
+  }
+
+  // Reconstructs the difference of that code value from its stored bits.
+  inline int __attribute__((pure)) extendDiff(uint32_t diff,
+                                              unsigned codeValue) const {
+    assert(codeValue != 16);
+    if (!shiftedDiffs || !(codeValue >> 4))
+      return codeValue ? extend(diff, codeValue & 15) : 0;
+
+    // The implied low bits are 0b100..., i.e. the middle of their range.
+    const unsigned len = codeValue & 15;
+    const unsigned shl = codeValue >> 4;
+    auto ret = static_cast<int32_t>(diff << shl | 1U << (shl - 1));
+    if ((ret & (1 << (len - 1))) == 0)
+      ret -= 1 << len;
+    return ret;
   }
 
   // Figure F.12 – Extending the sign bit of a decoded value in V
@@ -25,11 +25,14 @@
 #include "decoders/RawDecoderException.h"       // for ThrowRDE
 #include "decompressors/AbstractHuffmanTable.h" // for AbstractHuffmanTable
 #include "decompressors/HuffmanTable.h"         // for HuffmanTable, Huffma...
+#include "decompressors/HuffmanTableCache.h"    // for HuffmanTableCache
 #include "io/ByteStream.h"                      // for ByteStream
 #include "io/Endianness.h"                      // for Endianness, Endianne...
+#include "io/JpegUnstuffer.h"                   // for JpegUnstuffer
 #include <array>                                // for array
 #include <cassert>                              // for assert
-#include <memory>                               // for unique_ptr, make_unique
+#include <cstdint>                              // for uint8_t, uint32_t
+#include <memory>                               // for shared_ptr, make_shared
 #include <utility>                              // for move
 #include <vector>                               // for vector
 
@@ -81,6 +84,11 @@ void AbstractLJpegDecompressor::decode() {
       parseDHT(data);
       FoundMarkers.DHT = true;
       break;
+    case M_DRI:
+      if (FoundMarkers.SOS)
+        ThrowRDE("Found DRI marker after SOS");
+      parseDRI(data);
+      break;
     case M_SOF3:
       if (FoundMarkers.SOS)
         ThrowRDE("Found second SOF marker after SOS");
@@ -240,15 +248,58 @@ void AbstractLJpegDecompressor::parseDHT(ByteStream dht) {
         huff[htIndex] = i.get();
 
     if (!huff[htIndex]) {
-      // setup new ht_ and put it into the store
-      auto dHT = std::make_unique<HuffmanTable>(ht_);
-      dHT->setup(fullDecodeHT, fixDng16Bug);
+      // setup new ht_ (or get the shared one) and put it into the store
+      std::shared_ptr<const HuffmanTable> dHT;
+      if (huffmanTableCache)
+        dHT = huffmanTableCache->get(ht_, fullDecodeHT, fixDng16Bug);
+      else {
+        auto t = std::make_shared<HuffmanTable>(ht_);
+        t->setup(fullDecodeHT, fixDng16Bug);
+        dHT = std::move(t);
+      }
       huff[htIndex] = dHT.get();
       huffmanTableStore.emplace_back(std::move(dHT));
     }
   }
 }
 
+void AbstractLJpegDecompressor::parseDRI(ByteStream dri) {
+  if (dri.getRemainSize() != 2)
+    ThrowRDE("Invalid DRI header length.");
+
+  restartInterval = dri.getU16();
+}
+
+std::vector<ByteStream>
+AbstractLJpegDecompressor::getRestartIntervals(uint32_t numIntervals) {
+  assert(restartInterval > 0);
+  assert(numIntervals > 0);
+
+  std::vector<ByteStream> intervals;
+  intervals.reserve(numIntervals);
+
+  for (uint32_t i = 0; i < numIntervals; ++i) {
+    intervals.emplace_back(input.getStream(JpegUnstuffer::findMarker(input)));
+
+    if (i + 1 == numIntervals)
+      break;
+
+    // The interval is followed by the RSTn marker, n = i % 8,
+    // which may be preceded by any number of fill bytes.
+    if (input.getByte() != 0xFF)
+      ThrowRDE("Expected a marker after the restart interval %u", i);
+    uint8_t m;
+    while ((m = input.getByte()) == M_FILL)
+      ;
+    if (m != M_RST0 + i % 8) {
+      ThrowRDE("Expected RST%u marker after the restart interval %u, got 0x%02x",
+               i % 8, i, m);
+    }
+  }
+
+  return intervals;
+}
+
 JpegMarker AbstractLJpegDecompressor::getNextMarker(bool allowskip) {
   uint8_t c0;
   uint8_t c1 = input.getByte();
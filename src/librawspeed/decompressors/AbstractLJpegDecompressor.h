@@ -28,7 +28,7 @@
 #include "io/ByteStream.h"                      // for ByteStream
 #include <array>                                // for array
 #include <cstdint>                              // for uint32_t, uint16_t
-#include <memory>                               // for unique_ptr
+#include <memory>                               // for shared_ptr
 #include <vector>                               // for vector
 
 /*
@@ -38,6 +38,8 @@
 
 namespace rawspeed {
 
+class HuffmanTableCache;
+
 enum JpegMarker { /* JPEG marker codes			*/
   M_STUFF = 0x00,
   M_SOF0  = 0xc0,	/* baseline DCT				*/
@@ -138,30 +140,47 @@ public:
 
 class AbstractLJpegDecompressor : public AbstractDecompressor {
   // std::vector of unique HTs, to not recreate HT, but cache them
-  std::vector<std::unique_ptr<HuffmanTable>> huffmanTableStore;
+  std::vector<std::shared_ptr<const HuffmanTable>> huffmanTableStore;
   HuffmanTable ht_;      // temporary table, used
 
+  // If set, the tables are taken from there, and may be shared with others.
+  HuffmanTableCache* huffmanTableCache = nullptr;
+
   uint32_t Pt = 0;
-  std::array<HuffmanTable*, 4> huff{{}}; // 4 pointers into the store
+  std::array<const HuffmanTable*, 4> huff{{}}; // 4 pointers into the store
 
 public:
   AbstractLJpegDecompressor(ByteStream bs, const RawImage& img);
 
   virtual ~AbstractLJpegDecompressor() = default;
 
+  // Must be called before decoding. The cache must outlive the decoding.
+  void setHuffmanTableCache(HuffmanTableCache* cache) {
+    huffmanTableCache = cache;
+  }
+
 protected:
   bool fixDng16Bug = false;  // DNG v1.0.x compatibility
   bool fullDecodeHT = true;  // FullDecode Huffman
 
+  // The number of MCUs in each restart interval, or 0 if there are none.
+  uint32_t restartInterval = 0;
+
   void decode();
   void parseSOF(ByteStream data, SOFInfo* i);
   void parseSOS(ByteStream data);
   void parseDHT(ByteStream data);
+  void parseDRI(ByteStream data);
   JpegMarker getNextMarker(bool allowskip);
 
+  // Splits the entropy-coded data of the scan into the (still stuffed) data
+  // of each one of its numIntervals restart intervals, checking the RSTn
+  // markers in between. The input is left at the marker that ends the scan.
+  std::vector<ByteStream> getRestartIntervals(uint32_t numIntervals);
+
   template <int N_COMP>
-  std::array<HuffmanTable*, N_COMP> getHuffmanTables() const {
-    std::array<HuffmanTable*, N_COMP> ht;
+  std::array<const HuffmanTable*, N_COMP> getHuffmanTables() const {
+    std::array<const HuffmanTable*, N_COMP> ht;
     for (int i = 0; i < N_COMP; ++i) {
       const unsigned dcTblNo = frame.compInfo[i].dcTblNo;
       const unsigned dcTbls = huff.size();
@@ -22,19 +22,112 @@
 
 #include "decompressors/Cr2Decompressor.h"
 #include "common/Array2DRef.h"            // for Array2DRef
+#include "common/Executor.h"              // for Executor
 #include "common/Point.h"                 // for iPoint2D, iPoint2D::area_type
+#include "common/PrefixSum.h"             // for interleavedPrefixSum
 #include "common/RawImage.h"              // for RawImage, RawImageData
+#include "common/RawspeedException.h"     // for RawspeedException
 #include "decoders/RawDecoderException.h" // for ThrowRDE
-#include "io/BitPumpJPEG.h"               // for BitPumpJPEG, BitStream<>::...
-#include <algorithm>                      // for copy_n, min
+#include "decompressors/HuffmanTable.h"   // for HuffmanTable
+#include "io/BitPumpJPEGUnstuffed.h"      // for BitPumpJPEGUnstuffed, Bit...
+#include "io/Buffer.h"                    // for Buffer, Buffer::size_type
+#include "io/JpegUnstuffer.h"             // for JpegUnstuffer
+#include <algorithm>                      // for copy_n, lower_bound, min
 #include <array>                          // for array
 #include <cassert>                        // for assert
+#include <cstddef>                        // for size_t
+#include <cstdint>                        // for int16_t, uint16_t, uint64_t
 #include <initializer_list>               // for initializer_list
+#include <vector>                         // for vector
 
 namespace rawspeed {
 
 class ByteStream;
 
+namespace {
+
+// The Huffman codes are self-synchronising: if the decoding is started at
+// a wrong bit position, after a few (garbage) symbols it usually ends up at
+// one of the actual symbol boundaries, and from there on, it decodes exactly
+// the same symbols as the serial decoding. So the stream is split into
+// segments, which are speculatively decoded in parallel, each one from the
+// start of its first byte. Then, serially, the actual decoding of each segment
+// is resumed from where the previous one ended, until it reaches one of the
+// symbol boundaries that were found by the speculative decoding.
+
+// How many symbols in the beginning of each segment can be used to join it.
+// If it does not synchronise by then, the segment is decoded serially.
+constexpr int SpeculativeSyncWindow = 256;
+
+// There is no point in splitting the stream into segments smaller than that.
+constexpr Buffer::size_type MinSpeculativeSegmentSize = 1 << 12;
+
+// The stream, starting at an arbitrary bit position.
+struct BitPumpAt final {
+  uint64_t base; // the bit position of the input of the pump
+  BitPumpJPEGUnstuffed pump;
+
+  BitPumpAt(const ByteStream& stream, uint64_t bitPos)
+      : base(8 * (bitPos / 8)), pump(stream.getSubStream(bitPos / 8)) {
+    if (bitPos % 8 != 0) {
+      pump.fill();
+      pump.skipBitsNoFill(bitPos % 8);
+    }
+  }
+
+  uint64_t getBitPosition() const { return base + pump.getBitPosition(); }
+};
+
+struct SpeculativeSegment final {
+  uint64_t begin; // the bit positions of the segment
+  uint64_t end;
+
+  // The (groups of N_COMP) symbols decoded from the begin, until the first
+  // one that starts at or after the end.
+  std::vector<int16_t> diffs;
+  // Where the first SpeculativeSyncWindow of those symbols start.
+  std::vector<uint64_t> positions;
+  // Where the last of those symbols ends.
+  uint64_t decodedEnd = 0;
+
+  bool failed = false;
+};
+
+template <int N_COMP>
+void decodeSpeculatively(const std::array<const HuffmanTable*, N_COMP>& ht,
+                         bool pairedTables, const ByteStream& stream,
+                         SpeculativeSegment* seg) {
+  static_assert(SpeculativeSyncWindow % N_COMP == 0, "");
+
+  BitPumpAt in(stream, seg->begin);
+
+  seg->positions.reserve(SpeculativeSyncWindow);
+  while (seg->positions.size() < SpeculativeSyncWindow &&
+         in.getBitPosition() < seg->end) {
+    for (int i = 0; i < N_COMP; ++i) {
+      seg->positions.emplace_back(in.getBitPosition());
+      seg->diffs.emplace_back(ht[i]->decodeDifference(in.pump));
+    }
+  }
+
+  while (in.getBitPosition() < seg->end) {
+    if (pairedTables) {
+      for (int i = 0; i < N_COMP; i += 2) {
+        const auto d = ht[i]->decodeDifferencePair(in.pump);
+        seg->diffs.emplace_back(d[0]);
+        seg->diffs.emplace_back(d[1]);
+      }
+    } else {
+      for (int i = 0; i < N_COMP; ++i)
+        seg->diffs.emplace_back(ht[i]->decodeDifference(in.pump));
+    }
+  }
+
+  seg->decodedEnd = in.getBitPosition();
+}
+
+} // namespace
+
 Cr2Decompressor::Cr2Decompressor(const ByteStream& bs, const RawImage& img)
     : AbstractLJpegDecompressor(bs, img) {
   if (mRaw->getDataType() != TYPE_USHORT16)
@@ -55,6 +148,9 @@ void Cr2Decompressor::decodeScan()
   if (predictorMode != 1)
     ThrowRDE("Unsupported predictor mode.");
 
+  if (restartInterval != 0)
+    ThrowRDE("Restart intervals are not supported.");
+
   if (slicing.empty()) {
     const int slicesWidth = frame.w * frame.cps;
     if (slicesWidth > mRaw->dim.x)
@@ -124,6 +220,94 @@ void Cr2Decompressor::decode(const Cr2Slicing& slicing_) {
   AbstractLJpegDecompressor::decode();
 }
 
+template <int N_COMP>
+std::vector<int16_t>
+Cr2Decompressor::decodeDiffsSpeculatively(const ByteStream& stream,
+                                          size_t count) const {
+  const auto ht = getHuffmanTables<N_COMP>();
+  bool pairedTables = true;
+  for (int i = 0; i < N_COMP; i += 2)
+    pairedTables &= ht[i] == ht[i + 1];
+
+  Executor& executor = mRaw->getExecutor();
+
+  const Buffer::size_type numSegments = std::min<Buffer::size_type>(
+      4 * executor.getConcurrency(),
+      stream.getSize() / MinSpeculativeSegmentSize);
+  if (numSegments < 2)
+    return {};
+
+  std::vector<SpeculativeSegment> segments(numSegments);
+  for (Buffer::size_type i = 0; i < numSegments; ++i) {
+    segments[i].begin = 8 * (i * stream.getSize() / numSegments);
+    segments[i].end = 8 * ((i + 1) * stream.getSize() / numSegments);
+  }
+
+  executor.parallelForEach(
+      0, segments.size(), [&segments, &ht, pairedTables, &stream](int i) {
+        try {
+          decodeSpeculatively<N_COMP>(ht, pairedTables, stream, &segments[i]);
+        } catch (RawspeedException&) {
+          // It was just a guess anyway, this segment will be decoded serially.
+          segments[i].failed = true;
+        }
+      });
+
+  std::vector<int16_t> diffs;
+  diffs.reserve(count);
+
+  try {
+    uint64_t pos = 0; // Where the actual decoding is at.
+    for (const SpeculativeSegment& seg : segments) {
+      if (diffs.size() >= count)
+        break;
+
+      BitPumpAt in(stream, pos);
+      int c = 0; // The component of the next symbol.
+
+      // Decode from the actual position, until we get to the start of a
+      // symbol (of the same component) the speculative decoding was at.
+      // From there on, it has already decoded what we would have decoded.
+      bool synced = false;
+      auto p = seg.positions.cbegin();
+      while (!seg.failed && !synced && in.getBitPosition() < seg.end) {
+        p = std::lower_bound(p, seg.positions.cend(), in.getBitPosition());
+        if (p == seg.positions.cend())
+          break; // Out of luck.
+        synced = *p == in.getBitPosition() &&
+                 (p - seg.positions.cbegin()) % N_COMP == c;
+        if (!synced) {
+          diffs.emplace_back(ht[c]->decodeDifference(in.pump));
+          c = (c + 1) % N_COMP;
+        }
+      }
+
+      if (synced) {
+        diffs.insert(diffs.end(),
+                     seg.diffs.cbegin() + (p - seg.positions.cbegin()),
+                     seg.diffs.cend());
+        pos = seg.decodedEnd;
+        continue;
+      }
+
+      // Did not synchronise, so the rest of the segment is decoded serially.
+      while ((c != 0 || in.getBitPosition() < seg.end) &&
+             diffs.size() < count) {
+        diffs.emplace_back(ht[c]->decodeDifference(in.pump));
+        c = (c + 1) % N_COMP;
+      }
+      pos = in.getBitPosition();
+    }
+  } catch (RawspeedException&) {
+    return {};
+  }
+
+  if (diffs.size() < count)
+    return {};
+  diffs.resize(count);
+  return diffs;
+}
+
 // N_COMP == number of components (2, 3 or 4)
 // X_S_F  == x/horizontal sampling factor (1 or 2)
 // Y_S_F  == y/vertical   sampling factor (1 or 2)
@@ -162,7 +346,23 @@ void Cr2Decompressor::decodeN_X_Y()
   auto pred = getInitialPredictors<N_COMP>();
   auto* predNext = &out(0, 0);
 
-  BitPumpJPEG bs(input);
+  // Which component does the p'th pixel of the group belong to?
+  const auto componentOf = [](int p) {
+    return p < pixelsPerGroup ? 0 : p - pixelsPerGroup + 1;
+  };
+
+  // If both pixels of each pair within the group use the same table,
+  // their differences can be decoded together.
+  static_assert(groupSize % 2 == 0, "pixel group can not be split in pairs");
+  bool pairedTables = true;
+  for (int p = 0; p < groupSize; p += 2)
+    pairedTables &= ht[componentOf(p)] == ht[componentOf(p + 1)];
+
+  // The byte stuffing is removed beforehand, so the hot loop does not have to
+  // deal with it. That also tells where the next marker is.
+  const JpegUnstuffer unstuffed(input);
+  input.skipBytes(unstuffed.getMarkerPosition());
+  BitPumpJPEGUnstuffed bs(unstuffed.getStream());
 
   if (frame.cps != 3 && frame.w * frame.cps > 2 * frame.h) {
     // Fix Canon double height issue where Canon doubled the width and halfed
@@ -197,6 +397,31 @@ void Cr2Decompressor::decodeN_X_Y()
       cpp * realDim.area())
     ThrowRDE("Incorrrect slice height / slice widths! Less than image size.");
 
+  // Without subsampling, the differences of one slice row are decoded here.
+  std::vector<int16_t> diffs(
+      !subSampled ? std::max(slicing.sliceWidth, slicing.lastSliceWidth) : 0);
+
+  // Or, all of the differences are decoded beforehand, in parallel,
+  // in the very order in which the slices will consume them.
+  std::vector<int16_t> decodedDiffs;
+  size_t nextDecodedDiff = 0;
+  if (!subSampled && speculativeParallelDecode) {
+    size_t count = 0;
+    unsigned frameRow = 0;
+    for (auto sliceId = 0; sliceId < slicing.numSlices; sliceId++) {
+      for (unsigned sliceFrameRow = 0; sliceFrameRow < frame.h;
+           ++sliceFrameRow, ++frameRow) {
+        if (frameRow / realDim.y * slicing.widthOfSlice(0) >=
+            static_cast<unsigned>(realDim.x))
+          break;
+        count += slicing.widthOfSlice(sliceId);
+      }
+    }
+    // (Only ever 2 or 4 components here, the subsampled ones never get here.)
+    decodedDiffs = decodeDiffsSpeculatively<!subSampled ? N_COMP : 2>(
+        unstuffed.getStream(), count);
+  }
+
   unsigned globalFrameCol = 0;
   unsigned globalFrameRow = 0;
   for (auto sliceId = 0; sliceId < slicing.numSlices; sliceId++) {
@@ -246,12 +471,57 @@ void Cr2Decompressor::decodeN_X_Y()
             sliceColsRemainingInThisSliceRow, sliceColsRemainingInThisFrameRow);
         assert(sliceColsRemaining >= sliceColStep &&
                (sliceColsRemaining % sliceColStep) == 0);
+        if (!subSampled) {
+          // The components are simply interleaved, so first entropy-decode
+          // all the differences, and only then reconstruct all the pixels.
+          assert(sliceColStep == N_COMP && groupSize == N_COMP);
+          const int16_t* runDiffs = diffs.data();
+          if (!decodedDiffs.empty()) {
+            assert(nextDecodedDiff + sliceColsRemaining <=
+                   decodedDiffs.size());
+            runDiffs = &decodedDiffs[nextDecodedDiff];
+            nextDecodedDiff += sliceColsRemaining;
+          } else {
+            assert(sliceColsRemaining <= diffs.size());
+            int16_t* diff = diffs.data();
+            for (unsigned p = 0; p < sliceColsRemaining; p += N_COMP) {
+              if (pairedTables) {
+                for (int i = 0; i < N_COMP; i += 2) {
+                  const auto d = ht[i]->decodeDifferencePair(bs);
+                  *diff++ = int16_t(d[0]);
+                  *diff++ = int16_t(d[1]);
+                }
+              } else {
+                for (int i = 0; i < N_COMP; ++i)
+                  *diff++ = int16_t(ht[i]->decodeDifference(bs));
+              }
+            }
+          }
+          // The predictor arithmetic is modulo 2^16, truncation is harmless.
+          interleavedPrefixSum<N_COMP>(&out(row, col), runDiffs,
+                                       sliceColsRemaining, &pred);
+          sliceCol += sliceColsRemaining;
+          globalFrameCol += sliceColsRemaining / sliceColStep;
+          col += sliceColsRemaining;
+          continue;
+        }
+
         for (unsigned sliceColEnd = sliceCol + sliceColsRemaining;
              sliceCol < sliceColEnd; sliceCol += sliceColStep,
                       globalFrameCol += X_S_F, col += groupSize) {
-          for (int p = 0; p < groupSize; ++p) {
-            int c = p < pixelsPerGroup ? 0 : p - pixelsPerGroup + 1;
-            out(row, col + p) = pred[c] += ht[c]->decodeDifference(bs);
+          if (pairedTables) {
+            for (int p = 0; p < groupSize; p += 2) {
+              const int c0 = componentOf(p);
+              const int c1 = componentOf(p + 1);
+              const auto diffs = ht[c0]->decodeDifferencePair(bs);
+              out(row, col + p) = pred[c0] += diffs[0];
+              out(row, col + p + 1) = pred[c1] += diffs[1];
+            }
+          } else {
+            for (int p = 0; p < groupSize; ++p) {
+              int c = componentOf(p);
+              out(row, col + p) = pred[c] += ht[c]->decodeDifference(bs);
+            }
           }
         }
       }
@@ -24,7 +24,9 @@
 #include "decoders/RawDecoderException.h"            // for ThrowRDE
 #include "decompressors/AbstractLJpegDecompressor.h" // for AbstractLJpegDe...
 #include <cassert>                                   // for assert
-#include <cstdint>                                   // for uint16_t
+#include <cstddef>                                   // for size_t
+#include <cstdint>                                   // for uint16_t, int16_t
+#include <vector>                                    // for vector
 
 namespace rawspeed {
 
@@ -73,12 +75,25 @@ class Cr2Decompressor final : public AbstractLJpegDecompressor
 {
   Cr2Slicing slicing;
 
+  bool speculativeParallelDecode = false;
+
   void decodeScan() override;
   template<int N_COMP, int X_S_F, int Y_S_F> void decodeN_X_Y();
 
+  // Returns the first count differences of the (unstuffed) stream, or nothing
+  // if the stream could not be decoded that way (use the serial path then).
+  template <int N_COMP>
+  std::vector<int16_t> decodeDiffsSpeculatively(const ByteStream& stream,
+                                                size_t count) const;
+
 public:
   Cr2Decompressor(const ByteStream& bs, const RawImage& img);
   void decode(const Cr2Slicing& slicing);
+
+  // Opt-in, see RawDecoder::cr2.speculativeParallelDecode.
+  void setSpeculativeParallelDecode(bool enable) {
+    speculativeParallelDecode = enable;
+  }
 };
 
 } // namespace rawspeed
@@ -29,6 +29,7 @@
 #include "decompressors/HuffmanTable.h"   // for HuffmanTable, HuffmanTableLUT
 #include "io/BitPumpJPEG.h"               // for BitPumpJPEG, BitStream<>::...
 #include "io/Buffer.h"                    // for Buffer
+#include "io/ByteCursor.h"                // for ByteCursor
 #include "io/ByteStream.h"                // for ByteStream
 #include <array>                          // for array
 #include <cassert>                        // for assert
@@ -66,7 +67,7 @@ CrwDecompressor::CrwDecompressor(const RawImage& img, uint32_t dec_table,
   // Rest is the high bits.
   rawInput = rawData.getStream(rawData.getRemainSize());
 
-  mHuff = initHuffTables(dec_table);
+  mHuff = &initHuffTables(dec_table);
 }
 
 HuffmanTable CrwDecompressor::makeDecoder(const uint8_t* ncpl,
@@ -81,9 +82,8 @@ HuffmanTable CrwDecompressor::makeDecoder(const uint8_t* ncpl,
   return ht;
 }
 
-CrwDecompressor::crw_hts CrwDecompressor::initHuffTables(uint32_t table) {
-  if (table > 2)
-    ThrowRDE("Wrong table number: %u", table);
+CrwDecompressor::crw_hts CrwDecompressor::makeHuffTables(uint32_t table) {
+  assert(table <= 2);
 
   // NCodesPerLength
   static const std::array<std::array<uint8_t, 16>, 3> first_tree_ncpl = {{
@@ -161,6 +161,18 @@ CrwDecompressor::crw_hts CrwDecompressor::initHuffTables(uint32_t table) {
   return mHuff;
 }
 
+const CrwDecompressor::crw_hts&
+CrwDecompressor::initHuffTables(uint32_t table) {
+  if (table > 2)
+    ThrowRDE("Wrong table number: %u", table);
+
+  // The tables are fixed, so they only need to be set up once.
+  static const std::array<crw_hts, 3> tables = {
+      {makeHuffTables(0), makeHuffTables(1), makeHuffTables(2)}};
+
+  return tables[table];
+}
+
 inline void CrwDecompressor::decodeBlock(std::array<int16_t, 64>* diffBuf,
                                          const crw_hts& mHuff,
                                          BitPumpJPEG* bs) {
@@ -222,7 +234,7 @@ void CrwDecompressor::decompress() {
 
     for (unsigned block = 0; block < hBlocks; block++) {
       array<int16_t, 64> diffBuf = {{}};
-      decodeBlock(&diffBuf, mHuff, &bs);
+      decodeBlock(&diffBuf, *mHuff, &bs);
 
       // predict and output the block
 
@@ -251,9 +263,14 @@ void CrwDecompressor::decompress() {
 
   // Add the uncompressed 2 low bits to the decoded 8 high bits
   if (lowbits) {
+    // One byte per 4 pixels, the constructor took exactly that many bytes.
+    assert(lowbitInput.getRemainSize() ==
+           static_cast<uint64_t>(out.height) * out.width / 4);
+    ByteCursor lowbitBytes = lowbitInput.getCursor(lowbitInput.getRemainSize());
+
     for (int row = 0; row < out.height; row++) {
       for (int col = 0; col < out.width; /* NOTE: col += 4 */) {
-        const uint8_t c = lowbitInput.getByte();
+        const uint8_t c = lowbitBytes.getByte();
         // LSB-packed: p3 << 6 | p2 << 4 | p1 << 2 | p0 << 0
 
         // We have read 8 bits, which is 4 pairs of 2 bits. So process 4 pixels.
@@ -36,7 +36,7 @@ class CrwDecompressor final : public AbstractDecompressor {
   using crw_hts = std::array<HuffmanTable, 2>;
 
   RawImage mRaw;
-  crw_hts mHuff;
+  const crw_hts* mHuff = nullptr;
   const bool lowbits;
 
   ByteStream lowbitInput;
@@ -50,7 +50,8 @@ public:
 
 private:
   static HuffmanTable makeDecoder(const uint8_t* ncpl, const uint8_t* values);
-  static crw_hts initHuffTables(uint32_t table);
+  static crw_hts makeHuffTables(uint32_t table);
+  static const crw_hts& initHuffTables(uint32_t table);
 
   inline static void decodeBlock(std::array<int16_t, 64>* diffBuf,
                                  const crw_hts& mHuff, BitPumpJPEG* bs);
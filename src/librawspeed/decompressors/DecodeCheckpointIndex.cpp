@@ -0,0 +1,123 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decompressors/DecodeCheckpointIndex.h"
+#include "decoders/RawDecoderException.h" // for ThrowRDE
+#include "io/Buffer.h"                    // for Buffer, DataBuffer
+#include "io/ByteStream.h"                // for ByteStream
+#include "io/Endianness.h"                // for Endianness, Endianness::little
+#include <cstdint>                        // for uint32_t, uint64_t, uint8_t
+#include <vector>                         // for vector
+
+namespace rawspeed {
+
+namespace {
+
+constexpr uint32_t Magic = 0x49435352; // "RSCI", as a little-endian uint32_t
+constexpr uint32_t Version = 1;
+
+// magic, version, format, variant, inputSize, lines, lineInterval, count
+constexpr uint32_t HeaderSize = 7 * sizeof(uint32_t) + sizeof(uint64_t);
+
+// The size of one serialized checkpoint.
+constexpr uint32_t CheckpointSize =
+    sizeof(uint64_t) + DecodeCheckpointIndex::MaxStateSize * sizeof(int32_t);
+
+void putLE(std::vector<uint8_t>* out, uint64_t v, int bytes) {
+  for (int i = 0; i < bytes; ++i)
+    out->push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+} // namespace
+
+std::vector<uint8_t> DecodeCheckpointIndex::serialize() const {
+  std::vector<uint8_t> out;
+  out.reserve(HeaderSize + CheckpointSize * checkpoints.size());
+
+  putLE(&out, Magic, 4);
+  putLE(&out, Version, 4);
+  putLE(&out, static_cast<uint32_t>(format), 4);
+  putLE(&out, variant, 4);
+  putLE(&out, inputSize, 8);
+  putLE(&out, static_cast<uint32_t>(lines), 4);
+  putLE(&out, static_cast<uint32_t>(lineInterval), 4);
+  putLE(&out, static_cast<uint32_t>(checkpoints.size()), 4);
+  for (const Checkpoint& cp : checkpoints) {
+    putLE(&out, cp.bitPosition, 8);
+    for (int32_t s : cp.state)
+      putLE(&out, static_cast<uint32_t>(s), 4);
+  }
+
+  return out;
+}
+
+DecodeCheckpointIndex DecodeCheckpointIndex::deserialize(const Buffer& data) {
+  ByteStream bs(DataBuffer(data, Endianness::little));
+
+  if (bs.getU32() != Magic)
+    ThrowRDE("Not a decode checkpoint index");
+
+  const uint32_t version = bs.getU32();
+  if (version != Version)
+    ThrowRDE("Unsupported decode checkpoint index version %u", version);
+
+  DecodeCheckpointIndex index;
+
+  const uint32_t format = bs.getU32();
+  if (format == static_cast<uint32_t>(Format::NONE) ||
+      format > static_cast<uint32_t>(Format::HASSELBLAD))
+    ThrowRDE("Unknown format %u", format);
+  index.format = static_cast<Format>(format);
+
+  index.variant = bs.getU32();
+
+  index.inputSize = bs.get<uint64_t>();
+
+  // The sidecar is untrusted input too, so no arithmetic on these until they
+  // were checked to be sane.
+  const uint32_t lines = bs.getU32();
+  const uint32_t lineInterval = bs.getU32();
+  if (lines == 0 || lines > MaxLines || lineInterval == 0 ||
+      lineInterval > MaxLines)
+    ThrowRDE("Bad line count (%u) or interval (%u)", lines, lineInterval);
+  index.lines = lines;
+  index.lineInterval = lineInterval;
+
+  const uint32_t count = bs.getU32();
+  if (count != getNumCheckpoints(index.lines, index.lineInterval))
+    ThrowRDE("Unexpected checkpoint count %u", count);
+
+  bs.check(count, CheckpointSize);
+  index.checkpoints.resize(count);
+  for (Checkpoint& cp : index.checkpoints) {
+    cp.bitPosition = bs.get<uint64_t>();
+    if (cp.bitPosition > 8 * index.inputSize)
+      ThrowRDE("Checkpoint is past the end of the input");
+    for (int32_t& s : cp.state)
+      s = bs.getI32();
+  }
+
+  if (bs.getRemainSize() != 0)
+    ThrowRDE("Trailing data after the checkpoints");
+
+  return index;
+}
+
+} // namespace rawspeed
@@ -0,0 +1,196 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "common/Common.h"                // for roundUpDivision
+#include "common/ErrorLog.h"              // for ErrorLog
+#include "common/Executor.h"              // for Executor
+#include "common/RawspeedException.h"     // for RawspeedException
+#include "decoders/RawDecoderException.h" // for ThrowRDE
+#include "io/Buffer.h"                    // for Buffer
+#include "io/ByteStream.h"                // for ByteStream
+#include <algorithm>                      // for min
+#include <array>                          // for array
+#include <cassert>                        // for assert
+#include <cinttypes>                      // for PRIu64
+#include <cstddef>                        // for size_t
+#include <cstdint>                        // for uint64_t, int32_t, uint32_t
+#include <string>                         // for string
+#include <vector>                         // for vector
+
+namespace rawspeed {
+
+// The decoders that have one serial loop over a single bitstream can only be
+// run by one thread. But, if we already know where in the input, and in which
+// state, the decoder was at the start of some of the lines (rows or columns),
+// the decoding can resume at any of them, so the lines can then be split
+// between the threads.
+// So the first decode of the input records such an index (cheaply, once per
+// lineInterval lines), and the later decodes of the same input can use it.
+// It can be serialize()'d, e.g. to be cached by the hash of the input file.
+class DecodeCheckpointIndex final {
+public:
+  // Which decompressor recorded the index, an index is only valid for that one.
+  enum class Format : uint32_t {
+    NONE = 0,
+    NIKON = 1,
+    OLYMPUS = 2,
+    SONY_ARW1 = 3,
+    SAMSUNG_V1 = 4,
+    KODAK = 5,
+    HASSELBLAD = 6,
+  };
+
+  // The largest state any of the decompressors needs to save.
+  static constexpr int MaxStateSize = 5;
+
+  static constexpr int DefaultLineInterval = 64;
+
+  // No image any of the decompressors accepts has more lines than that.
+  static constexpr int MaxLines = 1 << 16;
+
+  struct Checkpoint final {
+    uint64_t bitPosition = 0; // relative to the start of the decoder's input
+    std::array<int32_t, MaxStateSize> state = {{}}; // e.g. the predictors
+  };
+
+private:
+  Format format = Format::NONE;
+  uint32_t variant = 0;
+  uint64_t inputSize = 0;
+  int lines = 0;
+  int lineInterval = DefaultLineInterval;
+  std::vector<Checkpoint> checkpoints;
+
+public:
+  // How many checkpoints there are once all the lines were recorded.
+  static size_t getNumCheckpoints(int lines_, int lineInterval_) {
+    assert(lines_ >= 0);
+    assert(lineInterval_ > 0);
+    return roundUpDivision(lines_, lineInterval_);
+  }
+
+  bool empty() const { return checkpoints.empty(); }
+  size_t size() const { return checkpoints.size(); }
+  int getLineInterval() const { return lineInterval; }
+  const Checkpoint& operator[](size_t i) const { return checkpoints[i]; }
+
+  // Was it (completely) recorded by that decompressor, for some input?
+  bool isRecordedBy(Format format_) const {
+    return format == format_ && !checkpoints.empty() &&
+           checkpoints.size() == getNumCheckpoints(lines, lineInterval);
+  }
+
+  // Was it (completely) recorded by that decompressor, for an input like this
+  // one? The variant is whatever else the saved state depends on, e.g. whether
+  // the values were dithered.
+  bool isUsableFor(Format format_, uint32_t variant_, uint64_t inputSize_,
+                   int lines_) const {
+    return isRecordedBy(format_) && variant == variant_ &&
+           inputSize == inputSize_ && lines == lines_;
+  }
+
+  void startRecording(Format format_, uint32_t variant_, uint64_t inputSize_,
+                      int lines_, int lineInterval_ = DefaultLineInterval) {
+    assert(format_ != Format::NONE);
+    assert(lines_ > 0 && lines_ <= MaxLines);
+    assert(lineInterval_ > 0 && lineInterval_ <= MaxLines);
+    format = format_;
+    variant = variant_;
+    inputSize = inputSize_;
+    lines = lines_;
+    lineInterval = lineInterval_;
+    checkpoints.clear();
+    checkpoints.reserve(getNumCheckpoints(lines, lineInterval));
+  }
+
+  bool isCheckpointLine(int line) const { return line % lineInterval == 0; }
+
+  void record(int line, const Checkpoint& checkpoint) {
+    assert(format != Format::NONE);
+    assert(isCheckpointLine(line));
+    assert(static_cast<size_t>(line / lineInterval) == checkpoints.size());
+    (void)line;
+    checkpoints.emplace_back(checkpoint);
+  }
+
+  // The (little-endian, versioned) binary representation, and back.
+  std::vector<uint8_t> serialize() const;
+  static DecodeCheckpointIndex deserialize(const Buffer& data);
+
+  // A bit pump, positioned at that bit position of the given input.
+  template <typename Pump>
+  static Pump resumePump(ByteStream input, uint64_t bitPosition) {
+    // Some pumps process whole 32-bit words, so start at a word boundary.
+    input.skipBytes(4 * (bitPosition / 32));
+    Pump pump(input);
+    if (bitPosition % 32 != 0) {
+      pump.fill();
+      pump.skipBitsNoFill(bitPosition % 32);
+    }
+    return pump;
+  }
+
+  // Where (relative to the input) a pump that was resumePump()'ed at that bit
+  // position is at now.
+  template <typename Pump>
+  static uint64_t getResumedBitPosition(const Pump& pump,
+                                        uint64_t bitPosition) {
+    return 32 * (bitPosition / 32) + pump.getBitPosition();
+  }
+
+  // Calls decodeLines(checkpoint, lineBegin, lineEnd) for the lines of each
+  // checkpoint, in parallel. It returns the bit position where those lines
+  // ended, which must be where the next checkpoint starts, else the index was
+  // recorded for another input (of the same size, otherwise it would not have
+  // been usable). Throws the first error, if any.
+  template <typename Lambda>
+  void decodeInParallel(Executor* executor, Lambda decodeLines) const {
+    assert(!empty());
+
+    ErrorLog errors;
+    executor->parallelForEach(
+        0, checkpoints.size(), [this, &errors, &decodeLines](int i) {
+          try {
+            const int lineBegin = i * lineInterval;
+            const int lineEnd = std::min(lineBegin + lineInterval, lines);
+            const uint64_t end =
+                decodeLines(checkpoints[i], lineBegin, lineEnd);
+            if (static_cast<size_t>(i) + 1 < checkpoints.size() &&
+                end != checkpoints[i + 1].bitPosition) {
+              ThrowRDE("Lines %i..%i end at bit %" PRIu64 ", not at the next "
+                       "checkpoint (bit %" PRIu64 "). Wrong index?",
+                       lineBegin, lineEnd, end, checkpoints[i + 1].bitPosition);
+            }
+          } catch (RawspeedException& err) {
+            errors.setError(err.what());
+          }
+        });
+
+    std::string firstErr;
+    if (errors.isTooManyErrors(1, &firstErr)) {
+      ThrowRDE("Too many errors encountered. Giving up. First Error:\n%s",
+               firstErr.c_str());
+    }
+  }
+};
+
+} // namespace rawspeed
@@ -21,10 +21,10 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
-#include "rawspeedconfig.h" // for HAVE_OPENMP
 #include "decompressors/FujiDecompressor.h"
 #include "common/Array2DRef.h"            // for Array2DRef
-#include "common/Common.h"                // for rawspeed_get_number_of_pro...
+#include "common/Common.h"                // for roundUpDivision
+#include "common/Executor.h"              // for getLargestFirstOrder, Exe...
 #include "common/Point.h"                 // for iPoint2D
 #include "common/RawImage.h"              // for RawImageData, RawImage
 #include "common/RawspeedException.h"     // for RawspeedException
@@ -36,6 +36,7 @@
 #include <cstdlib>                        // for abs
 #include <cstring>                        // for memcpy, memset
 #include <string>                         // for string
+#include <vector>                         // for vector
 
 namespace rawspeed {
 
@@ -767,30 +768,31 @@ void FujiDecompressor::fuji_compressed_load_raw() {
   }
 }
 
-void FujiDecompressor::decompressThread() const noexcept {
+void FujiDecompressor::decompressThread(const std::vector<int>& order,
+                                        int begin, int end) const noexcept {
   fuji_compressed_block block_info;
 
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static)
-#endif
-  for (auto strip = strips.cbegin(); strip < strips.cend(); ++strip) {
+  for (int i = begin; i < end; ++i) {
+    const FujiStrip* strip = &strips[order[i]];
     block_info.reset(&common_info);
     block_info.pump = BitPumpMSB(strip->bs);
     try {
       fuji_decode_strip(&block_info, *strip);
     } catch (RawspeedException& err) {
-      // Propagate the exception out of OpenMP magic.
       mRaw->setError(err.what());
     }
   }
 }
 
 void FujiDecompressor::decompress() const {
-#ifdef HAVE_OPENMP
-#pragma omp parallel default(none)                                             \
-    num_threads(rawspeed_get_number_of_processor_cores())
-#endif
-  decompressThread();
+  // All the strips are equally wide, but not equally compressible.
+  const std::vector<int> order = getLargestFirstOrder(
+      strips, [](const FujiStrip& strip) { return strip.bs.getSize(); });
+
+  mRaw->getExecutor().parallelFor(0, order.size(), /*grainSize=*/1,
+                                  [this, &order](int begin, int end) {
+                                    decompressThread(order, begin, end);
+                                  });
 
   std::string firstErr;
   if (mRaw->isTooManyErrors(1, &firstErr)) {
@@ -37,7 +37,9 @@ namespace rawspeed {
 class FujiDecompressor final : public AbstractDecompressor {
   RawImage mRaw;
 
-  void decompressThread() const noexcept;
+  // Decodes the strips order[begin], ..., order[end - 1].
+  void decompressThread(const std::vector<int>& order, int begin,
+                        int end) const noexcept;
 
 public:
   struct FujiHeader {
@@ -20,16 +20,17 @@
 */
 
 #include "decompressors/HasselbladDecompressor.h"
-#include "common/Array2DRef.h"            // for Array2DRef
-#include "common/Point.h"                 // for iPoint2D
-#include "common/RawImage.h"              // for RawImage, RawImageData
-#include "decoders/RawDecoderException.h" // for ThrowRDE
-#include "decompressors/HuffmanTable.h"   // for HuffmanTableLUT, HuffmanTable
-#include "io/BitPumpMSB32.h"              // for BitPumpMSB32, BitStream<>:...
-#include "io/ByteStream.h"                // for ByteStream
-#include <array>                          // for array
-#include <cassert>                        // for assert
-#include <cstdint>                        // for uint16_t
+#include "common/Array2DRef.h"                   // for Array2DRef
+#include "common/Point.h"                        // for iPoint2D
+#include "common/RawImage.h"                     // for RawImage, RawImageData
+#include "decoders/RawDecoderException.h"        // for ThrowRDE
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex
+#include "decompressors/HuffmanTable.h"          // for HuffmanTableLUT, Huff...
+#include "io/BitPumpMSB32.h"                     // for BitPumpMSB32, BitStre...
+#include "io/ByteStream.h"                       // for ByteStream
+#include <array>                                 // for array
+#include <cassert>                               // for assert
+#include <cstdint>                               // for uint16_t
 
 namespace rawspeed {
 
@@ -60,39 +61,86 @@ inline int HasselbladDecompressor::getBits(BitPumpMSB32* bs, int len) {
   return diff;
 }
 
-void HasselbladDecompressor::decodeScan() {
-  if (frame.w != static_cast<unsigned>(mRaw->dim.x) ||
-      frame.h != static_cast<unsigned>(mRaw->dim.y)) {
-    ThrowRDE("LJPEG frame does not match EXIF dimensions: (%u; %u) vs (%i; %i)",
-             frame.w, frame.h, mRaw->dim.x, mRaw->dim.y);
-  }
-
+void HasselbladDecompressor::decodeRows(BitPumpMSB32* bitStream, int rowBegin,
+                                        int rowEnd,
+                                        DecodeCheckpointIndex* recorder) const {
   const Array2DRef<uint16_t> out(mRaw->getU16DataAsUncroppedArray2DRef());
 
-  assert(out.height > 0);
-  assert(out.width > 0);
-  assert(out.width % 2 == 0);
-
   const auto ht = getHuffmanTables<1>();
-  ht[0]->verifyCodeSymbolsAreValidDiffLenghts();
 
-  BitPumpMSB32 bitStream(input);
   // Pixels are packed two at a time, not like LJPEG:
   // [p1_length_as_huffman][p2_length_as_huffman][p0_diff_with_length][p1_diff_with_length]|NEXT PIXELS
-  for (int row = 0; row < out.height; row++) {
+  for (int row = rowBegin; row < rowEnd; row++) {
+    // The predictors are reset at each row, only the position needs saving.
+    if (recorder && recorder->isCheckpointLine(row)) {
+      DecodeCheckpointIndex::Checkpoint cp;
+      cp.bitPosition = bitStream->getBitPosition();
+      recorder->record(row, cp);
+    }
+
     int p1 = 0x8000 + pixelBaseOffset;
     int p2 = 0x8000 + pixelBaseOffset;
     for (int col = 0; col < out.width; col += 2) {
-      int len1 = ht[0]->decodeCodeValue(bitStream);
-      int len2 = ht[0]->decodeCodeValue(bitStream);
-      p1 += getBits(&bitStream, len1);
-      p2 += getBits(&bitStream, len2);
+      int len1 = ht[0]->decodeCodeValue(*bitStream);
+      int len2 = ht[0]->decodeCodeValue(*bitStream);
+      p1 += getBits(bitStream, len1);
+      p2 += getBits(bitStream, len2);
       // NOTE: this is rather unusual and weird, but appears to be correct.
       // clampBits(p, 16) results in completely garbled images.
       out(row, col) = uint16_t(p1);
       out(row, col + 1) = uint16_t(p2);
     }
   }
+}
+
+void HasselbladDecompressor::decodeScan() {
+  if (restartInterval != 0)
+    ThrowRDE("Restart intervals are not supported.");
+
+  if (frame.w != static_cast<unsigned>(mRaw->dim.x) ||
+      frame.h != static_cast<unsigned>(mRaw->dim.y)) {
+    ThrowRDE("LJPEG frame does not match EXIF dimensions: (%u; %u) vs (%i; %i)",
+             frame.w, frame.h, mRaw->dim.x, mRaw->dim.y);
+  }
+
+  assert(mRaw->dim.y > 0);
+  assert(mRaw->dim.x > 0);
+  assert(mRaw->dim.x % 2 == 0);
+
+  const auto ht = getHuffmanTables<1>();
+  ht[0]->verifyCodeSymbolsAreValidDiffLenghts();
+
+  if (checkpointIndex &&
+      checkpointIndex->isUsableFor(DecodeCheckpointIndex::Format::HASSELBLAD,
+                                   /*variant=*/0, input.getRemainSize(),
+                                   mRaw->dim.y)) {
+    // Where the last rows end, which is where the scan ends.
+    ByteStream::size_type scanEnd = 0;
+    checkpointIndex->decodeInParallel(
+        &mRaw->getExecutor(),
+        [this, &scanEnd](const DecodeCheckpointIndex::Checkpoint& cp,
+                         int rowBegin, int rowEnd) {
+          BitPumpMSB32 bitStream =
+              DecodeCheckpointIndex::resumePump<BitPumpMSB32>(input,
+                                                              cp.bitPosition);
+          decodeRows(&bitStream, rowBegin, rowEnd, nullptr);
+          if (rowEnd == mRaw->dim.y)
+            scanEnd = 4 * (cp.bitPosition / 32) + bitStream.getBufferPosition();
+          return DecodeCheckpointIndex::getResumedBitPosition(bitStream,
+                                                              cp.bitPosition);
+        });
+    input.skipBytes(scanEnd);
+    return;
+  }
+
+  if (checkpointIndex) {
+    checkpointIndex->startRecording(DecodeCheckpointIndex::Format::HASSELBLAD,
+                                    /*variant=*/0, input.getRemainSize(),
+                                    mRaw->dim.y);
+  }
+
+  BitPumpMSB32 bitStream(input);
+  decodeRows(&bitStream, 0, mRaw->dim.y, checkpointIndex);
   input.skipBytes(bitStream.getBufferPosition());
 }
 
@@ -22,6 +22,7 @@
 #pragma once
 
 #include "decompressors/AbstractLJpegDecompressor.h" // for AbstractLJpegDe...
+#include "decompressors/DecodeCheckpointIndex.h"     // for DecodeCheckpoi...
 #include "io/BitPumpMSB32.h"                         // for BitPumpMSB32
 
 namespace rawspeed {
@@ -33,11 +34,22 @@ class HasselbladDecompressor final : public AbstractLJpegDecompressor
 {
   int pixelBaseOffset = 0;
 
+  DecodeCheckpointIndex* checkpointIndex = nullptr;
+
   void decodeScan() override;
 
+  void decodeRows(BitPumpMSB32* bitStream, int rowBegin, int rowEnd,
+                  DecodeCheckpointIndex* recorder) const;
+
 public:
   HasselbladDecompressor(const ByteStream& bs, const RawImage& img);
 
+  // If the index was recorded for this input, the rows are decoded in
+  // parallel, else it is (re)recorded during the (serial) decoding.
+  void setCheckpointIndex(DecodeCheckpointIndex* index) {
+    checkpointIndex = index;
+  }
+
   void decode(int pixelBaseOffset_);
 
   static int getBits(BitPumpMSB32* bs, int len);
@@ -0,0 +1,64 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decompressors/HuffmanTableCache.h"
+#include "common/Mutex.h" // for MutexLocker
+#include <algorithm>      // for max, rotate
+#include <cassert>        // for assert
+#include <memory>         // for make_shared, shared_ptr
+
+namespace rawspeed {
+
+constexpr size_t HuffmanTableCache::DefaultMaxEntries;
+
+HuffmanTableCache::HuffmanTableCache(size_t maxEntries_)
+    : maxEntries(std::max<size_t>(maxEntries_, 1)) {}
+
+std::shared_ptr<const HuffmanTable>
+HuffmanTableCache::get(const HuffmanTable& ht, bool fullDecode,
+                       bool fixDNGBug16) {
+  MutexLocker guard(&mutex);
+
+  // There are at most maxEntries tables, so a linear search is fine.
+  for (auto it = entries.begin(); it != entries.end(); ++it) {
+    if (it->fullDecode == fullDecode && it->fixDNGBug16 == fixDNGBug16 &&
+        *it->table == ht) {
+      std::rotate(entries.begin(), it, it + 1);
+      return entries.front().table;
+    }
+  }
+
+  // If the table is corrupt, this throws, and nothing is stored.
+  auto table = std::make_shared<HuffmanTable>(ht);
+  table->setup(fullDecode, fixDNGBug16);
+
+  if (entries.size() == maxEntries)
+    entries.pop_back(); // The least recently used one.
+  entries.insert(entries.begin(), Entry{fullDecode, fixDNGBug16, table});
+  assert(entries.size() <= maxEntries);
+  return table;
+}
+
+size_t HuffmanTableCache::size() {
+  MutexLocker guard(&mutex);
+  return entries.size();
+}
+
+} // namespace rawspeed
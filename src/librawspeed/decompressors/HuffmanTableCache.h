@@ -0,0 +1,65 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "ThreadSafetyAnalysis.h"       // for REQUIRES, GUARDED_BY
+#include "common/Mutex.h"               // for Mutex
+#include "decompressors/HuffmanTable.h" // for HuffmanTable
+#include <cstddef>                      // for size_t
+#include <memory>                       // for shared_ptr
+#include <vector>                       // for vector
+
+namespace rawspeed {
+
+// A thread-safe store of the already set-up Huffman tables, keyed by their
+// contents (the code-length and code-value bytes) and the setup parameters.
+// E.g. all the tiles of a tiled LJpeg DNG carry the very same DHT, so instead
+// of every tile building its own lookup tables, they can all share one.
+// The returned tables are immutable, and outlive the cache if still in use.
+// The input may be untrusted, and every tile could carry a different DHT,
+// so only the maxEntries most recently used tables are kept.
+class HuffmanTableCache final {
+  struct Entry final {
+    bool fullDecode;
+    bool fixDNGBug16;
+    std::shared_ptr<const HuffmanTable> table;
+  };
+
+  const size_t maxEntries;
+
+  Mutex mutex;
+  std::vector<Entry> entries GUARDED_BY(mutex); // Most recently used first.
+
+public:
+  static constexpr size_t DefaultMaxEntries = 8;
+
+  explicit HuffmanTableCache(size_t maxEntries_ = DefaultMaxEntries);
+
+  // Given a table with the codes-per-length and code values already set,
+  // returns the equal table that has been setup() with the given parameters.
+  std::shared_ptr<const HuffmanTable> get(const HuffmanTable& ht,
+                                          bool fullDecode, bool fixDNGBug16)
+      REQUIRES(!mutex);
+
+  size_t size() REQUIRES(!mutex);
+};
+
+} // namespace rawspeed
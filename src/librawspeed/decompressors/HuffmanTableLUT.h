@@ -26,13 +26,14 @@
 #include "decompressors/AbstractHuffmanTable.h" // for AbstractHuffmanTable...
 #include "decompressors/HuffmanTableLookup.h"   // for HuffmanTableLookup
 #include "io/BitStream.h"                       // for BitStreamTraits
+#include <algorithm>                            // for max, min
+#include <array>                                // for array
 #include <cassert>                              // for assert
 #include <cstddef>                              // for size_t
 #include <cstdint>                              // for int32_t, uint16_t
 #include <memory>                               // for allocator_traits<>::...
 #include <tuple>                                // for tie
 #include <vector>                               // for vector
-// IWYU pragma: no_include <algorithm>
 
 /*
 * The following code is inspired by the IJG JPEG library.
@@ -69,58 +70,139 @@
 namespace rawspeed {
 
 class HuffmanTableLUT final : public HuffmanTableLookup {
-  // The code can be compiled with two different decode lookup table layouts.
-  // The idea is that different CPU architectures may perform better with
-  // one or the other, depending on the relative performance of their arithmetic
-  // core vs their memory access. For an Intel Core i7, the big table is better.
-#if 1
   // lookup table containing 3 fields: payload:16|flag:8|len:8
   // The payload may be the fully decoded diff or the length of the diff.
   // The len field contains the number of bits, this lookup consumed.
   // A lookup value of 0 means the code was too big to fit into the table.
-  // The optimal LookupDepth is also likely to depend on the CPU architecture.
   static constexpr unsigned PayloadShift = 16;
   static constexpr unsigned FlagMask = 0x100;
   static constexpr unsigned LenMask = 0xff;
-  static constexpr unsigned LookupDepth = 11;
   std::vector<int32_t> decodeLookup;
-#else
-  // lookup table containing 2 fields: payload:4|len:4
-  // the payload is the length of the diff, len is the length of the code
-  static constexpr unsigned LookupDepth = 15;
-  static constexpr unsigned PayloadShift = 4;
-  static constexpr unsigned FlagMask = 0;
-  static constexpr unsigned LenMask = 0x0f;
-  std::vector<uint8_t> decodeLookup;
-#endif
+
+  // The lookup tables are indexed by the next lookupDepth bits of the input.
+  // Codes longer than that need the (slow) finishReadingPartialSymbol() path,
+  // and codes whose diff does not fit alongside need processSymbol().
+  // But a bigger table is more expensive to build and is less cache-friendly,
+  // so the depth is picked per table, unless explicitly specified.
+  static constexpr unsigned MinLookupDepth = 9;
+  static constexpr unsigned MaxLookupDepth = 14;
+  unsigned lookupDepth = 0;
+  bool lookupDepthIsFixed = false;
+
+  // For the full decode, the expected share of the lookups that do not
+  // return the final diff (see chooseLookupDepth()) is at most 1/this.
+  static constexpr unsigned MissedFullDecodeRatio = 8;
+
+  unsigned chooseLookupDepth(const std::vector<CodeSymbol>& symbols) const {
+    const unsigned maxCodeLength = nCodesPerLength.size() - 1U;
+
+    // Big enough for every code to be fully read by the lookup, if possible.
+    // (Copies, so that the static constexpr members are not ODR-used.)
+    unsigned depth = std::max(unsigned(MinLookupDepth), maxCodeLength);
+    depth = std::min(depth, unsigned(MaxLookupDepth));
+
+    if (!fullDecode)
+      return depth;
+
+    // A Huffman code of length l is expected to be seen with frequency 2^-l.
+    // Grow the table until the codes that can not be fully decoded by the
+    // lookup (code + diff does not fit) are expected to be rare enough.
+    for (; depth < MaxLookupDepth; ++depth) {
+      uint32_t missed = 0; // in the units of 2^-16
+      for (size_t i = 0; i < symbols.size(); i++) {
+        const unsigned diff_l = diffBits(codeValues[i]);
+        if (symbols[i].code_len + diff_l > depth && diff_l != 16)
+          missed += 1U << (16U - symbols[i].code_len);
+      }
+      if (missed <= (1U << 16U) / MissedFullDecodeRatio)
+        break;
+    }
+
+    return depth;
+  }
+
+  // For the full decode, a second lookup table, indexed by the same
+  // lookupDepth bits, for the case when both the first and the second
+  // code+diff fit into them. Then, a single lookup decodes both differences.
+  // Layout: diff1:16|diff0:16|unused:16|flag:8|len:8, with len being the
+  // total number of bits of both symbols.
+  // A lookup value without the flag means that the two symbols did not fit.
+  static constexpr unsigned PairDiff0Shift = 32;
+  static constexpr unsigned PairDiff1Shift = 48;
+  std::vector<uint64_t> decodePairLookup;
+
+  void setupPairLookup() {
+    assert(fullDecode);
+    static_assert(FlagMask != 0, "need fully-decoded lookup table entries");
+
+    decodePairLookup.clear();
+    decodePairLookup.resize(decodeLookup.size());
+    for (size_t c = 0; c < decodeLookup.size(); c++) {
+      const auto first = static_cast<unsigned>(decodeLookup[c]);
+      const unsigned len0 = first & LenMask;
+      if (!(first & FlagMask) || len0 >= lookupDepth)
+        continue;
+
+      // The second symbol starts right after the first one. Its lookup only
+      // makes sense if it did not need any bit past the lookupDepth bits.
+      const size_t c1 = (c << len0) & (decodeLookup.size() - 1);
+      const auto second = static_cast<unsigned>(decodeLookup[c1]);
+      const unsigned len1 = second & LenMask;
+      if (!(second & FlagMask) || len0 + len1 > lookupDepth)
+        continue;
+
+      const auto diff0 = static_cast<uint16_t>(
+          static_cast<int32_t>(first) >> PayloadShift);
+      const auto diff1 = static_cast<uint16_t>(
+          static_cast<int32_t>(second) >> PayloadShift);
+      decodePairLookup[c] = uint64_t(diff1) << PairDiff1Shift |
+                            uint64_t(diff0) << PairDiff0Shift | FlagMask |
+                            (len0 + len1);
+    }
+  }
 
 public:
+  // Overrides the automatic lookupDepth choice. Must be called before setup().
+  void setLookupDepth(unsigned depth) {
+    assert(depth >= MinLookupDepth && depth <= MaxLookupDepth);
+    lookupDepth = depth;
+    lookupDepthIsFixed = true;
+  }
+
+  unsigned getLookupDepth() const { return lookupDepth; }
+
   void setup(bool fullDecode_, bool fixDNGBug16_) {
     const std::vector<CodeSymbol> symbols =
         HuffmanTableLookup::setup(fullDecode_, fixDNGBug16_);
 
+    if (!lookupDepthIsFixed)
+      lookupDepth = chooseLookupDepth(symbols);
+    assert(lookupDepth >= MinLookupDepth && lookupDepth <= MaxLookupDepth);
+
     // Generate lookup table for fast decoding lookup.
     // See definition of decodeLookup above
-    decodeLookup.resize(1 << LookupDepth);
+    decodeLookup.clear();
+    decodeLookup.resize(1 << lookupDepth);
     for (size_t i = 0; i < symbols.size(); i++) {
       uint8_t code_l = symbols[i].code_len;
-      if (code_l > static_cast<int>(LookupDepth))
+      if (code_l > static_cast<int>(lookupDepth))
         break;
 
-      uint16_t ll = symbols[i].code << (LookupDepth - code_l);
-      uint16_t ul = ll | ((1 << (LookupDepth - code_l)) - 1);
-      uint16_t diff_l = codeValues[i];
+      uint16_t ll = symbols[i].code << (lookupDepth - code_l);
+      uint16_t ul = ll | ((1 << (lookupDepth - code_l)) - 1);
+      const uint16_t codeValue = codeValues[i];
+      const uint16_t diff_l = diffBits(codeValue);
       for (uint16_t c = ll; c <= ul; c++) {
         if (!(c < decodeLookup.size()))
           ThrowRDE("Corrupt Huffman");
 
-        if (!FlagMask || !fullDecode || code_l > LookupDepth ||
-            (code_l + diff_l > LookupDepth && diff_l != 16)) {
+        if (!FlagMask || !fullDecode || code_l > lookupDepth ||
+            (code_l + diff_l > lookupDepth && diff_l != 16)) {
           // lookup bit depth is too small to fit both the encoded length
           // and the final difference value.
           // -> store only the length and do a normal sign extension later
           assert(!fullDecode || diff_l > 0);
-          decodeLookup[c] = diff_l << PayloadShift | code_l;
+          decodeLookup[c] = codeValue << PayloadShift | code_l;
 
           if (!fullDecode)
             decodeLookup[c] |= FlagMask;
@@ -130,20 +212,26 @@ public:
           if (diff_l != 16 || fixDNGBug16)
             decodeLookup[c] += diff_l;
 
-          if (diff_l) {
-            uint32_t diff;
-            if (diff_l != 16) {
-              diff = extractHighBits(c, code_l + diff_l,
-                                     /*effectiveBitwidth=*/LookupDepth);
-              diff &= ((1 << diff_l) - 1);
-            } else
-              diff = uint32_t(-32768);
+          if (codeValue) {
+            int diff = -32768;
+            if (codeValue != 16) {
+              uint32_t bits = 0;
+              if (diff_l) {
+                bits = extractHighBits(c, code_l + diff_l,
+                                       /*effectiveBitwidth=*/lookupDepth);
+                bits &= ((1 << diff_l) - 1);
+              }
+              diff = extendDiff(bits, codeValue);
+            }
             decodeLookup[c] |= static_cast<int32_t>(
-                static_cast<uint32_t>(extend(diff, diff_l)) << PayloadShift);
+                static_cast<uint32_t>(diff) << PayloadShift);
           }
         }
       }
     }
+
+    if (fullDecode)
+      setupPairLookup();
   }
 
   template <typename BIT_STREAM>
@@ -164,6 +252,30 @@ public:
     return decode<BIT_STREAM, true>(bs);
   }
 
+  // Decodes two consecutive differences, exactly like two decodeDifference()
+  // calls would, but with a single lookup if both of them fit into it.
+  template <typename BIT_STREAM>
+  inline __attribute__((always_inline)) std::array<int, 2>
+  decodeDifferencePair(BIT_STREAM& bs) const {
+    static_assert(BitStreamTraits<BIT_STREAM>::canUseWithHuffmanTable,
+                  "This BitStream specialization is not marked as usable here");
+    assert(fullDecode);
+    bs.fill(32);
+
+    const auto code = bs.peekBitsNoFill(lookupDepth);
+    assert(code < decodePairLookup.size());
+    const uint64_t lutEntry = decodePairLookup[code];
+
+    if (!(lutEntry & FlagMask)) {
+      const int diff0 = decode<BIT_STREAM, true>(bs);
+      return {{diff0, decode<BIT_STREAM, true>(bs)}};
+    }
+
+    bs.skipBitsNoFill(lutEntry & LenMask);
+    return {{static_cast<int16_t>(lutEntry >> PairDiff0Shift),
+             static_cast<int16_t>(lutEntry >> PairDiff1Shift)}};
+  }
+
   // The bool template paraeter is to enable two versions:
   // one returning only the length of the of diff bits (see Hasselblad),
   // one to return the fully decoded diff.
@@ -176,7 +288,7 @@ public:
     bs.fill(32);
 
     CodeSymbol partial;
-    partial.code_len = LookupDepth;
+    partial.code_len = lookupDepth;
     partial.code = bs.peekBitsNoFill(partial.code_len);
 
     assert(partial.code < decodeLookup.size());
@@ -184,7 +296,7 @@ public:
     int payload = static_cast<int>(lutEntry) >> PayloadShift;
     int len = lutEntry & LenMask;
 
-    // How far did reading of those LookupDepth bits *actually* move us forward?
+    // How far did reading of those lookupDepth bits *actually* move us forward?
     bs.skipBitsNoFill(len);
 
     // If the flag bit is set, then we have already skipped all the len bits
@@ -201,7 +313,7 @@ public:
       assert(!FULL_DECODE || codeValue /*aka diff_l*/ > 0);
     } else {
       // No match in the lookup table, because either the code is longer
-      // than LookupDepth or the input is corrupt. Need to read more bits...
+      // than lookupDepth or the input is corrupt. Need to read more bits...
       assert(len == 0);
       bs.skipBitsNoFill(partial.code_len);
       std::tie(partial, codeValue) = finishReadingPartialSymbol(bs, partial);
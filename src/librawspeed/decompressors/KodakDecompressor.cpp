@@ -21,18 +21,21 @@
 */
 
 #include "decompressors/KodakDecompressor.h"
-#include "common/Array2DRef.h"            // for Array2DRef
-#include "common/Common.h"                // for extractHighBits, isIntN
-#include "common/Point.h"                 // for iPoint2D
-#include "common/RawImage.h"              // for RawImage, RawImageData
-#include "decoders/RawDecoderException.h" // for ThrowRDE
-#include "decompressors/HuffmanTable.h"   // for HuffmanTable
-#include "io/ByteStream.h"                // for ByteStream
-#include <algorithm>                      // for min
-#include <array>                          // for array
-#include <cassert>                        // for assert
-#include <cstdint>                        // for uint32_t, uint8_t, uint16_t
-#include <utility>                        // for move
+#include "common/Array2DRef.h"                   // for Array2DRef
+#include "common/Common.h"                       // for extractHighBits, isIntN
+#include "common/Point.h"                        // for iPoint2D
+#include "common/PrefixSum.h"                    // for interleavedPrefixSum
+#include "common/RawImage.h"                     // for RawImage, RawImageData
+#include "decoders/RawDecoderException.h"        // for ThrowRDE
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex
+#include "decompressors/HuffmanTable.h"          // for HuffmanTable
+#include "io/ByteCursor.h"                       // for ByteCursor
+#include "io/ByteStream.h"                       // for ByteStream
+#include <algorithm>                             // for min
+#include <array>                                 // for array
+#include <cassert>                               // for assert
+#include <cstdint>                               // for int32_t, uint32_t, ui...
+#include <utility>                               // for move
 
 namespace rawspeed {
 
@@ -60,7 +63,7 @@ KodakDecompressor::KodakDecompressor(const RawImage& img, ByteStream bs,
 }
 
 KodakDecompressor::segment
-KodakDecompressor::decodeSegment(const uint32_t bsize) {
+KodakDecompressor::decodeSegment(ByteStream* bs, const uint32_t bsize) {
   assert(bsize > 0);
   assert(bsize % 4 == 0);
   assert(bsize <= segment_size);
@@ -78,14 +81,16 @@ KodakDecompressor::decodeSegment(const uint32_t bsize) {
   uint64_t bitbuf = 0;
   uint32_t bits = 0;
 
+  // One byte per two pixels
+  ByteCursor lens = bs->getCursor(bsize / 2);
   for (uint32_t i = 0; i < bsize; i += 2) {
-    // One byte per two pixels
-    blen[i] = input.peekByte() & 15;
-    blen[i + 1] = input.getByte() >> 4;
+    blen[i] = lens.peekByte() & 15;
+    blen[i + 1] = lens.getByte() >> 4;
   }
   if ((bsize & 7) == 4) {
-    bitbuf = (static_cast<uint64_t>(input.getByte())) << 8UL;
-    bitbuf += (static_cast<int>(input.getByte()));
+    ByteCursor bytes = bs->getCursor(2);
+    bitbuf = (static_cast<uint64_t>(bytes.getByte())) << 8UL;
+    bitbuf += (static_cast<int>(bytes.getByte()));
     bits = 16;
   }
   for (uint32_t i = 0; i < bsize; i++) {
@@ -93,8 +98,9 @@ KodakDecompressor::decodeSegment(const uint32_t bsize) {
     assert(len < 16);
 
     if (bits < len) {
+      ByteCursor bytes = bs->getCursor(4);
       for (uint32_t j = 0; j < 32; j += 8) {
-        bitbuf += static_cast<int64_t>(static_cast<int>(input.getByte()))
+        bitbuf += static_cast<int64_t>(static_cast<int>(bytes.getByte()))
                   << (bits + (j ^ 8));
       }
       bits += 32;
@@ -111,23 +117,34 @@ KodakDecompressor::decodeSegment(const uint32_t bsize) {
   return out;
 }
 
-void KodakDecompressor::decompress() {
+void KodakDecompressor::decompressRows(ByteStream* bs, int rowBegin,
+                                       int rowEnd, uint32_t* random,
+                                       DecodeCheckpointIndex* recorder) const {
   const Array2DRef<uint16_t> out(mRaw->getU16DataAsUncroppedArray2DRef());
 
-  uint32_t random = 0;
-  for (int row = 0; row < out.height; row++) {
+  for (int row = rowBegin; row < rowEnd; row++) {
+    if (recorder && recorder->isCheckpointLine(row)) {
+      DecodeCheckpointIndex::Checkpoint cp;
+      cp.bitPosition = 8 * uint64_t(bs->getPosition() - input.getPosition());
+      cp.state[0] = static_cast<int32_t>(*random);
+      recorder->record(row, cp);
+    }
+
     for (int col = 0; col < out.width;) {
       const int len = std::min(segment_size, mRaw->dim.x - col);
 
-      const segment buf = decodeSegment(len);
+      const segment buf = decodeSegment(bs, len);
 
-      std::array<int, 2> pred;
-      pred.fill(0);
+      // The segment is already entropy-decoded, so reconstruct all of it.
+      std::array<int32_t, 2> pred = {{}};
+      std::array<int32_t, segment_size> values;
+      const int evenLen = len & ~1;
+      interleavedPrefixSum<2>(values.data(), buf.data(), evenLen, &pred);
+      if (len != evenLen)
+        values[evenLen] = pred[0] + buf[evenLen];
 
       for (int i = 0; i < len; ++i, ++col) {
-        pred[i & 1] += buf[i];
-
-        int value = pred[i & 1];
+        int value = values[i];
         if (!isIntN(value, bps))
           ThrowRDE("Value out of bounds %d (bps = %i)", value, bps);
 
@@ -135,10 +152,43 @@ void KodakDecompressor::decompress() {
           out(row, col) = value;
         else
           mRaw->setWithLookUp(value, reinterpret_cast<uint8_t*>(&out(row, col)),
-                              &random);
+                              random);
       }
     }
   }
 }
 
+void KodakDecompressor::decompress() {
+  // The dithering state is only saved when the values are dithered.
+  const uint32_t variant = uncorrectedRawValues;
+
+  if (checkpointIndex &&
+      checkpointIndex->isUsableFor(DecodeCheckpointIndex::Format::KODAK,
+                                   variant, input.getRemainSize(),
+                                   mRaw->dim.y)) {
+    checkpointIndex->decodeInParallel(
+        &mRaw->getExecutor(),
+        [this](const DecodeCheckpointIndex::Checkpoint& cp, int rowBegin,
+               int rowEnd) {
+          ByteStream bs = input;
+          bs.skipBytes(cp.bitPosition / 8);
+          auto random = static_cast<uint32_t>(cp.state[0]);
+          decompressRows(&bs, rowBegin, rowEnd, &random, nullptr);
+          // The checkpoints are at byte boundaries.
+          return 8 * uint64_t(bs.getPosition() - input.getPosition());
+        });
+    return;
+  }
+
+  if (checkpointIndex) {
+    checkpointIndex->startRecording(DecodeCheckpointIndex::Format::KODAK,
+                                    variant, input.getRemainSize(),
+                                    mRaw->dim.y);
+  }
+
+  ByteStream bs = input;
+  uint32_t random = 0;
+  decompressRows(&bs, 0, mRaw->dim.y, &random, checkpointIndex);
+}
+
 } // namespace rawspeed
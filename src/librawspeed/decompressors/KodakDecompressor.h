@@ -22,11 +22,12 @@
 
 #pragma once
 
-#include "common/RawImage.h"                    // for RawImage
-#include "decompressors/AbstractDecompressor.h" // for AbstractDecompressor
-#include "io/ByteStream.h"                      // for ByteStream
-#include <array>                                // for array
-#include <cstdint>                              // for int16_t, uint32_t
+#include "common/RawImage.h"                     // for RawImage
+#include "decompressors/AbstractDecompressor.h"  // for AbstractDecompressor
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex
+#include "io/ByteStream.h"                       // for ByteStream
+#include <array>                                 // for array
+#include <cstdint>                               // for int16_t, uint32_t
 
 namespace rawspeed {
 
@@ -36,15 +37,28 @@ class KodakDecompressor final : public AbstractDecompressor {
   int bps;
   bool uncorrectedRawValues;
 
+  DecodeCheckpointIndex* checkpointIndex = nullptr;
+
   static constexpr int segment_size = 256; // pixels
   using segment = std::array<int16_t, segment_size>;
 
-  segment decodeSegment(uint32_t bsize);
+  static segment decodeSegment(ByteStream* bs, uint32_t bsize);
+
+  // Each row starts at a byte boundary, so the position in the input is the
+  // only state of the decoding. Yet, the dithering has its own state.
+  void decompressRows(ByteStream* bs, int rowBegin, int rowEnd,
+                      uint32_t* random, DecodeCheckpointIndex* recorder) const;
 
 public:
   KodakDecompressor(const RawImage& img, ByteStream bs, int bps,
                     bool uncorrectedRawValues_);
 
+  // If the index was recorded for this input, the rows are decoded in
+  // parallel, else it is (re)recorded during the (serial) decoding.
+  void setCheckpointIndex(DecodeCheckpointIndex* index) {
+    checkpointIndex = index;
+  }
+
   void decompress();
 };
 
@@ -21,13 +21,21 @@
 
 #include "decompressors/LJpegDecompressor.h"
 #include "common/Common.h"                // for unroll_loop, roundUpDivision
+#include "common/ErrorLog.h"              // for ErrorLog
+#include "common/Executor.h"              // for Executor
 #include "common/Point.h"                 // for iPoint2D
+#include "common/PrefixSum.h"             // for interleavedPrefixSum
 #include "common/RawImage.h"              // for RawImage, RawImageData
+#include "common/RawspeedException.h"     // for RawspeedException
 #include "decoders/RawDecoderException.h" // for ThrowRDE
-#include "io/BitPumpJPEG.h"               // for BitPumpJPEG, BitStream<>::...
-#include <algorithm>                      // for copy_n
+#include "io/BitPumpJPEGUnstuffed.h"      // for BitPumpJPEGUnstuffed, Bit...
+#include "io/JpegUnstuffer.h"             // for JpegUnstuffer
+#include <algorithm>                      // for copy_n, min
 #include <array>                          // for array
 #include <cassert>                        // for assert
+#include <cstdint>                        // for int16_t, uint16_t
+#include <string>                         // for string
+#include <vector>                         // for vector
 
 using std::copy_n;
 
@@ -108,6 +116,16 @@ void LJpegDecompressor::decodeScan()
              frame.cps * frame.w, frame.h, tileRequiredWidth, h);
   }
 
+  if (restartInterval != 0) {
+    // Each restart interval must consist of whole rows, which is the only
+    // sane way to use them with LJpeg anyway.
+    if (restartInterval % frame.w != 0) {
+      ThrowRDE("Unsupported restart interval %u for frame width %u",
+               restartInterval, frame.w);
+    }
+    rowsPerRestartInterval = restartInterval / frame.w;
+  }
+
   // How many full pixel blocks will we produce?
   fullBlocks = tileRequiredWidth / frame.cps; // Truncating division!
   // Do we need to also produce part of a block?
@@ -162,12 +180,6 @@ template <int N_COMP, bool WeirdWidth> void LJpegDecompressor::decodeN() {
   assert(mRaw->dim.x >= N_COMP);
   assert((mRaw->getCpp() * (mRaw->dim.x - offX)) >= N_COMP);
 
-  auto ht = getHuffmanTables<N_COMP>();
-  auto pred = getInitialPredictors<N_COMP>();
-  auto predNext = pred.data();
-
-  BitPumpJPEG bitStream(input);
-
   // A recoded DNG might be split up into tiles of self contained LJpeg blobs.
   // The tiles at the bottom and the right may extend beyond the dimension of
   // the raw image buffer. The excessive content has to be ignored.
@@ -178,8 +190,69 @@ template <int N_COMP, bool WeirdWidth> void LJpegDecompressor::decodeN() {
   assert(offY + h <= static_cast<unsigned>(mRaw->dim.y));
   assert(offX + w <= static_cast<unsigned>(mRaw->dim.x));
 
+  if (!restartInterval) {
+    // The byte stuffing is removed beforehand, so the hot loop does not have
+    // to deal with it. That also tells where the next marker is.
+    const JpegUnstuffer unstuffed(input);
+    input.skipBytes(unstuffed.getMarkerPosition());
+    decodeRowsN<N_COMP, WeirdWidth>(unstuffed.getStream(), 0, h);
+    return;
+  }
+
+  // The restart intervals are independent of each other, so once we know
+  // where each one of them starts, they can all be decoded in parallel.
+  assert(rowsPerRestartInterval > 0);
+  std::vector<ByteStream> intervals =
+      getRestartIntervals(roundUpDivision(frame.h, rowsPerRestartInterval));
+  // Only the ones with the rows we need are decoded.
+  intervals.resize(roundUpDivision(h, rowsPerRestartInterval));
+
+  ErrorLog errors;
+  mRaw->getExecutor().parallelForEach(
+      0, intervals.size(), [this, &intervals, &errors](int interval) {
+        try {
+          const auto yBegin =
+              rowsPerRestartInterval * static_cast<uint32_t>(interval);
+          const auto yEnd = std::min(yBegin + rowsPerRestartInterval, h);
+          const JpegUnstuffer unstuffed(intervals[interval]);
+          decodeRowsN<N_COMP, WeirdWidth>(unstuffed.getStream(), yBegin,
+                                          yEnd);
+        } catch (RawspeedException& err) {
+          errors.setError(err.what());
+        }
+      });
+
+  std::string firstErr;
+  if (errors.isTooManyErrors(1, &firstErr)) {
+    ThrowRDE("Too many errors encountered. Giving up. First Error:\n%s",
+             firstErr.c_str());
+  }
+}
+
+template <int N_COMP, bool WeirdWidth>
+void LJpegDecompressor::decodeRowsN(const ByteStream& data, uint32_t yBegin,
+                                    uint32_t yEnd) {
+  assert(yBegin < yEnd);
+  assert(yEnd <= h);
+
+  auto ht = getHuffmanTables<N_COMP>();
+  // Each restart interval starts anew, with the initial predictors.
+  auto pred = getInitialPredictors<N_COMP>();
+  auto predNext = pred.data();
+
+  // If the consecutive components use the same table, the differences can be
+  // decoded two at a time. With a single component, that is two pixels.
+  static constexpr int pixelsPerPairStep = N_COMP == 1 ? 2 : 1;
+  bool pairedTables = N_COMP != 3;
+  for (int i = 0; pairedTables && i + 1 < N_COMP; i += 2)
+    pairedTables = ht[i] == ht[i + 1];
+
+  BitPumpJPEGUnstuffed bitStream(data);
+
+  std::vector<int16_t> diffs(N_COMP * fullBlocks);
+
   // For y, we can simply stop decoding when we reached the border.
-  for (unsigned y = 0; y < h; ++y) {
+  for (unsigned y = yBegin; y < yEnd; ++y) {
     auto destY = offY + y;
     auto* dest =
         reinterpret_cast<uint16_t*>(mRaw->getDataUncropped(offX, destY));
@@ -193,13 +266,30 @@ template <int N_COMP, bool WeirdWidth> void LJpegDecompressor::decodeN() {
     // FIXME: predictor may have value outside of the uint16_t.
     // https://github.com/darktable-org/rawspeed/issues/175
 
-    // For x, we first process all full pixel blocks within the image buffer ...
+    // For x, we first process all full pixel blocks within the image buffer.
+    // The differences of those are entropy-decoded first, so the Huffman
+    // decoding does not have to wait for the reconstruction of the pixels ...
+    int16_t* diff = diffs.data();
+    if (pairedTables) {
+      for (; x + pixelsPerPairStep <= fullBlocks; x += pixelsPerPairStep) {
+        unroll_loop<N_COMP * pixelsPerPairStep / 2>([&](int i) {
+          const auto d = ht[2 * i % N_COMP]->decodeDifferencePair(bitStream);
+          *diff++ = int16_t(d[0]);
+          *diff++ = int16_t(d[1]);
+        });
+      }
+    }
     for (; x < fullBlocks; ++x) {
       unroll_loop<N_COMP>([&](int i) {
-        pred[i] = uint16_t(pred[i] + ht[i]->decodeDifference(bitStream));
-        *dest++ = pred[i];
+        *diff++ = int16_t(ht[i]->decodeDifference(bitStream));
       });
     }
+    assert(diff == diffs.data() + diffs.size());
+
+    // ... and only then all the pixels of those blocks are reconstructed.
+    // The predictor arithmetic is modulo 2^16, so the truncation is harmless.
+    interleavedPrefixSum<N_COMP>(dest, diffs.data(), diffs.size(), &pred);
+    dest += diffs.size();
 
     // Sometimes we also need to consume one more block, and produce part of it.
     if /*constexpr*/ (WeirdWidth) {
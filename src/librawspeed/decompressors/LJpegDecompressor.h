@@ -22,6 +22,7 @@
 
 #include "decompressors/AbstractLJpegDecompressor.h" // for AbstractLJpegDe...
 #include <cstdint>                                   // for uint32_t
+#include <vector>                                    // for vector
 
 namespace rawspeed {
 
@@ -35,6 +36,11 @@ class LJpegDecompressor final : public AbstractLJpegDecompressor
   void decodeScan() override;
   template <int N_COMP, bool WeirdWidth = false> void decodeN();
 
+  // Decodes the rows [yBegin, yEnd) of the tile, from the (stuffed) data
+  // that starts with the row yBegin. yBegin must start a restart interval.
+  template <int N_COMP, bool WeirdWidth>
+  void decodeRowsN(const ByteStream& data, uint32_t yBegin, uint32_t yEnd);
+
   uint32_t offX = 0;
   uint32_t offY = 0;
   uint32_t w = 0;
@@ -43,6 +49,8 @@ class LJpegDecompressor final : public AbstractLJpegDecompressor
   uint32_t fullBlocks = 0;
   uint32_t trailingPixels = 0;
 
+  uint32_t rowsPerRestartInterval = 0;
+
 public:
   LJpegDecompressor(const ByteStream& bs, const RawImage& img);
 
@@ -20,12 +20,14 @@
 
 #pragma once
 
-#include "common/RawImage.h"                    // for RawImage
-#include "decompressors/AbstractDecompressor.h" // for AbstractDecompressor
-#include "io/BitPumpMSB.h"                      // for BitPumpMSB
-#include <array>                                // for array
-#include <cstdint>                              // for uint32_t, uint16_t
-#include <vector>                               // for vector
+#include "common/RawImage.h"                     // for RawImage
+#include "decompressors/AbstractDecompressor.h"  // for AbstractDecompressor
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex
+#include "decompressors/HuffmanTable.h"          // for HuffmanTable
+#include "io/BitPumpMSB.h"                       // for BitPumpMSB
+#include <array>                                 // for array
+#include <cstdint>                               // for uint32_t, uint16_t
+#include <vector>                                // for vector
 
 namespace rawspeed {
 class ByteStream;
@@ -44,11 +46,26 @@ class NikonDecompressor final : public AbstractDecompressor {
 
   std::vector<uint16_t> curve;
 
-  uint32_t random;
+  DecodeCheckpointIndex* checkpointIndex = nullptr;
+
+  // The decoder state at the start of a row.
+  struct State final {
+    std::array<std::array<int, 2>, 2> pUp;
+    uint32_t random;
+
+    static State fromCheckpoint(const DecodeCheckpointIndex::Checkpoint& cp);
+    DecodeCheckpointIndex::Checkpoint toCheckpoint(uint64_t bitPosition) const;
+  };
 
 public:
   NikonDecompressor(const RawImage& raw, ByteStream metadata, uint32_t bitsPS);
 
+  // If the index was recorded for this input, the rows are decoded in
+  // parallel, else it is (re)recorded during the (serial) decoding.
+  void setCheckpointIndex(DecodeCheckpointIndex* index) {
+    checkpointIndex = index;
+  }
+
   void decompress(const ByteStream& data, bool uncorrectedRawValues);
 
 private:
@@ -57,11 +74,14 @@ private:
                                            uint32_t bitsPS, uint32_t v0,
                                            uint32_t v1, uint32_t* split);
 
-  template <typename Huffman>
-  void decompress(BitPumpMSB* bits, int start_y, int end_y);
+  void decompress(BitPumpMSB* bits, int start_y, int end_y, State* state,
+                  DecodeCheckpointIndex* recorder);
+
+  static HuffmanTable createHuffmanTable(uint32_t huffSelect);
+
+  template <uint32_t huffSelect> static const HuffmanTable& getHuffmanTable();
 
-  template <typename Huffman>
-  static Huffman createHuffmanTable(uint32_t huffSelect);
+  static const HuffmanTable& getHuffmanTable(uint32_t huffSelect);
 };
 
 } // namespace rawspeed
@@ -21,16 +21,17 @@
 */
 
 #include "decompressors/OlympusDecompressor.h"
-#include "common/Array2DRef.h"            // for Array2DRef
-#include "common/Point.h"                 // for iPoint2D
-#include "common/RawImage.h"              // for RawImage, RawImageData
-#include "decoders/RawDecoderException.h" // for ThrowRDE
-#include "io/BitPumpMSB.h"                // for BitPumpMSB
-#include "io/ByteStream.h"                // for ByteStream
-#include <array>                          // for array
-#include <cassert>                        // for assert
-#include <cstdlib>                        // for abs
-#include <type_traits>                    // for enable_if_t, is_integral
+#include "common/Array2DRef.h"                   // for Array2DRef
+#include "common/Point.h"                        // for iPoint2D
+#include "common/RawImage.h"                     // for RawImage, RawImageData
+#include "decoders/RawDecoderException.h"        // for ThrowRDE
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex
+#include "io/BitPumpMSB.h"                       // for BitPumpMSB
+#include "io/ByteStream.h"                       // for ByteStream
+#include <array>                                 // for array
+#include <cassert>                               // for assert
+#include <cstdlib>                               // for abs
+#include <type_traits>                           // for enable_if_t, is_integral
 
 namespace {
 
@@ -63,8 +64,10 @@ OlympusDecompressor::OlympusDecompressor(const RawImage& img) : mRaw(img) {
 /* This is probably the slowest decoder of them all.
  * I cannot see any way to effectively speed up the prediction
  * phase, which is by far the slowest part of this algorithm.
- * Also there is no way to multithread this code, since prediction
- * is based on the output of all previous pixel (bar the first four)
+ * Also there is no way to multithread the prediction, since it
+ * is based on the output of all previous pixel (bar the first four).
+ * The carries are reset at each row though, so given a checkpoint
+ * index, the rows can be entropy-decoded in parallel.
  */
 
 inline __attribute__((always_inline)) int
@@ -153,16 +156,72 @@ void OlympusDecompressor::decompressRow(BitPumpMSB* bits, int row) const {
   }
 }
 
+void OlympusDecompressor::decodeDifferencesRow(BitPumpMSB* bits,
+                                               int row) const {
+  const Array2DRef<uint16_t> out(mRaw->getU16DataAsUncroppedArray2DRef());
+
+  std::array<std::array<int, 3>, 2> acarry{{}};
+
+  for (int col = 0; col < out.width; col++) {
+    std::array<int, 3>& carry = acarry[col & 1];
+    out(row, col) = parseCarry(bits, &carry);
+  }
+}
+
+void OlympusDecompressor::predictRow(int row) const {
+  const Array2DRef<uint16_t> out(mRaw->getU16DataAsUncroppedArray2DRef());
+
+  for (int col = 0; col < out.width; col++)
+    out(row, col) += getPred(out, row, col);
+}
+
 void OlympusDecompressor::decompress(ByteStream input) const {
   assert(mRaw->dim.y > 0);
   assert(mRaw->dim.x > 0);
   assert(mRaw->dim.x % 2 == 0);
 
   input.skipBytes(7);
+
+  if (checkpointIndex &&
+      checkpointIndex->isUsableFor(DecodeCheckpointIndex::Format::OLYMPUS,
+                                   /*variant=*/0, input.getRemainSize(),
+                                   mRaw->dim.y)) {
+    checkpointIndex->decodeInParallel(
+        &mRaw->getExecutor(),
+        [this, &input](const DecodeCheckpointIndex::Checkpoint& cp,
+                       int lineBegin, int lineEnd) {
+          BitPumpMSB bits =
+              DecodeCheckpointIndex::resumePump<BitPumpMSB>(input,
+                                                            cp.bitPosition);
+          for (int y = lineBegin; y < lineEnd; y++)
+            decodeDifferencesRow(&bits, y);
+          return DecodeCheckpointIndex::getResumedBitPosition(bits,
+                                                              cp.bitPosition);
+        });
+
+    for (int y = 0; y < mRaw->dim.y; y++)
+      predictRow(y);
+    return;
+  }
+
   BitPumpMSB bits(input);
 
-  for (int y = 0; y < mRaw->dim.y; y++)
+  if (checkpointIndex) {
+    checkpointIndex->startRecording(DecodeCheckpointIndex::Format::OLYMPUS,
+                                    /*variant=*/0, input.getRemainSize(),
+                                    mRaw->dim.y);
+  }
+
+  for (int y = 0; y < mRaw->dim.y; y++) {
+    // The carries are reset at each row, only the position needs saving.
+    if (checkpointIndex && checkpointIndex->isCheckpointLine(y)) {
+      DecodeCheckpointIndex::Checkpoint cp;
+      cp.bitPosition = bits.getBitPosition();
+      checkpointIndex->record(y, cp);
+    }
+
     decompressRow(&bits, y);
+  }
 }
 
 } // namespace rawspeed
@@ -20,14 +20,15 @@
 
 #pragma once
 
-#include "common/Common.h"                      // for extractHighBits
-#include "common/RawImage.h"                    // for RawImage
-#include "common/SimpleLUT.h"                   // for SimpleLUT<>::value_type
-#include "decompressors/AbstractDecompressor.h" // for AbstractDecompressor
-#include "io/BitPumpMSB.h"                      // for BitPumpMSB
-#include <algorithm>                            // for min
-#include <array>                                // for array
-#include <cstdint>                              // for uint16_t
+#include "common/Common.h"                       // for extractHighBits
+#include "common/RawImage.h"                     // for RawImage
+#include "common/SimpleLUT.h"                    // for SimpleLUT<>::value_type
+#include "decompressors/AbstractDecompressor.h"  // for AbstractDecompressor
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex
+#include "io/BitPumpMSB.h"                       // for BitPumpMSB
+#include <algorithm>                             // for min
+#include <array>                                 // for array
+#include <cstdint>                               // for uint16_t
 
 namespace rawspeed {
 
@@ -38,6 +39,8 @@ template <class T> class Array2DRef;
 class OlympusDecompressor final : public AbstractDecompressor {
   RawImage mRaw;
 
+  DecodeCheckpointIndex* checkpointIndex = nullptr;
+
   // A table to quickly look up "high" value
   const SimpleLUT<char, 12> bittable{[](unsigned i, unsigned tableSize) {
     int high;
@@ -54,8 +57,21 @@ class OlympusDecompressor final : public AbstractDecompressor {
 
   void decompressRow(BitPumpMSB* bits, int row) const;
 
+  // Only entropy-decodes the row, storing the differences (modulo 2^16).
+  void decodeDifferencesRow(BitPumpMSB* bits, int row) const;
+
+  // Adds the predictions to the differences stored by decodeDifferencesRow().
+  void predictRow(int row) const;
+
 public:
   explicit OlympusDecompressor(const RawImage& img);
+
+  // If the index was recorded for this input, the rows are entropy-decoded
+  // in parallel, else it is (re)recorded during the (serial) decoding.
+  void setCheckpointIndex(DecodeCheckpointIndex* index) {
+    checkpointIndex = index;
+  }
+
   void decompress(ByteStream input) const;
 };
 
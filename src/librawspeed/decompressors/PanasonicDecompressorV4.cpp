@@ -20,10 +20,10 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
-#include "rawspeedconfig.h" // for HAVE_OPENMP
 #include "decompressors/PanasonicDecompressorV4.h"
 #include "common/Array2DRef.h"            // for Array2DRef
-#include "common/Common.h"                // for extractHighBits, rawspeed_...
+#include "common/Common.h"                // for extractHighBits, roundUp
+#include "common/Executor.h"              // for Executor
 #include "common/Mutex.h"                 // for MutexLocker
 #include "common/Point.h"                 // for iPoint2D
 #include "common/RawImage.h"              // for RawImage, RawImageData
@@ -97,8 +97,8 @@ void PanasonicDecompressorV4::chopInputIntoBlocks() {
   std::generate_n(std::back_inserter(blocks), blocksTotal,
                   [input = &input, &currPixel, pixelToCoordinate]() -> Block {
                     assert(input->getRemainSize() != 0);
-                    const auto blockSize =
-                        std::min(input->getRemainSize(), BlockSize);
+                    const auto blockSize = std::min<Buffer::size_type>(
+                        input->getRemainSize(), BlockSize);
                     assert(blockSize > 0);
                     assert(blockSize % BytesPerPacket == 0);
                     const auto packets = blockSize / BytesPerPacket;
@@ -235,15 +235,12 @@ void PanasonicDecompressorV4::processBlock(
   }
 }
 
-void PanasonicDecompressorV4::decompressThread() const noexcept {
+void PanasonicDecompressorV4::decompressThread(int begin,
+                                               int end) const noexcept {
   std::vector<uint32_t> zero_pos;
 
-  assert(!blocks.empty());
-
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static)
-#endif
-  for (auto block = blocks.cbegin(); block < blocks.cend(); ++block)
+  for (auto block = blocks.cbegin() + begin; block < blocks.cbegin() + end;
+       ++block)
     processBlock(*block, &zero_pos);
 
   if (zero_is_bad && !zero_pos.empty()) {
@@ -255,11 +252,10 @@ void PanasonicDecompressorV4::decompressThread() const noexcept {
 
 void PanasonicDecompressorV4::decompress() const noexcept {
   assert(!blocks.empty());
-#ifdef HAVE_OPENMP
-#pragma omp parallel default(none)                                             \
-    num_threads(rawspeed_get_number_of_processor_cores())
-#endif
-  decompressThread();
+  Executor& executor = mRaw->getExecutor();
+  executor.parallelFor(
+      0, blocks.size(), executor.getGrainSize(blocks.size()),
+      [this](int begin, int end) { decompressThread(begin, end); });
 }
 
 } // namespace rawspeed
@@ -80,7 +80,7 @@ class PanasonicDecompressorV4 final : public AbstractDecompressor {
   void processBlock(const Block& block, std::vector<uint32_t>* zero_pos) const
       noexcept;
 
-  void decompressThread() const noexcept;
+  void decompressThread(int begin, int end) const noexcept;
 
 public:
   PanasonicDecompressorV4(const RawImage& img, const ByteStream& input_,
@@ -20,10 +20,10 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
-#include "rawspeedconfig.h" // for HAVE_OPENMP
 #include "decompressors/PanasonicDecompressorV5.h"
 #include "common/Array2DRef.h"            // for Array2DRef
-#include "common/Common.h"                // for rawspeed_get_number_of_pro...
+#include "common/Common.h"                // for roundUpDivision
+#include "common/Executor.h"              // for Executor
 #include "common/Point.h"                 // for iPoint2D
 #include "common/RawImage.h"              // for RawImage, RawImageData
 #include "decoders/RawDecoderException.h" // for ThrowRDE
@@ -224,15 +224,14 @@ void PanasonicDecompressorV5::processBlock(const Block& block) const {
 
 template <const PanasonicDecompressorV5::PacketDsc& dsc>
 void PanasonicDecompressorV5::decompressInternal() const noexcept {
-#ifdef HAVE_OPENMP
-#pragma omp parallel for num_threads(rawspeed_get_number_of_processor_cores()) \
-    schedule(static) default(none)
-#endif
-  for (auto block = blocks.cbegin(); block < blocks.cend();
-       ++block) { // NOLINT(openmp-exception-escape): we have checked size
-                  // already.
-    processBlock<dsc>(*block);
-  }
+  Executor& executor = mRaw->getExecutor();
+  executor.parallelFor(0, blocks.size(), executor.getGrainSize(blocks.size()),
+                       [this](int begin, int end) {
+                         // We have checked the size already, so no
+                         // exceptions will be thrown.
+                         for (int block = begin; block < end; ++block)
+                           processBlock<dsc>(blocks[block]);
+                       });
 }
 
 void PanasonicDecompressorV5::decompress() const noexcept {
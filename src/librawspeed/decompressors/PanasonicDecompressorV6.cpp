@@ -19,14 +19,14 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
-#include "rawspeedconfig.h" // for HAVE_OPENMP
 #include "decompressors/PanasonicDecompressorV6.h"
 #include "common/Array2DRef.h"            // for Array2DRef
-#include "common/Common.h"                // for rawspeed_get_number_of_pro...
+#include "common/Executor.h"              // for Executor
 #include "common/Point.h"                 // for iPoint2D
 #include "common/RawImage.h"              // for RawImageData, RawImage
 #include "common/RawspeedException.h"     // for RawspeedException
 #include "decoders/RawDecoderException.h" // for ThrowRDE
+#include "io/ByteCursor.h"                // for ByteCursor
 #include <array>                          // for array
 #include <cassert>                        // for assert
 #include <cstdint>                        // for uint16_t
@@ -43,7 +43,7 @@ struct pana_cs6_page_decoder {
   std::array<uint16_t, 14> pixelbuffer;
   unsigned char current = 0;
 
-  explicit pana_cs6_page_decoder(const ByteStream& bs) {
+  explicit pana_cs6_page_decoder(const ByteCursor& bs) {
     // The bit packing scheme here is actually just 128-bit little-endian int,
     // that we consume from the high bits to low bits, with no padding.
     // It is really tempting to refactor this using proper BitPump, but so far
@@ -116,12 +116,12 @@ PanasonicDecompressorV6::PanasonicDecompressorV6(const RawImage& img,
 
 inline void __attribute__((always_inline))
 // NOLINTNEXTLINE(bugprone-exception-escape): no exceptions will be thrown.
-PanasonicDecompressorV6::decompressBlock(ByteStream* rowInput, int row,
+PanasonicDecompressorV6::decompressBlock(ByteCursor* rowInput, int row,
                                          int col) const noexcept {
   const Array2DRef<uint16_t> out(mRaw->getU16DataAsUncroppedArray2DRef());
 
   pana_cs6_page_decoder page(
-      rowInput->getStream(PanasonicDecompressorV6::BytesPerBlock));
+      rowInput->getCursor(PanasonicDecompressorV6::BytesPerBlock));
 
   std::array<unsigned, 2> oddeven = {0, 0};
   std::array<unsigned, 2> nonzero = {0, 0};
@@ -166,22 +166,21 @@ void PanasonicDecompressorV6::decompressRow(int row) const noexcept {
       mRaw->dim.x / PanasonicDecompressorV6::PixelsPerBlock;
   const int bytesPerRow = PanasonicDecompressorV6::BytesPerBlock * blocksperrow;
 
-  ByteStream rowInput = input.getSubStream(bytesPerRow * row, bytesPerRow);
+  ByteCursor rowInput =
+      input.getSubStream(bytesPerRow * row).peekCursor(bytesPerRow);
   for (int rblock = 0, col = 0; rblock < blocksperrow;
        rblock++, col += PanasonicDecompressorV6::PixelsPerBlock)
     decompressBlock(&rowInput, row, col);
 }
 
 void PanasonicDecompressorV6::decompress() const {
-#ifdef HAVE_OPENMP
-#pragma omp parallel for num_threads(rawspeed_get_number_of_processor_cores()) \
-    schedule(static) default(none)
-#endif
-  for (int row = 0; row < mRaw->dim.y;
-       ++row) { // NOLINT(openmp-exception-escape): we know no exceptions will
-                // be thrown.
-    decompressRow(row);
-  }
+  Executor& executor = mRaw->getExecutor();
+  executor.parallelFor(0, mRaw->dim.y, executor.getGrainSize(mRaw->dim.y),
+                       [this](int rowBegin, int rowEnd) {
+                         // We know no exceptions will be thrown.
+                         for (int row = rowBegin; row < rowEnd; ++row)
+                           decompressRow(row);
+                       });
 }
 
 } // namespace rawspeed
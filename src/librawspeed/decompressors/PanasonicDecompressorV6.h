@@ -22,6 +22,7 @@
 
 #include "common/RawImage.h"                    // for RawImage
 #include "decompressors/AbstractDecompressor.h" // for AbstractDecompressor
+#include "io/ByteCursor.h"                      // for ByteCursor
 #include "io/ByteStream.h"                      // for ByteStream
 
 namespace rawspeed {
@@ -36,7 +37,7 @@ class PanasonicDecompressorV6 final : public AbstractDecompressor {
 
   inline void __attribute__((always_inline))
   // NOLINTNEXTLINE(bugprone-exception-escape): no exceptions will be thrown.
-  decompressBlock(ByteStream* rowInput, int row, int col) const noexcept;
+  decompressBlock(ByteCursor* rowInput, int row, int col) const noexcept;
 
   // NOLINTNEXTLINE(bugprone-exception-escape): no exceptions will be thrown.
   void decompressRow(int row) const noexcept;
@@ -30,6 +30,7 @@
 #include "io/ByteStream.h"                // for ByteStream
 #include <cassert>                        // for assert
 #include <cstdint>                        // for uint8_t, uint32_t, uint16_t
+#include <memory>                         // for shared_ptr, make_shared
 #include <vector>                         // for vector
 
 namespace rawspeed {
@@ -125,15 +126,20 @@ HuffmanTable PentaxDecompressor::SetupHuffmanTable_Modern(ByteStream stream) {
   return ht;
 }
 
-HuffmanTable PentaxDecompressor::SetupHuffmanTable(ByteStream* metaData) {
-  HuffmanTable ht;
-
-  if (metaData)
-    ht = SetupHuffmanTable_Modern(*metaData);
-  else
-    ht = SetupHuffmanTable_Legacy();
+std::shared_ptr<const HuffmanTable>
+PentaxDecompressor::SetupHuffmanTable(ByteStream* metaData) {
+  if (!metaData) {
+    // The legacy table is fixed, so it only needs to be set up once.
+    static const std::shared_ptr<const HuffmanTable> legacy = []() {
+      auto ht = std::make_shared<HuffmanTable>(SetupHuffmanTable_Legacy());
+      ht->setup(true, false);
+      return ht;
+    }();
+    return legacy;
+  }
 
-  ht.setup(true, false);
+  auto ht = std::make_shared<HuffmanTable>(SetupHuffmanTable_Modern(*metaData));
+  ht->setup(true, false);
 
   return ht;
 }
@@ -151,12 +157,16 @@ void PentaxDecompressor::decompress(const ByteStream& data) const {
     if (row >= 2)
       pred = {out(row - 2, 0), out(row - 2, 1)};
 
-    for (int col = 0; col < out.width; col++) {
-      pred[col & 1] += ht.decodeDifference(bs);
-      int value = pred[col & 1];
-      if (!isIntN(value, 16))
-        ThrowRDE("decoded value out of bounds at %d:%d", col, row);
-      out(row, col) = value;
+    // The two pixels of each pair use the same table, decode them together.
+    for (int col = 0; col < out.width; col += 2) {
+      const std::array<int, 2> diffs = ht->decodeDifferencePair(bs);
+      for (int c = 0; c < 2; c++) {
+        pred[c] += diffs[c];
+        int value = pred[c];
+        if (!isIntN(value, 16))
+          ThrowRDE("decoded value out of bounds at %d:%d", col + c, row);
+        out(row, col + c) = value;
+      }
     }
   }
 }
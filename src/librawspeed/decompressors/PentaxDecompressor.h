@@ -26,6 +26,7 @@
 #include "decompressors/HuffmanTable.h"         // for HuffmanTable
 #include <array>                                // for array
 #include <cstdint>                              // for uint8_t
+#include <memory>                               // for shared_ptr
 
 namespace rawspeed {
 
@@ -33,7 +34,7 @@ class ByteStream;
 
 class PentaxDecompressor final : public AbstractDecompressor {
   RawImage mRaw;
-  const HuffmanTable ht;
+  const std::shared_ptr<const HuffmanTable> ht;
 
 public:
   PentaxDecompressor(const RawImage& img, ByteStream* metaData);
@@ -43,7 +44,8 @@ public:
 private:
   static HuffmanTable SetupHuffmanTable_Legacy();
   static HuffmanTable SetupHuffmanTable_Modern(ByteStream stream);
-  static HuffmanTable SetupHuffmanTable(ByteStream* metaData);
+  static std::shared_ptr<const HuffmanTable>
+  SetupHuffmanTable(ByteStream* metaData);
 
   static const std::array<std::array<std::array<uint8_t, 16>, 2>, 1>
       pentax_tree;
@@ -20,10 +20,9 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
-#include "rawspeedconfig.h" // for HAVE_OPENMP
 #include "decompressors/PhaseOneDecompressor.h"
 #include "common/Array2DRef.h"            // for Array2DRef
-#include "common/Common.h"                // for rawspeed_get_number_of_pro...
+#include "common/Executor.h"              // for getLargestFirstOrder, Exe...
 #include "common/Point.h"                 // for iPoint2D
 #include "common/RawImage.h"              // for RawImageData, RawImage
 #include "common/RawspeedException.h"     // for RawspeedException
@@ -134,26 +133,27 @@ void PhaseOneDecompressor::decompressStrip(const PhaseOneStrip& strip) const {
   }
 }
 
-void PhaseOneDecompressor::decompressThread() const noexcept {
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static)
-#endif
-  for (auto strip = strips.cbegin(); strip < strips.cend(); ++strip) {
+void PhaseOneDecompressor::decompressThread(const std::vector<int>& order,
+                                            int begin, int end) const noexcept {
+  for (int i = begin; i < end; ++i) {
+    const PhaseOneStrip* strip = &strips[order[i]];
     try {
       decompressStrip(*strip);
     } catch (RawspeedException& err) {
-      // Propagate the exception out of OpenMP magic.
       mRaw->setError(err.what());
     }
   }
 }
 
 void PhaseOneDecompressor::decompress() const {
-#ifdef HAVE_OPENMP
-#pragma omp parallel default(none)                                             \
-    num_threads(rawspeed_get_number_of_processor_cores())
-#endif
-  decompressThread();
+  // The strips are rows, but some compress better than the others.
+  const std::vector<int> order = getLargestFirstOrder(
+      strips, [](const PhaseOneStrip& strip) { return strip.bs.getSize(); });
+
+  mRaw->getExecutor().parallelFor(0, order.size(), /*grainSize=*/1,
+                                  [this, &order](int begin, int end) {
+                                    decompressThread(order, begin, end);
+                                  });
 
   std::string firstErr;
   if (mRaw->isTooManyErrors(1, &firstErr)) {
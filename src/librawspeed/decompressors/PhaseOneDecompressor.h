@@ -45,7 +45,9 @@ class PhaseOneDecompressor final : public AbstractDecompressor {
 
   void decompressStrip(const PhaseOneStrip& strip) const;
 
-  void decompressThread() const noexcept;
+  // Decodes the strips order[begin], ..., order[end - 1].
+  void decompressThread(const std::vector<int>& order, int begin,
+                        int end) const noexcept;
 
   void prepareStrips();
 
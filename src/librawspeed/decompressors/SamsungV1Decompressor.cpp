@@ -21,17 +21,19 @@
 */
 
 #include "decompressors/SamsungV1Decompressor.h"
-#include "common/Array2DRef.h"            // for Array2DRef
-#include "common/Common.h"                // for isIntN
-#include "common/Point.h"                 // for iPoint2D
-#include "common/RawImage.h"              // for RawImage, RawImageData
-#include "decoders/RawDecoderException.h" // for ThrowRDE
-#include "decompressors/HuffmanTable.h"   // for HuffmanTable
-#include "io/BitPumpMSB.h"                // for BitPumpMSB
-#include <array>                          // for array
-#include <cassert>                        // for assert
-#include <memory>                         // for allocator_traits<>::value_...
-#include <vector>                         // for vector
+#include "common/Array2DRef.h"                   // for Array2DRef
+#include "common/Common.h"                       // for isIntN
+#include "common/Point.h"                        // for iPoint2D
+#include "common/RawImage.h"                     // for RawImage, RawImageData
+#include "decoders/RawDecoderException.h"        // for ThrowRDE
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex
+#include "decompressors/HuffmanTable.h"          // for HuffmanTable
+#include "io/BitPumpMSB.h"                       // for BitPumpMSB
+#include "io/ByteStream.h"                       // for ByteStream
+#include <array>                                 // for array
+#include <cassert>                               // for assert
+#include <memory>                                // for allocator_traits<>::v...
+#include <vector>                                // for vector
 
 namespace rawspeed {
 
@@ -80,6 +82,36 @@ SamsungV1Decompressor::samsungDiff(BitPumpMSB* pump,
   return diff;
 }
 
+void SamsungV1Decompressor::decompressRows(
+    BitPumpMSB* pump, const std::vector<encTableItem>& tbl, int rowBegin,
+    int rowEnd, Predictors* up, DecodeCheckpointIndex* recorder) const {
+  const Array2DRef<uint16_t> out(mRaw->getU16DataAsUncroppedArray2DRef());
+
+  for (int row = rowBegin; row < rowEnd; row++) {
+    if (recorder && recorder->isCheckpointLine(row)) {
+      DecodeCheckpointIndex::Checkpoint cp;
+      cp.bitPosition = pump->getBitPosition();
+      cp.state = {{(*up)[0][0], (*up)[0][1], (*up)[1][0], (*up)[1][1]}};
+      recorder->record(row, cp);
+    }
+
+    std::array<int, 2> pred = (*up)[row & 1];
+
+    for (int col = 0; col < out.width; col++) {
+      int32_t diff = samsungDiff(pump, tbl);
+      pred[col & 1] += diff;
+
+      int value = pred[col & 1];
+      if (!isIntN(value, bits))
+        ThrowRDE("decoded value out of bounds");
+      out(row, col) = value;
+
+      if (col < 2)
+        (*up)[row & 1][col] = value;
+    }
+  }
+}
+
 void SamsungV1Decompressor::decompress() {
   // This format has a variable length encoding of how many bits are needed
   // to encode the difference between pixels, we use a table to process it
@@ -119,25 +151,44 @@ void SamsungV1Decompressor::decompress() {
     }
   }
 
-  const Array2DRef<uint16_t> out(mRaw->getU16DataAsUncroppedArray2DRef());
-  assert(out.width % 32 == 0 && "Should have even count of pixels per row.");
-  assert(out.height % 2 == 0 && "Should have even row count.");
-  BitPumpMSB pump(*bs);
-  for (int row = 0; row < out.height; row++) {
-    std::array<int, 2> pred = {{}};
-    if (row >= 2)
-      pred = {out(row - 2, 0), out(row - 2, 1)};
-
-    for (int col = 0; col < out.width; col++) {
-      int32_t diff = samsungDiff(&pump, tbl);
-      pred[col & 1] += diff;
+  assert(mRaw->dim.x % 32 == 0 && "Should have even count of pixels per row.");
+  assert(mRaw->dim.y % 2 == 0 && "Should have even row count.");
+
+  if (checkpointIndex &&
+      checkpointIndex->isUsableFor(DecodeCheckpointIndex::Format::SAMSUNG_V1,
+                                   /*variant=*/0, bs->getRemainSize(),
+                                   mRaw->dim.y)) {
+    checkpointIndex->decodeInParallel(
+        &mRaw->getExecutor(),
+        [this, &tbl](const DecodeCheckpointIndex::Checkpoint& cp,
+                     int rowBegin, int rowEnd) {
+          BitPumpMSB pump =
+              DecodeCheckpointIndex::resumePump<BitPumpMSB>(*bs,
+                                                            cp.bitPosition);
+          // The index is untrusted input, but the predictors are decoded
+          // values, so they are within bounds too.
+          for (int i = 0; i < 4; ++i) {
+            if (!isIntN(cp.state[i], bits))
+              ThrowRDE("Predictor out of bounds: %i", cp.state[i]);
+          }
+          Predictors up = {
+              {{cp.state[0], cp.state[1]}, {cp.state[2], cp.state[3]}}};
+          decompressRows(&pump, tbl, rowBegin, rowEnd, &up, nullptr);
+          return DecodeCheckpointIndex::getResumedBitPosition(pump,
+                                                              cp.bitPosition);
+        });
+    return;
+  }
 
-      int value = pred[col & 1];
-      if (!isIntN(value, bits))
-        ThrowRDE("decoded value out of bounds");
-      out(row, col) = value;
-    }
+  if (checkpointIndex) {
+    checkpointIndex->startRecording(DecodeCheckpointIndex::Format::SAMSUNG_V1,
+                                    /*variant=*/0, bs->getRemainSize(),
+                                    mRaw->dim.y);
   }
+
+  BitPumpMSB pump(*bs);
+  Predictors up = {{}};
+  decompressRows(&pump, tbl, 0, mRaw->dim.y, &up, checkpointIndex);
 }
 
 } // namespace rawspeed
@@ -21,7 +21,9 @@
 #pragma once
 
 #include "decompressors/AbstractSamsungDecompressor.h" // for AbstractSamsu...
+#include "decompressors/DecodeCheckpointIndex.h"       // for DecodeCheckp...
 #include "io/BitPumpMSB.h"                             // for BitPumpMSB
+#include <array>                                       // for array
 #include <cstdint>                                     // for int32_t
 #include <vector>                                      // for vector
 
@@ -40,9 +42,25 @@ class SamsungV1Decompressor final : public AbstractSamsungDecompressor {
   const ByteStream* bs;
   static constexpr int bits = 12;
 
+  DecodeCheckpointIndex* checkpointIndex = nullptr;
+
+  // The first two values of the previous two rows (by row parity), which are
+  // the initial predictors of the row.
+  using Predictors = std::array<std::array<int, 2>, 2>;
+
+  void decompressRows(BitPumpMSB* pump, const std::vector<encTableItem>& tbl,
+                      int rowBegin, int rowEnd, Predictors* up,
+                      DecodeCheckpointIndex* recorder) const;
+
 public:
   SamsungV1Decompressor(const RawImage& image, const ByteStream* bs_, int bit);
 
+  // If the index was recorded for this input, the rows are decoded in
+  // parallel, else it is (re)recorded during the (serial) decoding.
+  void setCheckpointIndex(DecodeCheckpointIndex* index) {
+    checkpointIndex = index;
+  }
+
   void decompress();
 };
 
@@ -21,14 +21,16 @@
 */
 
 #include "decompressors/SonyArw1Decompressor.h"
-#include "common/Array2DRef.h"            // for Array2DRef
-#include "common/Common.h"                // for isIntN
-#include "common/Point.h"                 // for iPoint2D
-#include "common/RawImage.h"              // for RawImage, RawImageData
-#include "decoders/RawDecoderException.h" // for ThrowRDE
-#include "decompressors/HuffmanTable.h"   // for HuffmanTable
-#include "io/BitPumpMSB.h"                // for BitPumpMSB
-#include <cassert>                        // for assert
+#include "common/Array2DRef.h"                   // for Array2DRef
+#include "common/Common.h"                       // for isIntN
+#include "common/Point.h"                        // for iPoint2D
+#include "common/RawImage.h"                     // for RawImage, RawImageData
+#include "decoders/RawDecoderException.h"        // for ThrowRDE
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex
+#include "decompressors/HuffmanTable.h"          // for HuffmanTable
+#include "io/BitPumpMSB.h"                       // for BitPumpMSB
+#include "io/ByteStream.h"                       // for ByteStream
+#include <cassert>                               // for assert
 
 namespace rawspeed {
 
@@ -51,39 +53,86 @@ inline int SonyArw1Decompressor::getDiff(BitPumpMSB* bs, uint32_t len) {
   return HuffmanTable::extend(diff, len);
 }
 
-void SonyArw1Decompressor::decompress(const ByteStream& input) const {
+void SonyArw1Decompressor::decompressLines(
+    BitPumpMSB* bits, int lineBegin, int lineEnd, int* pred,
+    DecodeCheckpointIndex* recorder) const {
   const Array2DRef<uint16_t> out(mRaw->getU16DataAsUncroppedArray2DRef());
-  assert(out.width > 0);
-  assert(out.height > 0);
-  assert(out.height % 2 == 0);
 
-  BitPumpMSB bits(input);
-  int pred = 0;
-  for (int col = out.width - 1; col >= 0; col--) {
+  int p = *pred;
+  for (int line = lineBegin; line < lineEnd; line++) {
+    if (recorder && recorder->isCheckpointLine(line)) {
+      DecodeCheckpointIndex::Checkpoint cp;
+      cp.bitPosition = bits->getBitPosition();
+      cp.state[0] = p;
+      recorder->record(line, cp);
+    }
+
+    const int col = out.width - 1 - line;
     for (int row = 0; row < out.height + 1; row += 2) {
-      bits.fill(32);
+      bits->fill(32);
 
       if (row == out.height)
         row = 1;
 
-      uint32_t len = 4 - bits.getBitsNoFill(2);
+      uint32_t len = 4 - bits->getBitsNoFill(2);
 
-      if (len == 3 && bits.getBitsNoFill(1))
+      if (len == 3 && bits->getBitsNoFill(1))
         len = 0;
 
       if (len == 4)
-        while (len < 17 && !bits.getBitsNoFill(1))
+        while (len < 17 && !bits->getBitsNoFill(1))
           len++;
 
-      int diff = getDiff(&bits, len);
-      pred += diff;
+      int diff = getDiff(bits, len);
+      p += diff;
 
-      if (!isIntN(pred, 12))
+      if (!isIntN(p, 12))
         ThrowRDE("Error decompressing");
 
-      out(row, col) = pred;
+      out(row, col) = p;
     }
   }
+  *pred = p;
+}
+
+void SonyArw1Decompressor::decompress(const ByteStream& input) const {
+  assert(mRaw->dim.x > 0);
+  assert(mRaw->dim.y > 0);
+  assert(mRaw->dim.y % 2 == 0);
+
+  const int lines = mRaw->dim.x;
+
+  if (checkpointIndex &&
+      checkpointIndex->isUsableFor(DecodeCheckpointIndex::Format::SONY_ARW1,
+                                   /*variant=*/0, input.getRemainSize(),
+                                   lines)) {
+    checkpointIndex->decodeInParallel(
+        &mRaw->getExecutor(),
+        [this, &input](const DecodeCheckpointIndex::Checkpoint& cp,
+                       int lineBegin, int lineEnd) {
+          BitPumpMSB bits =
+              DecodeCheckpointIndex::resumePump<BitPumpMSB>(input,
+                                                            cp.bitPosition);
+          // The index is untrusted input. The predictor is a decoded value.
+          int pred = cp.state[0];
+          if (!isIntN(pred, 12))
+            ThrowRDE("Predictor out of bounds: %i", pred);
+          decompressLines(&bits, lineBegin, lineEnd, &pred, nullptr);
+          return DecodeCheckpointIndex::getResumedBitPosition(bits,
+                                                              cp.bitPosition);
+        });
+    return;
+  }
+
+  if (checkpointIndex) {
+    checkpointIndex->startRecording(DecodeCheckpointIndex::Format::SONY_ARW1,
+                                    /*variant=*/0, input.getRemainSize(),
+                                    lines);
+  }
+
+  BitPumpMSB bits(input);
+  int pred = 0;
+  decompressLines(&bits, 0, lines, &pred, checkpointIndex);
 }
 
 } // namespace rawspeed
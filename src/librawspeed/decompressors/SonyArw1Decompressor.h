@@ -20,10 +20,11 @@
 
 #pragma once
 
-#include "common/RawImage.h"                    // for RawImage
-#include "decompressors/AbstractDecompressor.h" // for AbstractDecompressor
-#include "io/BitPumpMSB.h"                      // for BitPumpMSB
-#include <cstdint>                              // for uint32_t
+#include "common/RawImage.h"                     // for RawImage
+#include "decompressors/AbstractDecompressor.h"  // for AbstractDecompressor
+#include "decompressors/DecodeCheckpointIndex.h" // for DecodeCheckpointIndex
+#include "io/BitPumpMSB.h"                       // for BitPumpMSB
+#include <cstdint>                               // for uint32_t
 
 namespace rawspeed {
 
@@ -32,10 +33,24 @@ class ByteStream;
 class SonyArw1Decompressor final : public AbstractDecompressor {
   RawImage mRaw;
 
+  DecodeCheckpointIndex* checkpointIndex = nullptr;
+
   inline static int getDiff(BitPumpMSB* bs, uint32_t len);
 
+  // The image is stored column by column, starting with the last column,
+  // so the lines here are columns, in the order they are stored.
+  void decompressLines(BitPumpMSB* bits, int lineBegin, int lineEnd, int* pred,
+                       DecodeCheckpointIndex* recorder) const;
+
 public:
   explicit SonyArw1Decompressor(const RawImage& img);
+
+  // If the index was recorded for this input, the columns are decoded in
+  // parallel, else it is (re)recorded during the (serial) decoding.
+  void setCheckpointIndex(DecodeCheckpointIndex* index) {
+    checkpointIndex = index;
+  }
+
   void decompress(const ByteStream& input) const;
 };
 
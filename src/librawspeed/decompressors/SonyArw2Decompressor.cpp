@@ -20,18 +20,15 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
-#include "rawspeedconfig.h" // for HAVE_OPENMP
 #include "decompressors/SonyArw2Decompressor.h"
 #include "common/Array2DRef.h"            // for Array2DRef
-#include "common/Common.h"                // for rawspeed_get_number_of_pro...
+#include "common/Executor.h"              // for Executor
 #include "common/Point.h"                 // for iPoint2D
 #include "common/RawImage.h"              // for RawImageData, RawImage
-#include "common/RawspeedException.h"     // for RawspeedException
 #include "decoders/RawDecoderException.h" // for ThrowRDE
 #include "io/BitPumpLSB.h"                // for BitPumpLSB
 #include <cassert>                        // for assert
 #include <cstdint>                        // for uint16_t, uint32_t, uint8_t
-#include <string>                         // for string
 
 namespace rawspeed {
 
@@ -107,39 +104,19 @@ void SonyArw2Decompressor::decompressRow(int row) const {
   }
 }
 
-void SonyArw2Decompressor::decompressThread() const noexcept {
+void SonyArw2Decompressor::decompress() const {
   assert(mRaw->dim.x > 0);
   assert(mRaw->dim.x % 32 == 0);
   assert(mRaw->dim.y > 0);
 
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static)
-#endif
-  for (int y = 0; y < mRaw->dim.y; y++) {
-    try {
-      decompressRow(y);
-    } catch (RawspeedException& err) {
-      // Propagate the exception out of OpenMP magic.
-      mRaw->setError(err.what());
-#ifdef HAVE_OPENMP
-#pragma omp cancel for
-#endif
-    }
-  }
-}
-
-void SonyArw2Decompressor::decompress() const {
-#ifdef HAVE_OPENMP
-#pragma omp parallel default(none)                                             \
-    num_threads(rawspeed_get_number_of_processor_cores())
-#endif
-  decompressThread();
-
-  std::string firstErr;
-  if (mRaw->isTooManyErrors(1, &firstErr)) {
-    ThrowRDE("Too many errors encountered. Giving up. First Error:\n%s",
-             firstErr.c_str());
-  }
+  // If any of the rows is bad, the rows that are yet to be decoded are
+  // skipped, and the error is rethrown.
+  Executor& executor = mRaw->getExecutor();
+  executor.parallelFor(0, mRaw->dim.y, executor.getGrainSize(mRaw->dim.y),
+                       [this](int yBegin, int yEnd) {
+                         for (int y = yBegin; y < yEnd; y++)
+                           decompressRow(y);
+                       });
 }
 
 } // namespace rawspeed
@@ -29,15 +29,119 @@
 #include "io/BitPumpMSB16.h"              // for BitPumpMSB16
 #include "io/BitPumpMSB32.h"              // for BitPumpMSB32
 #include "io/ByteStream.h"                // for ByteStream
-#include "io/Endianness.h"                // for getHostEndianness, Endiann...
+#include "io/Endianness.h"                // for getBE, getLE, swapRow16, ...
 #include "io/IOException.h"               // for ThrowIOE
 #include <algorithm>                      // for min
+#include <array>                          // for array
 #include <cassert>                        // for assert
+#include <cinttypes>                      // for PRIu64
+#include <cstring>                        // for memcpy
 
 using std::min;
 
 namespace rawspeed {
 
+namespace {
+
+// Copies a row of w 16-bit values of the given byte order, converting them
+// to the native byte order.
+template <Endianness e>
+inline void copyRow16(uint16_t* dest, const uint8_t* in, uint32_t w) {
+  if (getHostEndianness() == e)
+    memcpy(dest, in, w * sizeof(uint16_t));
+  else
+    swapRow16(dest, in, w);
+}
+
+// Loads the 8 bytes starting at in, the bytes past the avail ones are zeros.
+template <BitOrder order>
+inline uint64_t loadGroup(const uint8_t* in, uint64_t avail) {
+  static_assert(order == BitOrder_MSB || order == BitOrder_LSB, "bad order");
+
+  std::array<uint8_t, 8> tmp = {};
+  const uint8_t* src = in;
+  if (avail < tmp.size()) {
+    memcpy(tmp.data(), in, avail);
+    src = tmp.data();
+  }
+  return order == BitOrder_MSB ? getBE<uint64_t>(src) : getLE<uint64_t>(src);
+}
+
+// Unpacks a row of w packed bits-bit values, in the same way as the
+// BitPumpMSB (BitOrder_MSB) or the BitPumpLSB (BitOrder_LSB) would.
+// Four values (at most 56 bits) are extracted from each 64-bit load, with
+// shifts and masks only, so this runs at close to memory bandwidth.
+// avail is the number of bytes that may be read starting at in.
+template <int bits, BitOrder order>
+void unpackRow(uint16_t* dest, const uint8_t* in, uint32_t w, uint64_t avail) {
+  static_assert(bits == 10 || bits == 12 || bits == 14, "unhandled bitdepth");
+
+  static constexpr uint32_t groupSize = 4;
+  static constexpr uint32_t groupBytes = bits * groupSize / 8;
+  static constexpr uint64_t mask = (1U << bits) - 1U;
+
+  const auto extract = [](uint64_t v, uint32_t i) -> uint16_t {
+    if (order == BitOrder_MSB)
+      return (v >> (64 - bits * (i + 1))) & mask;
+    return (v >> (bits * i)) & mask;
+  };
+
+  uint32_t x = 0;
+  for (; x + groupSize <= w; x += groupSize) {
+    const uint64_t v = loadGroup<order>(in, avail);
+    in += groupBytes;
+    avail -= groupBytes;
+    for (uint32_t i = 0; i < groupSize; i++)
+      dest[x + i] = extract(v, i);
+  }
+
+  if (x == w)
+    return;
+
+  // The last (partial) group. The row ends on a byte boundary, and the groups
+  // start on a byte boundary, so no bits of the next row are consumed here.
+  const uint64_t v = loadGroup<order>(in, avail);
+  for (uint32_t i = 0; x < w; x++, i++)
+    dest[x] = extract(v, i);
+}
+
+template <int bits, BitOrder order>
+void unpackRows(uint8_t* out, uint32_t outPitch, const uint8_t* in,
+                uint64_t inSize, uint32_t inPitch, uint32_t w, uint32_t h) {
+  for (uint32_t row = 0; row < h; row++) {
+    const uint64_t offset = static_cast<uint64_t>(row) * inPitch;
+    assert(offset < inSize);
+    unpackRow<bits, order>(reinterpret_cast<uint16_t*>(&out[row * outPitch]),
+                           in + offset, w, inSize - offset);
+  }
+}
+
+// Is there a specialized unpacker for this bit depth?
+inline bool canUnpackRows(int bitPerPixel) {
+  return bitPerPixel == 10 || bitPerPixel == 12 || bitPerPixel == 14;
+}
+
+template <BitOrder order>
+void unpackRows(int bitPerPixel, uint8_t* out, uint32_t outPitch,
+                const uint8_t* in, uint64_t inSize, uint32_t inPitch,
+                uint32_t w, uint32_t h) {
+  switch (bitPerPixel) {
+  case 10:
+    unpackRows<10, order>(out, outPitch, in, inSize, inPitch, w, h);
+    break;
+  case 12:
+    unpackRows<12, order>(out, outPitch, in, inSize, inPitch, w, h);
+    break;
+  case 14:
+    unpackRows<14, order>(out, outPitch, in, inSize, inPitch, w, h);
+    break;
+  default:
+    __builtin_unreachable();
+  }
+}
+
+} // namespace
+
 void UncompressedDecompressor::sanityCheck(const uint32_t* h,
                                            int bytesPerLine) {
   assert(h != nullptr);
@@ -56,7 +160,8 @@ void UncompressedDecompressor::sanityCheck(const uint32_t* h,
   if (fullRows == 0)
     ThrowIOE("Not enough data to decode a single line. Image file truncated.");
 
-  ThrowIOE("Image truncated, only %u of %u lines found", fullRows, *h);
+  ThrowIOE("Image truncated, only %" PRIu64 " of %u lines found", fullRows,
+           *h);
 
   // FIXME: need to come up with some common variable to allow proceeding here
   // *h = min_h;
@@ -150,6 +255,20 @@ void UncompressedDecompressor::readUncompressedRaw(const iPoint2D& size,
     return;
   }
 
+  if ((BitOrder_MSB == order || BitOrder_LSB == order) &&
+      canUnpackRows(bitPerPixel)) {
+    const uint64_t inSize = inputPitchBytes * (h - y);
+    const uint8_t* in = input.getData(inputPitchBytes * (h - y));
+    uint8_t* out = &data[offset.x * sizeof(uint16_t) * cpp + y * outPitch];
+    if (BitOrder_MSB == order)
+      unpackRows<BitOrder_MSB>(bitPerPixel, out, outPitch, in, inSize,
+                               inputPitchBytes, w * cpp, h - y);
+    else
+      unpackRows<BitOrder_LSB>(bitPerPixel, out, outPitch, in, inSize,
+                               inputPitchBytes, w * cpp, h - y);
+    return;
+  }
+
   if (BitOrder_MSB == order) {
     BitPumpMSB bits(input);
     w *= cpp;
@@ -193,11 +312,6 @@ void UncompressedDecompressor::readUncompressedRaw(const iPoint2D& size,
                  inputPitchBytes, w * mRaw->getBpp(), h - y);
       return;
     }
-    if (bitPerPixel == 12 && static_cast<int>(w) == inputPitchBytes * 8 / 12 &&
-        getHostEndianness() == Endianness::little) {
-      decode12BitRaw<Endianness::little>(w, h);
-      return;
-    }
     BitPumpLSB bits(input);
     w *= cpp;
     for (; y < h; y++) {
@@ -261,6 +375,7 @@ void UncompressedDecompressor::decode12BitRaw(uint32_t w, uint32_t h) {
 
   // FIXME: maybe check size of interlaced data?
   const uint8_t* in = input.peekData(perline * h);
+  const uint8_t* inEnd = in + perline * h;
   uint32_t half = (h + 1) >> 1;
   for (uint32_t row = 0; row < h; row++) {
     uint32_t y = !interlaced ? row : row % half * 2 + row / half;
@@ -271,6 +386,16 @@ void UncompressedDecompressor::decode12BitRaw(uint32_t w, uint32_t h) {
       const uint32_t offset = ((half * w * 3 / 2 >> 11) + 1) << 11;
       input.skipBytes(offset);
       in = input.peekData(perline * (h - row));
+      inEnd = in + perline * (h - row);
+    }
+
+    if (!skips) {
+      // Big-endian is the MSB bit order, little-endian is the LSB one.
+      static constexpr BitOrder order =
+          e == Endianness::big ? BitOrder_MSB : BitOrder_LSB;
+      unpackRow<bits, order>(dest, in, w, inEnd - in);
+      in += perline;
+      continue;
     }
 
     for (uint32_t x = 0; x < w; x += 2, in += 3) {
@@ -324,15 +449,11 @@ void UncompressedDecompressor::decode12BitRawUnpackedLeftAligned(uint32_t w,
   uint32_t pitch = mRaw->pitch;
   const uint8_t* in = input.getData(w * h * 2);
 
-  for (uint32_t y = 0; y < h; y++) {
+  for (uint32_t y = 0; y < h; y++, in += 2 * w) {
     auto* dest = reinterpret_cast<uint16_t*>(&data[y * pitch]);
-    for (uint32_t x = 0; x < w; x += 1, in += 2) {
-      uint32_t g1 = in[0];
-      uint32_t g2 = in[1];
-
-      if (e == Endianness::big)
-        dest[x] = (((g1 << 8) | (g2 & 0xf0)) >> 4);
-    }
+    copyRow16<e>(dest, in, w);
+    for (uint32_t x = 0; x < w; x++)
+      dest[x] >>= 4;
   }
 }
 
@@ -359,16 +480,16 @@ void UncompressedDecompressor::decodeRawUnpacked(uint32_t w, uint32_t h) {
   uint32_t pitch = mRaw->pitch;
   const uint8_t* in = input.getData(w * h * 2);
 
-  for (uint32_t y = 0; y < h; y++) {
+  for (uint32_t y = 0; y < h; y++, in += 2 * w) {
     auto* dest = reinterpret_cast<uint16_t*>(&data[y * pitch]);
-    for (uint32_t x = 0; x < w; x += 1, in += 2) {
-      uint32_t g1 = in[0];
-      uint32_t g2 = in[1];
-
+    copyRow16<e>(dest, in, w);
+    if (bits == 16)
+      continue;
+    for (uint32_t x = 0; x < w; x++) {
       if (e == Endianness::little)
-        dest[x] = ((g2 << 8) | g1) >> shift;
+        dest[x] >>= shift;
       else
-        dest[x] = ((g1 & mask) << 8) | g2;
+        dest[x] &= (mask << 8) | 0xff;
     }
   }
 }
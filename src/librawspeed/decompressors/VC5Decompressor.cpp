@@ -27,10 +27,10 @@
   implementation.
  */
 
-#include "rawspeedconfig.h" // for HAVE_OPENMP
 #include "decompressors/VC5Decompressor.h"
 #include "common/Array2DRef.h"            // for Array2DRef
 #include "common/Common.h"                // for clampBits, roundUpDivision
+#include "common/Executor.h"              // for Executor, TaskGroup
 #include "common/Optional.h"              // for Optional
 #include "common/Point.h"                 // for iPoint2D
 #include "common/RawspeedException.h"     // for RawspeedException
@@ -177,8 +177,9 @@ constexpr std::array<int, 4> ConvolutionParams::Last::mul_odd;
 } // namespace
 
 void VC5Decompressor::Wavelet::reconstructPass(
-    const Array2DRef<int16_t> dst, const Array2DRef<const int16_t> high,
-    const Array2DRef<const int16_t> low) const noexcept {
+    Executor* executor, const Array2DRef<int16_t> dst,
+    const Array2DRef<const int16_t> high,
+    const Array2DRef<const int16_t> low) const {
   auto process = [low, high, dst](auto segment, int row, int col) {
     auto lowGetter = [&row, &col, low](int delta) {
       return low(row + decltype(segment)::coord_shift + delta, col);
@@ -195,30 +196,31 @@ void VC5Decompressor::Wavelet::reconstructPass(
   };
 
   // Vertical reconstruction
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static)
-#endif
-  for (int row = 0; row < height; ++row) {
-    if (row == 0) {
-      // 1st row
-      for (int col = 0; col < width; ++col)
-        process(ConvolutionParams::First, row, col);
-    } else if (row + 1 < height) {
-      // middle rows
-      for (int col = 0; col < width; ++col)
-        process(ConvolutionParams::Middle, row, col);
-    } else {
-      // last row
-      for (int col = 0; col < width; ++col)
-        process(ConvolutionParams::Last, row, col);
-    }
-  }
+  executor->parallelFor(
+      0, height, executor->getGrainSize(height),
+      [this, process](int rowBegin, int rowEnd) {
+        for (int row = rowBegin; row < rowEnd; ++row) {
+          if (row == 0) {
+            // 1st row
+            for (int col = 0; col < width; ++col)
+              process(ConvolutionParams::First, row, col);
+          } else if (row + 1 < height) {
+            // middle rows
+            for (int col = 0; col < width; ++col)
+              process(ConvolutionParams::Middle, row, col);
+          } else {
+            // last row
+            for (int col = 0; col < width; ++col)
+              process(ConvolutionParams::Last, row, col);
+          }
+        }
+      });
 }
 
 void VC5Decompressor::Wavelet::combineLowHighPass(
-    const Array2DRef<int16_t> dst, const Array2DRef<const int16_t> low,
-    const Array2DRef<const int16_t> high, int descaleShift,
-    bool clampUint = false) const noexcept {
+    Executor* executor, const Array2DRef<int16_t> dst,
+    const Array2DRef<const int16_t> low, const Array2DRef<const int16_t> high,
+    int descaleShift, bool clampUint = false) const {
   auto process = [low, high, descaleShift, clampUint, dst](auto segment,
                                                            int row, int col) {
     auto lowGetter = [&row, &col, low](int delta) {
@@ -241,62 +243,51 @@ void VC5Decompressor::Wavelet::combineLowHighPass(
   };
 
   // Horizontal reconstruction
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static)
-#endif
-  for (int row = 0; row < dst.height; ++row) {
-    // First col
-    int col = 0;
-    process(ConvolutionParams::First, row, col);
-    // middle cols
-    for (col = 1; col + 1 < width; ++col) {
-      process(ConvolutionParams::Middle, row, col);
-    }
-    // last col
-    process(ConvolutionParams::Last, row, col);
-  }
+  executor->parallelFor(
+      0, dst.height, executor->getGrainSize(dst.height),
+      [this, process](int rowBegin, int rowEnd) {
+        for (int row = rowBegin; row < rowEnd; ++row) {
+          // First col
+          int col = 0;
+          process(ConvolutionParams::First, row, col);
+          // middle cols
+          for (col = 1; col + 1 < width; ++col) {
+            process(ConvolutionParams::Middle, row, col);
+          }
+          // last col
+          process(ConvolutionParams::Last, row, col);
+        }
+      });
 }
 
 void VC5Decompressor::Wavelet::ReconstructableBand::processLow(
-    const Wavelet& wavelet) noexcept {
-  Array2DRef<int16_t> lowpass;
-#ifdef HAVE_OPENMP
-#pragma omp single copyprivate(lowpass)
-#endif
-  lowpass = Array2DRef<int16_t>::create(&lowpass_storage, wavelet.width,
-                                        2 * wavelet.height);
+    const Wavelet& wavelet, Executor* executor) {
+  const Array2DRef<int16_t> lowpass = Array2DRef<int16_t>::create(
+      &lowpass_storage, wavelet.width, 2 * wavelet.height);
 
   const Array2DRef<const int16_t> highlow = wavelet.bandAsArray2DRef(2);
   const Array2DRef<const int16_t> lowlow = wavelet.bandAsArray2DRef(0);
 
   // Reconstruct the "immediates", the actual low pass ...
-  wavelet.reconstructPass(lowpass, highlow, lowlow);
+  wavelet.reconstructPass(executor, lowpass, highlow, lowlow);
 }
 
 void VC5Decompressor::Wavelet::ReconstructableBand::processHigh(
-    const Wavelet& wavelet) noexcept {
-  Array2DRef<int16_t> highpass;
-#ifdef HAVE_OPENMP
-#pragma omp single copyprivate(highpass)
-#endif
-  highpass = Array2DRef<int16_t>::create(&highpass_storage, wavelet.width,
-                                         2 * wavelet.height);
+    const Wavelet& wavelet, Executor* executor) {
+  const Array2DRef<int16_t> highpass = Array2DRef<int16_t>::create(
+      &highpass_storage, wavelet.width, 2 * wavelet.height);
 
   const Array2DRef<const int16_t> highhigh = wavelet.bandAsArray2DRef(3);
   const Array2DRef<const int16_t> lowhigh = wavelet.bandAsArray2DRef(1);
 
-  wavelet.reconstructPass(highpass, highhigh, lowhigh);
+  wavelet.reconstructPass(executor, highpass, highhigh, lowhigh);
 }
 
 void VC5Decompressor::Wavelet::ReconstructableBand::combine(
-    const Wavelet& wavelet) noexcept {
+    const Wavelet& wavelet, Executor* executor) {
   int16_t descaleShift = (wavelet.prescale == 2 ? 2 : 0);
 
-  Array2DRef<int16_t> dest;
-#ifdef HAVE_OPENMP
-#pragma omp single copyprivate(dest)
-#endif
-  dest =
+  const Array2DRef<int16_t> dest =
       Array2DRef<int16_t>::create(&data, 2 * wavelet.width, 2 * wavelet.height);
 
   const Array2DRef<int16_t> lowpass(lowpass_storage.data(), wavelet.width,
@@ -305,16 +296,17 @@ void VC5Decompressor::Wavelet::ReconstructableBand::combine(
                                      2 * wavelet.height);
 
   // And finally, combine the low pass, and high pass.
-  wavelet.combineLowHighPass(dest, lowpass, highpass, descaleShift, clampUint);
+  wavelet.combineLowHighPass(executor, dest, lowpass, highpass, descaleShift,
+                             clampUint);
 }
 
 void VC5Decompressor::Wavelet::ReconstructableBand::decode(
-    const Wavelet& wavelet) noexcept {
+    const Wavelet& wavelet, Executor* executor) {
   assert(wavelet.allBandsValid());
   assert(data.empty());
-  processLow(wavelet);
-  processHigh(wavelet);
-  combine(wavelet);
+  processLow(wavelet, executor);
+  processHigh(wavelet, executor);
+  combine(wavelet, executor);
 }
 
 VC5Decompressor::VC5Decompressor(ByteStream bs, const RawImage& img)
@@ -693,21 +685,6 @@ void VC5Decompressor::prepareDecodingPlan() {
   prepareBandReconstruction();
 }
 
-void VC5Decompressor::decodeThread(bool* exceptionThrown) const noexcept {
-  // Decode all the existing bands. May fail.
-  decodeBands(exceptionThrown);
-
-  // Proceed only if decoding did not fail.
-  if (*exceptionThrown)
-    return;
-
-  // And now, reconstruct the low-pass bands.
-  reconstructLowpassBands();
-
-  // And finally!
-  combineFinalLowpassBands();
-}
-
 void VC5Decompressor::decode(unsigned int offsetX, unsigned int offsetY,
                              unsigned int width, unsigned int height) {
   if (offsetX || offsetY || mRaw->dim != iPoint2D(width, height))
@@ -717,57 +694,50 @@ void VC5Decompressor::decode(unsigned int offsetX, unsigned int offsetY,
 
   prepareDecodingPlan();
 
-  bool exceptionThrown = false;
-#ifdef HAVE_OPENMP
-#pragma omp parallel default(none) shared(exceptionThrown)                     \
-    num_threads(rawspeed_get_number_of_processor_cores())
-#endif
-  decodeThread(&exceptionThrown);
+  Executor& executor = mRaw->getExecutor();
+
+  // Decode all the existing bands. May fail.
+  decodeBands(&executor);
 
+  // Proceed only if decoding did not fail.
   std::string firstErr;
   if (mRaw->isTooManyErrors(1, &firstErr)) {
-    assert(exceptionThrown);
     ThrowRDE("Too many errors encountered. Giving up. First Error:\n%s",
              firstErr.c_str());
-  } else {
-    assert(!exceptionThrown);
   }
+
+  // And now, reconstruct the low-pass bands.
+  reconstructLowpassBands(&executor);
+
+  // And finally!
+  combineFinalLowpassBands(&executor);
 }
 
-void VC5Decompressor::decodeBands(bool* exceptionThrown) const noexcept {
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(dynamic, 1)
-#endif
-  for (auto decodeableBand = allDecodeableBands.begin();
-       decodeableBand < allDecodeableBands.end(); ++decodeableBand) {
-    try {
-      decodeableBand->band->decode(decodeableBand->wavelet);
-    } catch (RawspeedException& err) {
-      // Propagate the exception out of OpenMP magic.
-      mRaw->setError(err.what());
-#ifdef HAVE_OPENMP
-#pragma omp atomic write
-#endif
-      *exceptionThrown = true;
-#ifdef HAVE_OPENMP
-#pragma omp cancel for
-#endif
-    }
+void VC5Decompressor::decodeBands(Executor* executor) const {
+  TaskGroup bands(executor);
+  for (const DecodeableBand& decodeableBand : allDecodeableBands) {
+    bands.run([this, &bands, &decodeableBand]() {
+      try {
+        decodeableBand.band->decode(decodeableBand.wavelet);
+      } catch (RawspeedException& err) {
+        mRaw->setError(err.what());
+        // The image is unusable anyway, do not bother with the other bands.
+        bands.cancel();
+      }
+    });
   }
+  bands.wait();
 }
 
-void VC5Decompressor::reconstructLowpassBands() const noexcept {
+void VC5Decompressor::reconstructLowpassBands(Executor* executor) const {
   for (const ReconstructionStep& step : reconstructionSteps) {
-    step.band.decode(step.wavelet);
+    step.band.decode(step.wavelet, executor);
 
-#ifdef HAVE_OPENMP
-#pragma omp single nowait
-#endif
     step.wavelet.clear(); // we no longer need it.
   }
 }
 
-void VC5Decompressor::combineFinalLowpassBands() const noexcept {
+void VC5Decompressor::combineFinalLowpassBands(Executor* executor) const {
   const Array2DRef<uint16_t> out(mRaw->getU16DataAsUncroppedArray2DRef());
 
   const int width = out.width / 2;
@@ -783,29 +753,34 @@ void VC5Decompressor::combineFinalLowpassBands() const noexcept {
       channels[3].band.data.data(), channels[3].width, channels[3].height);
 
   // Convert to RGGB output
-#ifdef HAVE_OPENMP
-#pragma omp for schedule(static) collapse(2)
-#endif
-  for (int row = 0; row < height; ++row) {
-    for (int col = 0; col < width; ++col) {
-      const int mid = 2048;
-
-      int gs = lowbands0(row, col);
-      int rg = lowbands1(row, col) - mid;
-      int bg = lowbands2(row, col) - mid;
-      int gd = lowbands3(row, col) - mid;
-
-      int r = gs + 2 * rg;
-      int b = gs + 2 * bg;
-      int g1 = gs + gd;
-      int g2 = gs - gd;
-
-      out(2 * row + 0, 2 * col + 0) = static_cast<uint16_t>(mVC5LogTable[r]);
-      out(2 * row + 0, 2 * col + 1) = static_cast<uint16_t>(mVC5LogTable[g1]);
-      out(2 * row + 1, 2 * col + 0) = static_cast<uint16_t>(mVC5LogTable[g2]);
-      out(2 * row + 1, 2 * col + 1) = static_cast<uint16_t>(mVC5LogTable[b]);
-    }
-  }
+  executor->parallelFor(
+      0, height, executor->getGrainSize(height),
+      [&](int rowBegin, int rowEnd) {
+        for (int row = rowBegin; row < rowEnd; ++row) {
+          for (int col = 0; col < width; ++col) {
+            const int mid = 2048;
+
+            int gs = lowbands0(row, col);
+            int rg = lowbands1(row, col) - mid;
+            int bg = lowbands2(row, col) - mid;
+            int gd = lowbands3(row, col) - mid;
+
+            int r = gs + 2 * rg;
+            int b = gs + 2 * bg;
+            int g1 = gs + gd;
+            int g2 = gs - gd;
+
+            out(2 * row + 0, 2 * col + 0) =
+                static_cast<uint16_t>(mVC5LogTable[r]);
+            out(2 * row + 0, 2 * col + 1) =
+                static_cast<uint16_t>(mVC5LogTable[g1]);
+            out(2 * row + 1, 2 * col + 0) =
+                static_cast<uint16_t>(mVC5LogTable[g2]);
+            out(2 * row + 1, 2 * col + 1) =
+                static_cast<uint16_t>(mVC5LogTable[b]);
+          }
+        }
+      });
 }
 
 inline void VC5Decompressor::getRLV(BitPumpMSB* bits, int* value,
@@ -38,6 +38,8 @@
 
 namespace rawspeed {
 
+class Executor;
+
 const int MAX_NUM_PRESCALE = 8;
 
 // Decompresses VC-5 as used by GoPro
@@ -122,7 +124,6 @@ class VC5Decompressor final : public AbstractDecompressor {
     struct AbstractBand {
       std::vector<int16_t, DefaultInitAllocatorAdaptor<int16_t>> data;
       virtual ~AbstractBand() = default;
-      virtual void decode(const Wavelet& wavelet) = 0;
     };
     struct ReconstructableBand final : AbstractBand {
       bool clampUint;
@@ -132,14 +133,15 @@ class VC5Decompressor final : public AbstractDecompressor {
           highpass_storage;
       explicit ReconstructableBand(bool clampUint_ = false)
           : clampUint(clampUint_) {}
-      void processLow(const Wavelet& wavelet) noexcept;
-      void processHigh(const Wavelet& wavelet) noexcept;
-      void combine(const Wavelet& wavelet) noexcept;
-      void decode(const Wavelet& wavelet) noexcept final;
+      void processLow(const Wavelet& wavelet, Executor* executor);
+      void processHigh(const Wavelet& wavelet, Executor* executor);
+      void combine(const Wavelet& wavelet, Executor* executor);
+      void decode(const Wavelet& wavelet, Executor* executor);
     };
     struct AbstractDecodeableBand : AbstractBand {
       ByteStream bs;
       explicit AbstractDecodeableBand(ByteStream bs_) : bs(std::move(bs_)) {}
+      virtual void decode(const Wavelet& wavelet) = 0;
     };
     struct LowPassBand final : AbstractDecodeableBand {
       uint16_t lowpassPrecision;
@@ -167,14 +169,14 @@ class VC5Decompressor final : public AbstractDecompressor {
     uint32_t getValidBandMask() const { return mDecodedBandMask; }
     bool allBandsValid() const;
 
-    void reconstructPass(Array2DRef<int16_t> dst,
+    void reconstructPass(Executor* executor, Array2DRef<int16_t> dst,
                          Array2DRef<const int16_t> high,
-                         Array2DRef<const int16_t> low) const noexcept;
+                         Array2DRef<const int16_t> low) const;
 
-    void combineLowHighPass(Array2DRef<int16_t> dst,
+    void combineLowHighPass(Executor* executor, Array2DRef<int16_t> dst,
                             Array2DRef<const int16_t> low,
                             Array2DRef<const int16_t> high, int descaleShift,
-                            bool clampUint /*= false*/) const noexcept;
+                            bool clampUint /*= false*/) const;
 
     Array2DRef<const int16_t> bandAsArray2DRef(unsigned int iBand) const;
 
@@ -220,13 +222,11 @@ class VC5Decompressor final : public AbstractDecompressor {
   void prepareBandReconstruction();
   void prepareDecodingPlan();
 
-  void decodeBands(bool* exceptionThrown) const noexcept;
-
-  void reconstructLowpassBands() const noexcept;
+  void decodeBands(Executor* executor) const;
 
-  void combineFinalLowpassBands() const noexcept;
+  void reconstructLowpassBands(Executor* executor) const;
 
-  void decodeThread(bool* exceptionThrown) const noexcept;
+  void combineFinalLowpassBands(Executor* executor) const;
 
   void parseVC5();
 
@@ -19,10 +19,10 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
-#include "rawspeedconfig.h" // for HAVE_OPENMP
 #include "interpolators/Cr2sRawInterpolator.h"
 #include "common/Array2DRef.h"            // for Array2DRef
 #include "common/Common.h"                // for clampBits
+#include "common/Executor.h"              // for Executor
 #include "common/Point.h"                 // for iPoint2D
 #include "common/RawImage.h"              // for RawImage, RawImageData
 #include "decoders/RawDecoderException.h" // for ThrowRDE
@@ -380,16 +380,15 @@ template <int version> void Cr2sRawInterpolator::interpolate_420() {
     }
   };
 
-  int row;
-#ifdef HAVE_OPENMP
-#pragma omp parallel for default(none) schedule(static)                        \
-    num_threads(rawspeed_get_number_of_processor_cores())                      \
-        OMPFIRSTPRIVATECLAUSE(out) lastprivate(row)
-#endif
-  for (row = 0; row < input.height - 1; ++row)
-    interpolate_420_row<version>(row);
+  Executor& executor = mRaw->getExecutor();
+  executor.parallelFor(0, input.height - 1,
+                       executor.getGrainSize(input.height - 1),
+                       [this](int rowBegin, int rowEnd) {
+                         for (int row = rowBegin; row < rowEnd; ++row)
+                           interpolate_420_row<version>(row);
+                       });
 
-  assert(row + 1 == input.height);
+  const int row = input.height - 1;
 
   // Last two lines, the packed input format is:
   //          p0 p1 p2 p3 p0 p0     p4 p5 p6 p7 p4 p4
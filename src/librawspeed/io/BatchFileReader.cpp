@@ -0,0 +1,129 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "io/BatchFileReader.h"
+#include "common/ChecksumFile.h" // for ChecksumFileEntry
+#include "io/Buffer.h"           // for Buffer
+#include "io/FileReader.h"       // for FileReader
+#include <algorithm>             // for max
+#include <cassert>               // for assert
+#include <utility>               // for move
+
+namespace rawspeed {
+
+const Buffer* BatchFileReader::File::get() const {
+  if (error)
+    std::rethrow_exception(error);
+  assert(buffer);
+  return buffer.get();
+}
+
+std::unique_ptr<const Buffer> BatchFileReader::File::release() {
+  if (error)
+    std::rethrow_exception(error);
+  assert(buffer);
+  return std::move(buffer);
+}
+
+BatchFileReader::BatchFileReader(std::vector<std::string> fileNames_,
+                                 size_t readAhead_)
+    : fileNames(std::move(fileNames_)),
+      readAhead(std::max<size_t>(readAhead_, 1)),
+      reader(&BatchFileReader::readerThread, this) {}
+
+static std::vector<std::string>
+getFullFileNames(const std::vector<ChecksumFileEntry>& entries) {
+  std::vector<std::string> fileNames;
+  fileNames.reserve(entries.size());
+  for (const ChecksumFileEntry& entry : entries)
+    fileNames.emplace_back(entry.FullFileName);
+  return fileNames;
+}
+
+BatchFileReader::BatchFileReader(const std::vector<ChecksumFileEntry>& entries,
+                                 size_t readAhead_)
+    : BatchFileReader(getFullFileNames(entries), readAhead_) {}
+
+BatchFileReader::~BatchFileReader() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopRequested = true;
+  }
+  queueChanged.notify_all();
+  reader.join();
+}
+
+void BatchFileReader::readerThread() {
+  for (const std::string& fileName : fileNames) {
+    {
+      // Wait until there is space in the queue.
+      std::unique_lock<std::mutex> lock(mutex);
+      queueChanged.wait(
+          lock, [this]() { return stopRequested || queue.size() < readAhead; });
+      if (stopRequested)
+        return;
+    }
+
+    // Read the file without holding the lock.
+    File file;
+    file.fileName = fileName;
+    try {
+      FileReader f(fileName.c_str());
+      file.buffer = f.readFile();
+    } catch (...) {
+      file.error = std::current_exception();
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      queue.emplace_back(std::move(file));
+    }
+    queueChanged.notify_all();
+  }
+}
+
+bool BatchFileReader::next(File* file) {
+  assert(file);
+
+  std::unique_lock<std::mutex> lock(mutex);
+
+  if (numHandedOut == fileNames.size())
+    return false;
+  numHandedOut++;
+
+  // Each caller has reserved one of the remaining files above, so the reader
+  // will eventually put a file into the queue for this caller.
+  queueChanged.wait(lock, [this]() { return !queue.empty(); });
+
+  *file = std::move(queue.front());
+  queue.pop_front();
+
+  lock.unlock();
+  queueChanged.notify_all();
+
+  return true;
+}
+
+size_t BatchFileReader::getNumRemaining() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return fileNames.size() - numHandedOut;
+}
+
+} // namespace rawspeed
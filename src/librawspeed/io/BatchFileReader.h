@@ -0,0 +1,98 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include <condition_variable> // for condition_variable
+#include <cstddef>            // for size_t
+#include <deque>              // for deque
+#include <exception>          // for exception_ptr
+#include <memory>             // for unique_ptr
+#include <mutex>              // for mutex
+#include <string>             // for string
+#include <thread>             // for thread
+#include <vector>             // for vector
+
+namespace rawspeed {
+
+class Buffer;
+
+struct ChecksumFileEntry;
+
+// Reads a list of files, in order, on a background thread, staying at most
+// readAhead files ahead of the consumer(s). This way, the reading of the next
+// file(s) overlaps with the processing of the current one.
+class BatchFileReader final {
+public:
+  struct File {
+    std::string fileName;
+
+    // Returns the contents of the file. If it could not be read,
+    // rethrows the exception that happened while reading it.
+    const Buffer* get() const;
+
+    // Releases the contents of the file, rethrowing like get().
+    std::unique_ptr<const Buffer> release();
+
+  private:
+    friend class BatchFileReader;
+
+    std::unique_ptr<const Buffer> buffer;
+    std::exception_ptr error;
+  };
+
+  explicit BatchFileReader(std::vector<std::string> fileNames_,
+                           size_t readAhead_ = 2);
+
+  explicit BatchFileReader(const std::vector<ChecksumFileEntry>& entries,
+                           size_t readAhead_ = 2);
+
+  BatchFileReader(const BatchFileReader&) = delete;
+  BatchFileReader(BatchFileReader&&) = delete;
+  BatchFileReader& operator=(const BatchFileReader&) = delete;
+  BatchFileReader& operator=(BatchFileReader&&) = delete;
+
+  // Stops the reading, the files that were not yet read will not be read.
+  ~BatchFileReader();
+
+  // Waits until the next file (in the input order) has been read, and moves
+  // it into *file. Returns false if all the files were already handed out.
+  // May be called from multiple threads concurrently.
+  bool next(File* file);
+
+  // How many files were not handed out yet.
+  size_t getNumRemaining();
+
+private:
+  const std::vector<std::string> fileNames;
+  const size_t readAhead;
+
+  std::mutex mutex;
+  std::condition_variable queueChanged;
+  std::deque<File> queue;     // the files that were read, but not handed out
+  size_t numHandedOut = 0;    // how many files were already handed out
+  bool stopRequested = false; // the reader should exit asap
+
+  std::thread reader;
+
+  void readerThread();
+};
+
+} // namespace rawspeed
@@ -38,50 +38,76 @@ template <> struct BitStreamTraits<BitPumpJPEG> final {
   static constexpr bool canUseWithHuffmanTable = true;
 };
 
-template <>
-inline BitPumpJPEG::size_type BitPumpJPEG::fillCache(const uint8_t* input,
-                                                     size_type bufferSize,
-                                                     size_type* bufPos) {
-  static_assert(BitStreamCacheBase::MaxGetBits >= 32, "check implementation");
-
-  // short-cut path for the most common case (no FF marker in the next 4 bytes)
-  // this is slightly faster than the else-case alone.
-  // TODO: investigate applicability of vector intrinsics to speed up if-cascade
-  if (input[0] != 0xFF &&
-      input[1] != 0xFF &&
-      input[2] != 0xFF &&
-      input[3] != 0xFF ) {
-    cache.push(getBE<uint32_t>(input), 32);
-    return 4;
-  }
+// Same, but with a 128-bit wide cache.
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+using BitPumpJPEGWide =
+    BitStream<JPEGBitPumpTag, BitStreamCacheRightInLeftOutWide>;
 
-  size_type p = 0;
-  for (size_type i = 0; i < 4; ++i) {
-    // Pre-execute most common case, where next byte is 'normal'/non-FF
-    const int c0 = input[p++];
-    cache.push(c0, 8);
-    if (c0 == 0xFF) {
-      // Found FF -> pre-execute case of FF/00, which represents an FF data byte -> ignore the 00
-      const int c1 = input[p++];
-      if (c1 != 0) {
-        // Found FF/xx with xx != 00. This is the end of stream marker.
-
-        // Clear low 8 bits (0xFF, from c0) that we optimistically pushed.
-        // We should not pop() them, to avoid issues with fillLevel becoming 0.
-        cache.cache &= ~0xFFULL;
-        // And fully fill the empty space in cache with zeros.
-        cache.cache <<= bitwidth(cache.cache) - cache.fillLevel;
-        cache.fillLevel = bitwidth(cache.cache);
-
-        // No further reading from this buffer shall happen.
-        // Do signal that by stating that we are at the end of the buffer.
-        *bufPos = bufferSize;
-        return 0;
+template <> struct BitStreamTraits<BitPumpJPEGWide> final {
+  static constexpr bool canUseWithHuffmanTable = true;
+};
+#endif
+
+template <> struct BitStreamFiller<JPEGBitPumpTag> final {
+  template <typename Cache>
+  static inline Buffer::size_type
+  fillCache(Cache* cache, const uint8_t* input, Buffer::size_type bufferSize,
+            Buffer::size_type* bufPos) {
+    static_assert(Cache::MaxGetBits >= 32, "check implementation");
+
+    // A wide cache can take all the MaxProcessBytes bytes at once,
+    // if there is no FF byte among them (then ~bytes has a zero byte).
+    if (Cache::Size > 64) {
+      const uint64_t bytes = getBE<uint64_t>(input);
+      const uint64_t inv = ~bytes;
+      if (!((inv - 0x0101010101010101ULL) & ~inv & 0x8080808080808080ULL)) {
+        cache->push(bytes, 64);
+        return 8;
       }
     }
+
+    // short-cut path for the most common case (no FF marker in the next 4
+    // bytes) this is slightly faster than the else-case alone.
+    // TODO: investigate applicability of vector intrinsics to speed up
+    // if-cascade
+    if (input[0] != 0xFF &&
+        input[1] != 0xFF &&
+        input[2] != 0xFF &&
+        input[3] != 0xFF ) {
+      cache->push(getBE<uint32_t>(input), 32);
+      return 4;
+    }
+
+    Buffer::size_type p = 0;
+    for (Buffer::size_type i = 0; i < 4; ++i) {
+      // Pre-execute most common case, where next byte is 'normal'/non-FF
+      const int c0 = input[p++];
+      cache->push(c0, 8);
+      if (c0 == 0xFF) {
+        // Found FF -> pre-execute case of FF/00, which represents an FF data
+        // byte -> ignore the 00
+        const int c1 = input[p++];
+        if (c1 != 0) {
+          // Found FF/xx with xx != 00. This is the end of stream marker.
+
+          // Clear low 8 bits (0xFF, from c0) that we optimistically pushed.
+          // We should not pop() them, to avoid issues with fillLevel becoming
+          // 0.
+          cache->cache &= ~static_cast<decltype(cache->cache)>(0xFF);
+          // And fully fill the empty space in cache with zeros.
+          cache->cache <<= bitwidth(cache->cache) - cache->fillLevel;
+          cache->fillLevel = bitwidth(cache->cache);
+
+          // No further reading from this buffer shall happen.
+          // Do signal that by stating that we are at the end of the buffer.
+          *bufPos = bufferSize;
+          return 0;
+        }
+      }
+    }
+    return p;
   }
-  return p;
-}
+};
 
 template <> inline BitPumpJPEG::size_type BitPumpJPEG::getBufferPosition() const
 {
@@ -90,4 +116,12 @@ template <> inline BitPumpJPEG::size_type BitPumpJPEG::getBufferPosition() const
   return pos;
 }
 
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+template <>
+inline BitPumpJPEGWide::size_type BitPumpJPEGWide::getBufferPosition() const {
+  // same as for the BitPumpJPEG.
+  return pos;
+}
+#endif
+
 } // namespace rawspeed
@@ -0,0 +1,74 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "io/BitPumpMSB.h" // for MSBBitPumpTag, BitStreamFiller<>
+#include "io/BitStream.h"  // for BitStreamCacheRightInLeftOut, BitStream
+#include "io/Buffer.h"     // for Buffer::size_type
+#include <cassert>         // for assert
+#include <cstdint>         // for uint8_t, uint32_t
+
+namespace rawspeed {
+
+struct JPEGUnstuffedBitPumpTag;
+
+// The JPEG entropy-coded segment, after the JpegUnstuffer removed the byte
+// stuffing and cut it at the marker. Same as BitPumpMSB, but just like the
+// BitPumpJPEG past the marker, past the end it reads zeros, forever.
+using BitPumpJPEGUnstuffed =
+    BitStream<JPEGUnstuffedBitPumpTag, BitStreamCacheRightInLeftOut>;
+
+template <> struct BitStreamTraits<BitPumpJPEGUnstuffed> final {
+  static constexpr bool canUseWithHuffmanTable = true;
+};
+
+template <> struct BitStreamFiller<JPEGUnstuffedBitPumpTag> final {
+  template <typename Cache>
+  static inline Buffer::size_type
+  fillCache(Cache* cache, const uint8_t* input, Buffer::size_type bufferSize,
+            Buffer::size_type* bufPos) {
+    return BitStreamFiller<MSBBitPumpTag>::fillCache(cache, input, bufferSize,
+                                                     bufPos);
+  }
+};
+
+// Past the end, the zeros do not come from the input, so there is nothing to
+// be read (or to be bounds-checked). But the position still advances, so that
+// getBitPosition() keeps counting the bits that were consumed.
+template <>
+inline void BitPumpJPEGUnstuffed::fill(uint32_t nbits) {
+  assert(data);
+  assert(nbits <= BitStreamCacheRightInLeftOut::MaxGetBits);
+
+  if (cache.fillLevel >= nbits)
+    return;
+
+  if (pos >= size) {
+    cache.push(0, 32);
+    pos += 4;
+    return;
+  }
+
+  pos += BitStreamFiller<JPEGUnstuffedBitPumpTag>::fillCache(
+      &cache, getInput(), size, &pos);
+}
+
+} // namespace rawspeed
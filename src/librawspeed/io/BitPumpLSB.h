@@ -34,15 +34,17 @@ struct LSBBitPumpTag;
 
 using BitPumpLSB = BitStream<LSBBitPumpTag, BitStreamCacheLeftInRightOut>;
 
-template <>
-inline BitPumpLSB::size_type BitPumpLSB::fillCache(const uint8_t* input,
-                                                   size_type bufferSize,
-                                                   size_type* bufPos) {
-  static_assert(BitStreamCacheBase::MaxGetBits >= 32, "check implementation");
-
-  cache.push(getLE<uint32_t>(input), 32);
-  return 4;
-}
+template <> struct BitStreamFiller<LSBBitPumpTag> final {
+  template <typename Cache>
+  static inline Buffer::size_type
+  fillCache(Cache* cache, const uint8_t* input, Buffer::size_type bufferSize,
+            Buffer::size_type* bufPos) {
+    static_assert(Cache::MaxGetBits >= 32, "check implementation");
+
+    cache->push(getLE<uint32_t>(input), 32);
+    return 4;
+  }
+};
 
 template <> inline void BitPumpLSB::setBufferPosition(size_type newPos) {
   pos = newPos;
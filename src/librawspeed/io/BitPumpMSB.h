@@ -38,14 +38,32 @@ template <> struct BitStreamTraits<BitPumpMSB> final {
   static constexpr bool canUseWithHuffmanTable = true;
 };
 
-template <>
-inline BitPumpMSB::size_type BitPumpMSB::fillCache(const uint8_t* input,
-                                                   size_type bufferSize,
-                                                   size_type* bufPos) {
-  static_assert(BitStreamCacheBase::MaxGetBits >= 32, "check implementation");
-
-  cache.push(getBE<uint32_t>(input), 32);
-  return 4;
-}
+// Same, but with a 128-bit wide cache.
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+using BitPumpMSBWide =
+    BitStream<MSBBitPumpTag, BitStreamCacheRightInLeftOutWide>;
+
+template <> struct BitStreamTraits<BitPumpMSBWide> final {
+  static constexpr bool canUseWithHuffmanTable = true;
+};
+#endif
+
+template <> struct BitStreamFiller<MSBBitPumpTag> final {
+  template <typename Cache>
+  static inline Buffer::size_type
+  fillCache(Cache* cache, const uint8_t* input, Buffer::size_type bufferSize,
+            Buffer::size_type* bufPos) {
+    static_assert(Cache::MaxGetBits >= 32, "check implementation");
+
+    // A wide cache can take all the MaxProcessBytes bytes at once.
+    if (Cache::Size > 64) {
+      cache->push(getBE<uint64_t>(input), 64);
+      return 8;
+    }
+
+    cache->push(getBE<uint32_t>(input), 32);
+    return 4;
+  }
+};
 
 } // namespace rawspeed
@@ -34,15 +34,17 @@ struct MSB16BitPumpTag;
 
 using BitPumpMSB16 = BitStream<MSB16BitPumpTag, BitStreamCacheRightInLeftOut>;
 
-template <>
-inline BitPumpMSB16::size_type BitPumpMSB16::fillCache(const uint8_t* input,
-                                                       size_type bufferSize,
-                                                       size_type* bufPos) {
-  static_assert(BitStreamCacheBase::MaxGetBits >= 32, "check implementation");
-
-  for (size_type i = 0; i < 4; i += sizeof(uint16_t))
-    cache.push(getLE<uint16_t>(input + i), 16);
-  return 4;
-}
+template <> struct BitStreamFiller<MSB16BitPumpTag> final {
+  template <typename Cache>
+  static inline Buffer::size_type
+  fillCache(Cache* cache, const uint8_t* input, Buffer::size_type bufferSize,
+            Buffer::size_type* bufPos) {
+    static_assert(Cache::MaxGetBits >= 32, "check implementation");
+
+    for (Buffer::size_type i = 0; i < 4; i += sizeof(uint16_t))
+      cache->push(getLE<uint16_t>(input + i), 16);
+    return 4;
+  }
+};
 
 } // namespace rawspeed
@@ -38,14 +38,34 @@ template <> struct BitStreamTraits<BitPumpMSB32> final {
   static constexpr bool canUseWithHuffmanTable = true;
 };
 
-template <>
-inline BitPumpMSB32::size_type BitPumpMSB32::fillCache(const uint8_t* input,
-                                                       size_type bufferSize,
-                                                       size_type* bufPos) {
-  static_assert(BitStreamCacheBase::MaxGetBits >= 32, "check implementation");
-
-  cache.push(getLE<uint32_t>(input), 32);
-  return 4;
-}
+// Same, but with a 128-bit wide cache.
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+using BitPumpMSB32Wide =
+    BitStream<MSB32BitPumpTag, BitStreamCacheRightInLeftOutWide>;
+
+template <> struct BitStreamTraits<BitPumpMSB32Wide> final {
+  static constexpr bool canUseWithHuffmanTable = true;
+};
+#endif
+
+template <> struct BitStreamFiller<MSB32BitPumpTag> final {
+  template <typename Cache>
+  static inline Buffer::size_type
+  fillCache(Cache* cache, const uint8_t* input, Buffer::size_type bufferSize,
+            Buffer::size_type* bufPos) {
+    static_assert(Cache::MaxGetBits >= 32, "check implementation");
+
+    // A wide cache can take all the MaxProcessBytes bytes at once.
+    if (Cache::Size > 64) {
+      cache->push(static_cast<uint64_t>(getLE<uint32_t>(input)) << 32 |
+                      getLE<uint32_t>(input + 4),
+                  64);
+      return 8;
+    }
+
+    cache->push(getLE<uint32_t>(input), 32);
+    return 4;
+  }
+};
 
 } // namespace rawspeed
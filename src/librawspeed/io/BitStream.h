@@ -22,7 +22,7 @@
 
 #pragma once
 
-#include "common/Common.h"  // for bitwidth, extractHighBits
+#include "common/Common.h"  // for bitwidth
 #include "io/Buffer.h"      // for Buffer::size_type, Buffer
 #include "io/ByteStream.h"  // for ByteStream
 #include "io/Endianness.h"  // for Endianness, Endianness::unknown
@@ -35,37 +35,48 @@
 
 namespace rawspeed {
 
-// simple 64-bit wide cache implementation that acts like a FiFo.
+// simple cache implementation that acts like a FiFo.
 // There are two variants:
 //  * L->R: new bits are pushed in on the left and pulled out on the right
 //  * L<-R: new bits are pushed in on the right and pulled out on the left
 // Each BitStream specialization uses one of the two.
+// The cache is normally 64-bit wide, but may be 128-bit wide (where supported
+// by the compiler), in which case each fill() provides enough bits for at
+// least two (up to 32-bit) requests.
 
 struct BitStreamCacheBase
 {
-  uint64_t cache = 0;         // the actual bits stored in the cache
+  // maximal number of bytes the implementation may read.
+  // NOTE: this is not the same as MaxGetBits/8 !!!
+  static constexpr unsigned MaxProcessBytes = 8;
+};
+
+template <typename T> struct BitStreamCacheStorage : BitStreamCacheBase {
+  T cache = 0;                // the actual bits stored in the cache
   unsigned int fillLevel = 0; // bits left in cache
 
-  static constexpr unsigned Size = bitwidth<decltype(cache)>();
+  static constexpr unsigned Size = bitwidth<T>();
 
   // how many bits could be requested to be filled
-  static constexpr unsigned MaxGetBits = bitwidth<uint32_t>();
+  static constexpr unsigned MaxGetBits = Size / 2;
 
-  // maximal number of bytes the implementation may read.
-  // NOTE: this is not the same as MaxGetBits/8 !!!
-  static constexpr unsigned MaxProcessBytes = 8;
+  static_assert(MaxGetBits >= bitwidth<uint32_t>(), "cache is too small");
 };
 
-struct BitStreamCacheLeftInRightOut : BitStreamCacheBase
-{
+template <typename T>
+struct BitStreamCacheLeftInRightOutImpl : BitStreamCacheStorage<T> {
+  using BitStreamCacheStorage<T>::cache;
+  using BitStreamCacheStorage<T>::fillLevel;
+
   inline void push(uint64_t bits, uint32_t count) noexcept {
     assert(count + fillLevel <= bitwidth(cache));
-    cache |= bits << fillLevel;
+    cache |= static_cast<T>(bits) << fillLevel;
     fillLevel += count;
   }
 
   inline uint32_t peek(uint32_t count) const noexcept {
-    return cache & ((1U << count) - 1U);
+    assert(count <= bitwidth<uint32_t>());
+    return static_cast<uint32_t>(cache) & ((1U << count) - 1U);
   }
 
   inline void skip(uint32_t count) noexcept {
@@ -74,8 +85,11 @@ struct BitStreamCacheLeftInRightOut : BitStreamCacheBase
   }
 };
 
-struct BitStreamCacheRightInLeftOut : BitStreamCacheBase
-{
+template <typename T>
+struct BitStreamCacheRightInLeftOutImpl : BitStreamCacheStorage<T> {
+  using BitStreamCacheStorage<T>::cache;
+  using BitStreamCacheStorage<T>::fillLevel;
+
   inline void push(uint64_t bits, uint32_t count) noexcept {
     assert(count + fillLevel <= bitwidth(cache));
     assert(count < bitwidth(cache));
@@ -84,13 +98,37 @@ struct BitStreamCacheRightInLeftOut : BitStreamCacheBase
   }
 
   inline uint32_t peek(uint32_t count) const noexcept {
-    return extractHighBits(cache, count, /*effectiveBitwidth=*/fillLevel) &
+    assert(count <= bitwidth<uint32_t>());
+    assert(count <= fillLevel);
+    return static_cast<uint32_t>(cache >> (fillLevel - count)) &
            ((1U << count) - 1U);
   }
 
   inline void skip(uint32_t count) noexcept { fillLevel -= count; }
 };
 
+using BitStreamCacheLeftInRightOut = BitStreamCacheLeftInRightOutImpl<uint64_t>;
+using BitStreamCacheRightInLeftOut = BitStreamCacheRightInLeftOutImpl<uint64_t>;
+
+#if defined(__SIZEOF_INT128__)
+#define HAVE_BITSTREAM_WIDE_CACHE 1
+__extension__ typedef unsigned __int128 BitStreamCacheWideStorageType;
+
+using BitStreamCacheLeftInRightOutWide =
+    BitStreamCacheLeftInRightOutImpl<BitStreamCacheWideStorageType>;
+using BitStreamCacheRightInLeftOutWide =
+    BitStreamCacheRightInLeftOutImpl<BitStreamCacheWideStorageType>;
+#endif
+
+// Each BitStream tag has to specialize this, and provide a
+//   template <typename Cache> static Buffer::size_type
+//   fillCache(Cache* cache, const uint8_t* input, Buffer::size_type bufferSize,
+//             Buffer::size_type* bufPos);
+// It needs to process up to BitStreamCacheBase::MaxProcessBytes bytes of
+// input, push at least 32 bits into the cache (or fill it completely),
+// and return the number of bytes processed.
+template <typename Tag> struct BitStreamFiller;
+
 template <typename BIT_STREAM> struct BitStreamTraits final {
   static constexpr bool canUseWithHuffmanTable = false;
 };
@@ -105,12 +143,6 @@ class BitStream final : public ByteStream {
   // from it, but have to read as much as we can and fill rest with zeros.
   std::array<uint8_t, BitStreamCacheBase::MaxProcessBytes> tmp = {};
 
-  // this method hase to be implemented in the concrete BitStream template
-  // specializations. It will return the number of bytes processed. It needs
-  // to process up to BitStreamCacheBase::MaxProcessBytes bytes of input.
-  size_type fillCache(const uint8_t* input, size_type bufferSize,
-                      size_type* bufPos);
-
 public:
   BitStream() = default;
 
@@ -138,19 +170,41 @@ private:
     if (pos > size + BitStreamCacheBase::MaxProcessBytes)
       ThrowIOE("Buffer overflow read in BitStream");
 
-    tmp.fill(0);
-
     // How many bytes are left in input buffer?
     // Since pos can be past-the-end we need to carefully handle overflow.
     Buffer::size_type bytesRemaining = (pos < size) ? size - pos : 0;
     // And if we are not at the end of the input, we may have more than we need.
-    bytesRemaining =
-        std::min(BitStreamCacheBase::MaxProcessBytes, bytesRemaining);
+    bytesRemaining = std::min<Buffer::size_type>(
+        BitStreamCacheBase::MaxProcessBytes, bytesRemaining);
+
+    // If the tail padding of the buffer covers the read, we can just always
+    // read MaxProcessBytes, and then mask-off the bytes past the end.
+    if (pos + BitStreamCacheBase::MaxProcessBytes <= size + padding)
+      return getPaddedInput(bytesRemaining);
 
+    tmp.fill(0);
     memcpy(tmp.data(), data + pos, bytesRemaining);
     return tmp.data();
   }
 
+  inline const uint8_t* getPaddedInput(Buffer::size_type bytesRemaining) {
+    static_assert(BitStreamCacheBase::MaxProcessBytes == sizeof(uint64_t),
+                  "check implementation");
+    static constexpr std::array<uint8_t, 2 * sizeof(uint64_t)> masks = {
+        {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0, 0, 0, 0,
+         0}};
+
+    assert(bytesRemaining <= BitStreamCacheBase::MaxProcessBytes);
+
+    uint64_t in;
+    memcpy(&in, data + pos, sizeof(in));
+    uint64_t mask;
+    memcpy(&mask, &masks[sizeof(mask) - bytesRemaining], sizeof(mask));
+    in &= mask;
+    memcpy(tmp.data(), &in, sizeof(in));
+    return tmp.data();
+  }
+
 public:
   inline void fill(uint32_t nbits = Cache::MaxGetBits) {
     assert(data);
@@ -159,7 +213,14 @@ public:
     if (cache.fillLevel >= nbits)
       return;
 
-    pos += fillCache(getInput(), size, &pos);
+    // Each fillCache() provides at least 32 bits. If the cache is wider,
+    // fill it up to MaxGetBits, not just to nbits, so that the next requests
+    // are served without refilling.
+    for (unsigned i = 0; i != Cache::MaxGetBits / 32; ++i) {
+      if (i != 0 && cache.fillLevel >= Cache::MaxGetBits)
+        break;
+      pos += BitStreamFiller<Tag>::fillCache(&cache, getInput(), size, &pos);
+    }
   }
 
   // these methods might be specialized by implementations that support it
@@ -169,6 +230,11 @@ public:
 
   inline size_type getFillLevel() const { return cache.fillLevel; }
 
+  // The number of bits consumed so far.
+  inline uint64_t getBitPosition() const {
+    return 8 * uint64_t(pos) - cache.fillLevel;
+  }
+
   // rewinds to the beginning of the buffer.
   void resetBufferPosition() {
     pos = 0;
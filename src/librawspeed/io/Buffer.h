@@ -27,7 +27,9 @@
 #include "io/Endianness.h"    // for Endianness, getHostEndianness, Endiann...
 #include "io/IOException.h"   // for ThrowIOE
 #include <cassert>            // for assert
-#include <cstdint>            // for uint8_t, uint64_t, uint32_t
+#include <cinttypes>          // for PRIu64
+#include <cstdint>            // for uint8_t, uint64_t
+#include <cstring>            // for memset
 #include <memory>             // for unique_ptr
 #include <utility>            // for move, swap
 
@@ -41,31 +43,48 @@ namespace rawspeed {
  * It supports move operations to properly deal with ownership transfer.
  * It intentionally supports only read/const access to the underlying memory.
  *
+ * The buffer may also know that some bytes past its end are readable
+ * (the padding). Their contents are unspecified: for buffers allocated via
+ * Create() they are zeros, for sub-views they are the following bytes of the
+ * parent buffer. They must never affect the result, but they allow reading
+ * a few bytes at a time without checking for the end of the buffer.
+ *
  *************************************************************************/
 class Buffer
 {
 public:
-  using size_type = uint32_t;
+  using size_type = uint64_t;
+
+  // how many zero bytes Create() allocates past the requested size.
+  static constexpr size_type TailPadding = 16;
 
 protected:
   const uint8_t* data = nullptr;
   size_type size = 0;
+  size_type padding = 0; // readable bytes past the end, see above
   bool isOwner = false;
 
 public:
   // allocates the databuffer, and returns owning non-const pointer.
+  // there are (at least) TailPadding zero bytes past the end of it.
   static std::unique_ptr<uint8_t, decltype(&alignedFree)>
   Create(size_type size) {
     if (!size)
       ThrowIOE("Trying to allocate 0 bytes sized buffer.");
 
+    size_type allocSize;
+    if (__builtin_add_overflow(size, TailPadding, &allocSize))
+      ThrowIOE("Failed to allocate %" PRIu64 " bytes memory buffer.", size);
+    allocSize = roundUp(allocSize, 16);
+
     std::unique_ptr<uint8_t, decltype(&alignedFree)> data(
-        alignedMalloc<uint8_t, 16>(roundUp(size, 16)),
-        &alignedFree);
+        alignedMalloc<uint8_t, 16>(allocSize), &alignedFree);
     if (!data)
-      ThrowIOE("Failed to allocate %uz bytes memory buffer.", size);
+      ThrowIOE("Failed to allocate %" PRIu64 " bytes memory buffer.", size);
+
+    assert(!ASan::RegionIsPoisoned(data.get(), allocSize));
 
-    assert(!ASan::RegionIsPoisoned(data.get(), size));
+    memset(data.get() + size, 0, allocSize - size);
 
     return data;
   }
@@ -73,10 +92,10 @@ public:
   // constructs an empty buffer
   Buffer() = default;
 
-  // creates buffer from owning unique_ptr
+  // creates buffer from owning unique_ptr, as returned by Create(size_)
   Buffer(std::unique_ptr<uint8_t, decltype(&alignedFree)> data_,
          size_type size_)
-      : size(size_) {
+      : size(size_), padding(TailPadding) {
     if (!size)
       ThrowIOE("Buffer has zero size?");
 
@@ -87,25 +106,29 @@ public:
     if (!data)
       ThrowIOE("Memory buffer is nonexistent");
 
-    assert(!ASan::RegionIsPoisoned(data, size));
+    assert(!ASan::RegionIsPoisoned(data, size + padding));
 
     isOwner = true;
   }
 
-  // Data already allocated
-  explicit Buffer(const uint8_t* data_, size_type size_)
-      : data(data_), size(size_) {
-    assert(!ASan::RegionIsPoisoned(data, size));
+  // Data already allocated. If padding_ is specified, that many bytes
+  // past the end of it must be readable too.
+  explicit Buffer(const uint8_t* data_, size_type size_,
+                  size_type padding_ = 0)
+      : data(data_), size(size_), padding(padding_) {
+    assert(!ASan::RegionIsPoisoned(data, size + padding));
   }
 
   // creates a (non-owning) copy / view of rhs
-  Buffer(const Buffer& rhs) : data(rhs.data), size(rhs.size) {
+  Buffer(const Buffer& rhs)
+      : data(rhs.data), size(rhs.size), padding(rhs.padding) {
     assert(!ASan::RegionIsPoisoned(data, size));
   }
 
   // Move data and ownership from rhs to this
   Buffer(Buffer&& rhs) noexcept
-      : data(rhs.data), size(rhs.size), isOwner(rhs.isOwner) {
+      : data(rhs.data), size(rhs.size), padding(rhs.padding),
+        isOwner(rhs.isOwner) {
     assert(!ASan::RegionIsPoisoned(data, size));
     rhs.isOwner = false;
   }
@@ -128,6 +151,7 @@ public:
 
     data = rhs.data;
     size = rhs.size;
+    padding = rhs.padding;
     isOwner = rhs.isOwner;
 
     assert(!ASan::RegionIsPoisoned(data, size));
@@ -143,7 +167,7 @@ public:
       return *this;
     }
 
-    Buffer unOwningTmp(rhs.data, rhs.size);
+    Buffer unOwningTmp(rhs.data, rhs.size, rhs.padding);
     *this = std::move(unOwningTmp);
     assert(!isOwner);
     assert(!ASan::RegionIsPoisoned(data, size));
@@ -155,7 +179,9 @@ public:
     if (!isValid(0, offset))
       ThrowIOE("Buffer overflow: image file may be truncated");
 
-    return Buffer(getData(offset, size_), size_);
+    const uint8_t* subData = getData(offset, size_);
+    // Everything after the sub-view is still readable.
+    return Buffer(subData, size_, (size - (offset + size_)) + padding);
   }
 
   Buffer getSubView(size_type offset) const {
@@ -205,8 +231,13 @@ public:
     return size;
   }
 
+  inline size_type getPadding() const { return padding; }
+
   inline bool isValid(size_type offset, size_type count = 1) const {
-    return static_cast<uint64_t>(offset) + count <= static_cast<uint64_t>(size);
+    size_type end;
+    if (__builtin_add_overflow(offset, count, &end))
+      return false;
+    return end <= size;
   }
 };
 
@@ -0,0 +1,103 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "io/Buffer.h"     // for Buffer, Buffer::size_type
+#include "io/Endianness.h" // for Endianness, getByteSwapped, getHostEndi...
+#include <cassert>         // for assert
+#include <cstdint>         // for uint8_t, uint16_t, uint32_t
+
+namespace rawspeed {
+
+// A cursor over a range of bytes that was already checked to be readable,
+// once, when the cursor was created (see ByteStream::getCursor()).
+// Unlike the ByteStream, the reads are not bounds-checked (only asserted),
+// so this is meant for the hot loops where the total number of the bytes
+// that will be read is known beforehand.
+class ByteCursor final {
+public:
+  using size_type = Buffer::size_type;
+
+private:
+  const uint8_t* data = nullptr;
+  size_type size = 0;
+  size_type pos = 0;
+  bool swap = false; // does the byte order differ from the native one?
+
+public:
+  ByteCursor() = default;
+
+  ByteCursor(const uint8_t* data_, size_type size_, Endianness endianness)
+      : data(data_), size(size_),
+        swap(getHostEndianness() != endianness) {
+    assert(data);
+    assert(endianness == Endianness::little || endianness == Endianness::big);
+  }
+
+  size_type getSize() const { return size; }
+  size_type getPosition() const { return pos; }
+  size_type getRemainSize() const {
+    assert(pos <= size);
+    return size - pos;
+  }
+
+  // return ByteCursor over the next size_ bytes, and skip them.
+  ByteCursor getCursor(size_type size_) {
+    assert(size_ <= getRemainSize());
+    ByteCursor ret = *this;
+    ret.data += pos;
+    ret.size = size_;
+    ret.pos = 0;
+    pos += size_;
+    return ret;
+  }
+
+  void skipBytes(size_type count) {
+    assert(count <= getRemainSize());
+    pos += count;
+  }
+
+  uint8_t peekByte(size_type i = 0) const {
+    assert(i < getRemainSize());
+    return data[pos + i];
+  }
+
+  uint8_t getByte() {
+    assert(pos < size);
+    return data[pos++];
+  }
+
+  template <typename T> T peek() const {
+    assert(sizeof(T) <= getRemainSize());
+    return getByteSwapped<T>(data + pos, swap);
+  }
+
+  template <typename T> T read() {
+    const T ret = peek<T>();
+    pos += sizeof(T);
+    return ret;
+  }
+
+  uint16_t getU16() { return read<uint16_t>(); }
+  uint32_t getU32() { return read<uint32_t>(); }
+};
+
+} // namespace rawspeed
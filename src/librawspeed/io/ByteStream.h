@@ -25,6 +25,7 @@
 #include "common/Common.h"    // for roundUp
 #include "common/Memory.h"    // for alignedMalloc
 #include "io/Buffer.h"        // for Buffer::size_type, DataBuffer, Buffer
+#include "io/ByteCursor.h"    // for ByteCursor
 #include "io/IOException.h"   // for ThrowIOE
 #include <cassert>            // for assert
 #include <cstdint>            // for uint8_t, uint16_t, int32_t, uint32_t
@@ -54,7 +55,7 @@ public:
   }
 
   inline size_type check(size_type bytes) const {
-    if (static_cast<uint64_t>(pos) + bytes > size)
+    if (!isValid(pos, bytes))
       ThrowIOE("Out of bounds access in ByteStream");
     assert(!ASan::RegionIsPoisoned(data + pos, bytes));
     return bytes;
@@ -112,6 +113,23 @@ public:
     return getStream(nmemb * size_);
   }
 
+  // Checks that the next count bytes are readable, and returns a ByteCursor
+  // that reads them without any further checks.
+  inline ByteCursor peekCursor(size_type count) const {
+    return ByteCursor(peekData(count), count, getByteOrder());
+  }
+  inline ByteCursor peekCursor(size_type nmemb, size_type size_) const {
+    return peekCursor(check(nmemb, size_));
+  }
+  inline ByteCursor getCursor(size_type count) {
+    ByteCursor ret = peekCursor(count);
+    pos += count;
+    return ret;
+  }
+  inline ByteCursor getCursor(size_type nmemb, size_type size_) {
+    return getCursor(check(nmemb, size_));
+  }
+
   inline uint8_t peekByte(size_type i = 0) const {
     assert(data);
     check(i+1);
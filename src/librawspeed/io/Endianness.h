@@ -21,9 +21,15 @@
 
 #pragma once
 
-#include <cassert> // for assert
-#include <cstdint> // for uint32_t, uint16_t, uint64_t, int16_t, int32_t
-#include <cstring> // for memcpy
+#include "rawspeedconfig.h" // for WITH_SSE2
+#include <cassert>          // for assert
+#include <cstddef>          // for size_t
+#include <cstdint>          // for uint32_t, uint16_t, uint64_t, int16_t, int32_t
+#include <cstring>          // for memcpy
+
+#ifdef WITH_SSE2
+#include <emmintrin.h> // for __m128i, _mm_loadu_si128, _mm_storeu_si128
+#endif
 
 namespace rawspeed {
 
@@ -128,6 +134,43 @@ inline uint16_t getU16LE(const void* data) { return getLE<uint16_t>(data); }
 inline uint32_t getU32BE(const void* data) { return getBE<uint32_t>(data); }
 inline uint32_t getU32LE(const void* data) { return getLE<uint32_t>(data); }
 
+// The following functions byte-swap a whole row of count 16/32-bit values,
+// read from the (possibly unaligned) src, into dst. They are the bulk
+// counterparts of getByteSwapped(), and are meant for converting the unpacked
+// pixel data of the non-native byte order.
+
+inline void swapRow16(uint16_t* dst, const void* src, size_t count) {
+  const auto* in = static_cast<const uint8_t*>(src);
+  size_t i = 0;
+#ifdef WITH_SSE2
+  for (; i + 8 <= count; i += 8) {
+    const __m128i v =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 2 * i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+  }
+#endif
+  for (; i < count; i++)
+    dst[i] = getByteSwapped<uint16_t>(in + 2 * i, true);
+}
+
+inline void swapRow32(uint32_t* dst, const void* src, size_t count) {
+  const auto* in = static_cast<const uint8_t*>(src);
+  size_t i = 0;
+#ifdef WITH_SSE2
+  for (; i + 4 <= count; i += 4) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 4 * i));
+    // First swap the 16-bit halves of each 32-bit value, then the bytes of
+    // each of the 16-bit halves.
+    v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, 0xB1), 0xB1);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                     _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8)));
+  }
+#endif
+  for (; i < count; i++)
+    dst[i] = getByteSwapped<uint32_t>(in + 4 * i, true);
+}
+
 #undef BSWAP64
 #undef BSWAP32
 #undef BSWAP16
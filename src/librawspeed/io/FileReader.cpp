@@ -20,15 +20,21 @@
 */
 
 #include "io/FileReader.h"
+#include "common/Common.h"     // for roundUp
 #include "io/Buffer.h"          // for Buffer, Buffer::size_type
 #include "io/FileIOException.h" // for ThrowFIE
+#include <cstdint>              // for uint32_t
 #include <cstdio>               // for fseek, fclose, feof, ferror, fopen
-#include <fcntl.h>              // for SEEK_END, SEEK_SET
+#include <fcntl.h>              // for SEEK_END, SEEK_SET, open, O_RDONLY
 #include <limits>               // for numeric_limits
 #include <memory>               // for unique_ptr, make_unique, operator==
 #include <utility>              // for move
 
-#if !(defined(__unix__) || defined(__APPLE__))
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h> // for mmap, munmap, posix_madvise, MAP_FAILED
+#include <sys/stat.h> // for fstat, stat
+#include <unistd.h>   // for close, sysconf, _SC_PAGESIZE
+#else
 #ifndef NOMINMAX
 #define NOMINMAX // do not want the min()/max() macros!
 #endif
@@ -41,6 +47,17 @@
 
 namespace rawspeed {
 
+// Files larger than this are never copied into a single heap allocation,
+// they can only be memory-mapped.
+static constexpr size_t MaxReadFileSize = std::numeric_limits<uint32_t>::max();
+
+FileReader::~FileReader() {
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapping)
+    munmap(mapping, mappingSize);
+#endif
+}
+
 std::unique_ptr<const Buffer> FileReader::readFile() {
   size_t fileSize = 0;
 
@@ -59,8 +76,9 @@ std::unique_ptr<const Buffer> FileReader::readFile() {
 
   fileSize = size;
 
-  if (fileSize > std::numeric_limits<Buffer::size_type>::max())
-    ThrowFIE("File is too big (%zu bytes).", fileSize);
+  if (fileSize > MaxReadFileSize)
+    ThrowFIE("File is too big (%zu bytes) to be read, map it instead.",
+             fileSize);
 
   fseek(file.get(), 0, SEEK_SET);
 
@@ -91,10 +109,10 @@ std::unique_ptr<const Buffer> FileReader::readFile() {
   LARGE_INTEGER size;
   GetFileSizeEx(file.get(), &size);
 
-  static_assert(
-      std::numeric_limits<Buffer::size_type>::max() ==
-          std::numeric_limits<decltype(size.LowPart)>::max(),
-      "once Buffer migrates to 64-bit index, this needs to be updated.");
+  // ReadFile() can not read more than MaxReadFileSize bytes at once anyway.
+  static_assert(MaxReadFileSize ==
+                    std::numeric_limits<decltype(size.LowPart)>::max(),
+                "read the file in chunks if the limit is to be raised.");
 
   if (size.HighPart > 0)
     ThrowFIE("File is too big.");
@@ -117,4 +135,76 @@ std::unique_ptr<const Buffer> FileReader::readFile() {
   return std::make_unique<Buffer>(move(dest), fileSize);
 }
 
+std::unique_ptr<const Buffer> FileReader::mapFile(Access access) {
+#if defined(__unix__) || defined(__APPLE__)
+  if (mapping)
+    ThrowFIE("File \"%s\" is already mapped.", fileName);
+
+  const int fd = open(fileName, O_RDONLY);
+  if (fd < 0)
+    ThrowFIE("Could not open file \"%s\".", fileName);
+
+  struct stat st;
+  const bool statOk = fstat(fd, &st) == 0;
+
+  const size_t fileSize =
+      statOk && st.st_size > 0 ? static_cast<size_t>(st.st_size) : 0;
+  // Past the end of the file, there must be Buffer::TailPadding readable
+  // bytes. The kernel zero-fills the rest of the last page of the file, but
+  // the file may end exactly at the page boundary, so reserve a zero page
+  // after it, and then map the file itself over the start of that area.
+  const auto pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t paddedSize = 0;
+  void* addr = MAP_FAILED;
+  if (fileSize > 0 &&
+      fileSize <= std::numeric_limits<size_t>::max() - pageSize -
+                      Buffer::TailPadding) {
+    paddedSize = roundUp(fileSize + Buffer::TailPadding, pageSize);
+    addr = mmap(nullptr, paddedSize, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS,
+                -1, 0);
+  }
+  if (addr != MAP_FAILED &&
+      mmap(addr, fileSize, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) ==
+          MAP_FAILED) {
+    munmap(addr, paddedSize);
+    addr = MAP_FAILED;
+  }
+
+  // The mapping (if any) stays valid after the descriptor is closed.
+  close(fd);
+
+  if (!statOk)
+    ThrowFIE("Could not stat file \"%s\".", fileName);
+  if (fileSize == 0)
+    ThrowFIE("File is 0 bytes.");
+  if (paddedSize == 0)
+    ThrowFIE("File is too big (%zu bytes).", fileSize);
+  if (addr == MAP_FAILED)
+    ThrowFIE("Could not map file \"%s\".", fileName);
+
+  mapping = addr;
+  mappingSize = paddedSize;
+
+  // These are only hints, failure is harmless.
+  switch (access) {
+  case Access::Sequential:
+    // The whole file will be parsed and decoded front-to-back, so ask the
+    // kernel to read ahead aggressively.
+    (void)posix_madvise(mapping, fileSize, POSIX_MADV_SEQUENTIAL);
+    (void)posix_madvise(mapping, fileSize, POSIX_MADV_WILLNEED);
+    break;
+  case Access::OnDemand:
+    // Only the touched pages should be read from disk, no read-ahead.
+    (void)posix_madvise(mapping, fileSize, POSIX_MADV_RANDOM);
+    break;
+  }
+
+  return std::make_unique<Buffer>(static_cast<const uint8_t*>(mapping),
+                                  fileSize, paddedSize - fileSize);
+#else
+  (void)access;
+  return readFile();
+#endif
+}
+
 } // namespace rawspeed
@@ -20,7 +20,8 @@
 
 #pragma once
 
-#include <memory> // for unique_ptr
+#include <cstddef> // for size_t
+#include <memory>  // for unique_ptr
 
 namespace rawspeed {
 
@@ -30,10 +31,39 @@ class FileReader
 {
   const char* fileName;
 
+  // The read-only memory mapping created by mapFile(), if any.
+  // It is unmapped when the FileReader is destroyed.
+  void* mapping = nullptr;
+  size_t mappingSize = 0;
+
 public:
+  // How the memory-mapped file is expected to be accessed.
+  enum class Access {
+    // The whole file will be parsed and decoded, read ahead aggressively.
+    Sequential,
+    // Only small parts of the file (e.g. the IFDs and makernotes) will be
+    // read. Do not read ahead, pages are only read from disk once touched.
+    // A full decode still works, just without the read-ahead.
+    OnDemand,
+  };
+
   explicit FileReader(const char* fileName_) : fileName(fileName_) {}
 
+  FileReader(const FileReader&) = delete;
+  FileReader(FileReader&&) = delete;
+  FileReader& operator=(const FileReader&) = delete;
+  FileReader& operator=(FileReader&&) = delete;
+
+  ~FileReader();
+
+  // Reads the whole file into a newly allocated buffer, which owns the memory.
   std::unique_ptr<const Buffer> readFile();
+
+  // Maps the whole file into memory, read-only, without copying it.
+  // The returned Buffer does NOT own the memory, it is only valid for as long
+  // as this FileReader is alive. Where memory mapping is not available,
+  // this falls back to readFile().
+  std::unique_ptr<const Buffer> mapFile(Access access = Access::Sequential);
 };
 
 } // namespace rawspeed
@@ -0,0 +1,105 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "io/JpegUnstuffer.h"
+#include "io/Buffer.h"     // for Buffer, Buffer::size_type, DataBuffer
+#include "io/ByteStream.h" // for ByteStream
+#include <algorithm>       // for min
+#include <cstdint>         // for uint8_t
+#include <cstring>         // for memchr, memcpy, memset
+#include <utility>         // for move
+
+namespace rawspeed {
+
+namespace {
+
+// Returns the position of the first 0xFF byte in [pos, size), or size.
+// NOTE: memchr() is vectorized (SSE2/AVX2, picked at runtime) by the libc.
+Buffer::size_type findFF(const uint8_t* data, Buffer::size_type pos,
+                         Buffer::size_type size) {
+  const auto* ff =
+      static_cast<const uint8_t*>(memchr(data + pos, 0xFF, size - pos));
+  return ff ? ff - data : size;
+}
+
+// Is the 0xFF byte at pos the start of a marker, or a stuffed data byte?
+bool isMarker(const uint8_t* data, Buffer::size_type pos,
+              Buffer::size_type size) {
+  // NOTE: BitPumpJPEG reads past-the-end bytes as zeros, so the 0xFF
+  // at the very end is a stuffed data byte too.
+  return pos + 1 < size && data[pos + 1] != 0x00;
+}
+
+} // namespace
+
+Buffer::size_type JpegUnstuffer::findMarker(const ByteStream& input) {
+  const Buffer::size_type size = input.getRemainSize();
+  const uint8_t* const data = input.peekData(size);
+
+  Buffer::size_type pos = findFF(data, 0, size);
+  while (pos != size && !isMarker(data, pos, size)) {
+    // Skip the stuffed 0xFF 0x00 (or the trailing 0xFF).
+    pos = findFF(data, std::min(pos + 2, size), size);
+  }
+  return pos;
+}
+
+JpegUnstuffer::JpegUnstuffer(const ByteStream& input) {
+  const Buffer::size_type size = input.getRemainSize();
+  const uint8_t* const data = input.peekData(size);
+
+  // First, find the first stuffed byte. Until then, there is nothing to copy.
+  Buffer::size_type pos = findFF(data, 0, size);
+  if (pos == size || isMarker(data, pos, size)) {
+    markerPos = pos;
+    stream = input.peekStream(markerPos);
+    return;
+  }
+
+  // There is something to unstuff. The result will not be any larger than the
+  // input, and Create() takes care of the tail padding.
+  auto out = Buffer::Create(size);
+  Buffer::size_type outPos = 0;
+  Buffer::size_type copyFrom = 0;
+
+  while (true) {
+    // pos is at the 0xFF byte that is not a marker: keep it, skip the 0x00.
+    memcpy(out.get() + outPos, data + copyFrom, pos + 1 - copyFrom);
+    outPos += pos + 1 - copyFrom;
+    copyFrom = std::min<Buffer::size_type>(pos + 2, size);
+
+    pos = findFF(data, copyFrom, size);
+    if (pos == size || isMarker(data, pos, size))
+      break;
+  }
+
+  // Copy the rest, up to the marker (or the end).
+  memcpy(out.get() + outPos, data + copyFrom, pos - copyFrom);
+  outPos += pos - copyFrom;
+  markerPos = pos;
+
+  // Whatever is after the data is read as padding, keep it deterministic.
+  memset(out.get() + outPos, 0, size - outPos);
+
+  storage = Buffer(std::move(out), outPos);
+  stream = ByteStream(DataBuffer(storage, input.getByteOrder()));
+}
+
+} // namespace rawspeed
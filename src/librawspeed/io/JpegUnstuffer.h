@@ -0,0 +1,62 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#pragma once
+
+#include "io/Buffer.h"     // for Buffer, Buffer::size_type
+#include "io/ByteStream.h" // for ByteStream
+
+namespace rawspeed {
+
+// Prepares the JPEG entropy-coded segment for reading with the
+// BitPumpJPEGUnstuffed: the segment is cut at the first marker (0xFF followed
+// by non-0x00 byte), and the byte stuffing (0xFF 0x00 -> 0xFF) is removed.
+// Reading the result with the BitPumpJPEGUnstuffed gives the same bits as
+// reading the original input with the BitPumpJPEG, including the zeros past
+// the marker.
+// If there was nothing to unstuff, no copy is made, the result is just a view
+// of the input.
+class JpegUnstuffer final {
+  Buffer storage;
+  ByteStream stream;
+  Buffer::size_type markerPos = 0;
+
+public:
+  explicit JpegUnstuffer(const ByteStream& input);
+
+  JpegUnstuffer(const JpegUnstuffer&) = delete;
+  JpegUnstuffer& operator=(const JpegUnstuffer&) = delete;
+
+  // The data bytes of the segment.
+  const ByteStream& getStream() const { return stream; }
+
+  // The position (relative to the input) of the marker that ends the segment,
+  // or the size of the input, if there was no marker.
+  Buffer::size_type getMarkerPosition() const { return markerPos; }
+
+  // Did the input contain stuffed bytes (and thus had to be copied)?
+  bool isCopy() const { return storage.getSize() != 0; }
+
+  // Just the position of the first marker in the input (or the size of the
+  // input, if there is none), without unstuffing (and copying) anything.
+  static Buffer::size_type findMarker(const ByteStream& input);
+};
+
+} // namespace rawspeed
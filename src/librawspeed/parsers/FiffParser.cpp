@@ -33,6 +33,7 @@
 #include "tiff/TiffEntry.h"              // for TiffEntry, TIFF_SHORT, TIFF...
 #include "tiff/TiffIFD.h"                // for TiffIFD, TiffRootIFDOwner
 #include "tiff/TiffTag.h"                // for FUJIOLDWB, FUJI_STRIPBYTECO...
+#include <algorithm>                     // for min
 #include <cstdint>                       // for uint32_t, uint16_t
 #include <limits>                        // for numeric_limits
 #include <memory>                        // for make_unique, unique_ptr
@@ -79,7 +80,10 @@ void FiffParser::parseData() {
       subIFD->add(std::make_unique<TiffEntry>(
           subIFD.get(), FUJI_STRIPOFFSETS, TIFF_OFFSET, 1,
           ByteStream::createCopy(&rawOffset, 4)));
-      uint32_t max_size = mInput->getSize() - second_ifd;
+      // The entry is a TIFF_LONG, and this is only an upper bound anyway.
+      const Buffer::size_type remaining = mInput->getSize() - second_ifd;
+      uint32_t max_size = std::min<Buffer::size_type>(
+          remaining, std::numeric_limits<uint32_t>::max());
       subIFD->add(std::make_unique<TiffEntry>(
           subIFD.get(), FUJI_STRIPBYTECOUNTS, TIFF_LONG, 1,
           ByteStream::createCopy(&max_size, 4)));
@@ -22,6 +22,7 @@
 
 #include "tiff/TiffEntry.h"
 #include "common/Common.h"               // for uint32_t, int16_t, uint16_t
+#include "io/Buffer.h"                    // for Buffer, Buffer::size_type
 #include "parsers/TiffParserException.h" // for ThrowTPE
 #include "tiff/TiffIFD.h"                // for TiffIFD, TiffRootIFD
 #include "tiff/TiffTag.h"                // for TiffTag, DNGPRIVATEDATA
@@ -56,7 +57,7 @@ TiffEntry::TiffEntry(TiffIFD* parent_, ByteStream* bs)
     ThrowTPE("integer overflow in size calculation.");
 
   uint32_t byte_size = count << datashifts[type];
-  uint32_t data_offset = UINT32_MAX;
+  Buffer::size_type data_offset = UINT32_MAX;
 
   if (byte_size <= 4) {
     data_offset = bs->getPosition();
@@ -97,7 +97,7 @@ TiffIFD::TiffIFD(TiffIFD* parent_) : parent(parent_) {
 }
 
 TiffIFD::TiffIFD(TiffIFD* parent_, NORangesSet<Buffer>* ifds,
-                 const DataBuffer& data, uint32_t offset)
+                 const DataBuffer& data, Buffer::size_type offset)
     : TiffIFD(parent_) {
   // see TiffParser::parse: UINT32_MAX is used to mark the "virtual" top level
   // TiffRootIFD in a tiff file
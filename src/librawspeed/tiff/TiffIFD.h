@@ -23,7 +23,7 @@
 #pragma once
 
 #include "common/NORangesSet.h"          // for set
-#include "io/Buffer.h"                   // for Buffer (ptr only), DataBuffer
+#include "io/Buffer.h"                   // for Buffer, Buffer::size_type, ...
 #include "io/ByteStream.h"               // for ByteStream
 #include "io/Endianness.h"               // for Endianness, Endianness::big
 #include "parsers/TiffParserException.h" // for ThrowTPE
@@ -97,7 +97,7 @@ public:
   explicit TiffIFD(TiffIFD* parent);
 
   TiffIFD(TiffIFD* parent, NORangesSet<Buffer>* ifds, const DataBuffer& data,
-          uint32_t offset);
+          Buffer::size_type offset);
 
   virtual ~TiffIFD() = default;
 
@@ -131,7 +131,7 @@ public:
   const DataBuffer rootBuffer;
 
   TiffRootIFD(TiffIFD* parent_, NORangesSet<Buffer>* ifds,
-              const DataBuffer& data, uint32_t offset)
+              const DataBuffer& data, Buffer::size_type offset)
       : TiffIFD(parent_, ifds, data, offset), rootBuffer(data) {}
 
   // find the MAKE and MODEL tags identifying the camera
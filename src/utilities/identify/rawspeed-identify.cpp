@@ -171,7 +171,7 @@ int main(int argc, char* argv[]) { // NOLINT
 
     FileReader f(imageFileName);
 
-    auto m(f.readFile());
+    auto m(f.mapFile());
 
     RawParser t(m.get());
 
@@ -18,26 +18,32 @@
     Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
 */
 
-#include "RawSpeed-API.h"        // for RawDecoder, FileReader, HAVE_OPENMP
-#include "common/ChecksumFile.h" // for ChecksumFileEntry, ReadChecksumFile
-#include <algorithm>             // for max
-#include <benchmark/benchmark.h> // for Counter, Counter::Flags, Counter::k...
-#include <chrono>                // for duration, high_resolution_clock
-#include <ctime>                 // for clock, clock_t
-#include <memory>                // for unique_ptr
-#include <ratio>                 // for ratio
-#include <string>                // for string, operator!=, to_string
-#include <sys/time.h>            // for CLOCKS_PER_SEC
-#include <vector>                // for vector
-
-#ifdef HAVE_OPENMP
-#include <omp.h>
-#endif
+#include "RawSpeed-API.h"           // for RawDecoder, BatchFileReader, HAVE_...
+#include "common/ChecksumFile.h"    // for ChecksumFileEntry, ReadChecksumFile
+#include "common/CpuSet.h"          // for getNumaNodes
+#include "common/ExecutionPolicy.h" // for ExecutionPolicy
+#include <algorithm>                // for max, min
+#include <benchmark/benchmark.h>    // for Counter, Counter::Flags, Counter::...
+#include <chrono>                   // for duration, high_resolution_clock
+#include <cstddef>                  // for size_t
+#include <ctime>                    // for clock, clock_t
+#include <functional>               // for function
+#include <map>                      // for map
+#include <memory>                   // for unique_ptr, make_unique
+#include <mutex>                    // for mutex, lock_guard
+#include <ratio>                    // for ratio
+#include <string>                   // for string, operator!=, to_string
+#include <sys/time.h>               // for CLOCKS_PER_SEC
+#include <thread>                   // for thread, get_id
+#include <utility>                  // for move
+#include <vector>                   // for vector
 
 #define HAVE_STEADY_CLOCK
 
+using rawspeed::BatchFileReader;
+using rawspeed::Buffer;
 using rawspeed::CameraMetaData;
-using rawspeed::FileReader;
+using rawspeed::ExecutionPolicy;
 using rawspeed::RawImage;
 using rawspeed::RawParser;
 
@@ -90,15 +96,118 @@ template <typename Clock, typename period = std::ratio<1, 1>> struct Timer {
 
 } // namespace
 
-static int currThreadCount;
+// If set, the buffer of the image is reused from one iteration to the next,
+// instead of being allocated (and faulted-in) anew each time.
+static bool useImagePool;
+
+// Reads the files in the order the benchmarks were registered, and thus run,
+// so that the next file is being read while the current one is benchmarked.
+static std::unique_ptr<BatchFileReader> reader;
+
+static const Buffer* getFile(const std::string& fileName) {
+  // Each file may be benchmarked several times in a row, keep it around.
+  static BatchFileReader::File current;
 
-extern "C" int __attribute__((pure)) rawspeed_get_number_of_processor_cores() {
-  return currThreadCount;
+  while (current.fileName != fileName) {
+    if (!reader->next(&current))
+      return nullptr;
+  }
+
+  return current.get();
+}
+
+// Runs the loops on the default executor, and keeps track of how long each
+// thread spends in the loop bodies. If the busiest thread was busy for much
+// longer than the average one, the work was not evenly split between them.
+class BusyTimeExecutor final : public rawspeed::Executor {
+  struct ThreadState {
+    int depth = 0; // Of the nested loop bodies, only the outermost counts.
+    std::chrono::steady_clock::time_point start;
+    std::chrono::duration<double> busy{0};
+  };
+
+  rawspeed::Executor& executor = rawspeed::getDefaultExecutor();
+
+  std::mutex mutex;
+  std::map<std::thread::id, ThreadState> threads;
+
+  void enter() {
+    std::lock_guard<std::mutex> guard(mutex);
+    ThreadState& thread = threads[std::this_thread::get_id()];
+    if (thread.depth++ == 0)
+      thread.start = std::chrono::steady_clock::now();
+  }
+
+  void leave() {
+    std::lock_guard<std::mutex> guard(mutex);
+    ThreadState& thread = threads[std::this_thread::get_id()];
+    if (--thread.depth == 0)
+      thread.busy += std::chrono::steady_clock::now() - thread.start;
+  }
+
+public:
+  int getConcurrency() const override { return executor.getConcurrency(); }
+
+  using Executor::parallelFor;
+  void parallelFor(int begin, int end, int grainSize, int maxThreads,
+                   const std::function<void(int, int)>& body) override {
+    executor.parallelFor(begin, end, grainSize, maxThreads,
+                         [this, &body](int chunkBegin, int chunkEnd) {
+                           enter();
+                           try {
+                             body(chunkBegin, chunkEnd);
+                           } catch (...) {
+                             leave();
+                             throw;
+                           }
+                           leave();
+                         });
+  }
+
+  // In seconds, summed over all the threads, and of the busiest one.
+  double getTotalBusyTime() {
+    std::lock_guard<std::mutex> guard(mutex);
+    double total = 0;
+    for (const auto& thread : threads)
+      total += thread.second.busy.count();
+    return total;
+  }
+
+  double getMaxBusyTime() {
+    std::lock_guard<std::mutex> guard(mutex);
+    double max = 0;
+    for (const auto& thread : threads)
+      max = std::max(max, thread.second.busy.count());
+    return max;
+  }
+};
+
+// Where the decoding may run, for the affinity sweep.
+struct Affinity {
+  std::string name;
+  ExecutionPolicy policy;
+};
+
+// Anywhere, and on each one of the NUMA nodes. Since the image is allocated
+// by the pinned threads, comparing these shows what crossing nodes costs.
+static std::vector<Affinity> getAffinities() {
+  std::vector<Affinity> affinities(1);
+  affinities.front().name = "any";
+
+  for (int node : rawspeed::getNumaNodes()) {
+    Affinity affinity;
+    affinity.name = "node" + std::to_string(node);
+    affinity.policy.numaNode = node;
+    if (!affinity.policy.getAllowedCpus().empty())
+      affinities.emplace_back(std::move(affinity));
+  }
+
+  return affinities;
 }
 
 static inline void BM_RawSpeed(benchmark::State& state, const char* fileName,
-                               int threads) {
-  currThreadCount = threads;
+                               int threads, ExecutionPolicy policy) {
+  policy.maxThreads = threads;
 
 #ifdef HAVE_PUGIXML
   static const CameraMetaData metadata(RAWSPEED_SOURCE_DIR "/data/cameras.xml");
@@ -106,18 +215,32 @@ static inline void BM_RawSpeed(benchmark::State& state, const char* fileName,
   static const CameraMetaData metadata{};
 #endif
 
-  FileReader reader(fileName);
-  const auto map(reader.readFile());
+  const Buffer* map = getFile(fileName);
+  if (!map) {
+    state.SkipWithError("File was not read ahead, benchmarks ran out of order");
+    return;
+  }
+
+  BusyTimeExecutor executor;
+
+  // Plenty for any one raw.
+  static constexpr size_t MaxIdleBytes = size_t(1) << 30;
+  std::unique_ptr<rawspeed::RawImagePool> pool;
+  if (useImagePool)
+    pool = std::make_unique<rawspeed::RawImagePool>(MaxIdleBytes);
 
   Timer<ChooseClockType::type> WT;
   Timer<CPUClock> TT;
 
   unsigned pixels = 0;
   for (auto _ : state) {
-    RawParser parser(map.get());
+    RawParser parser(map);
     auto decoder(parser.getDecoder(&metadata));
 
     decoder->failOnUnknown = false;
+    decoder->executor = &executor;
+    decoder->executionPolicy = policy;
+    decoder->imagePool = pool.get();
     decoder->checkSupport(&metadata);
 
     decoder->decodeRaw();
@@ -155,15 +278,41 @@ static inline void BM_RawSpeed(benchmark::State& state, const char* fileName,
        benchmark::Counter(1.0 / WallTime,
                           benchmark::Counter::Flags::kIsIterationInvariant)},
   });
+
+  // How much of the wall time the threads spent in the parallel loops, and
+  // how unevenly (1 is perfectly even, `threads` is all on one thread).
+  const double busyTime = executor.getTotalBusyTime();
+  if (busyTime > 0) {
+    state.counters.insert({
+        {"BusyTime/WallTime", busyTime / WallTime},
+        {"MaxBusyTime/MeanBusyTime",
+         executor.getMaxBusyTime() * threads / busyTime},
+    });
+  }
+
+  if (pool) {
+    const rawspeed::RawImagePool::Stats stats = pool->getStats();
+    state.counters.insert({
+        {"ImagePoolHits", stats.hits},
+        {"ImagePoolMisses", stats.misses},
+    });
+  }
+
   // Could also have counters wrt. the filesize,
   // but i'm not sure they are interesting.
 }
 
-static void addBench(const char* fName, std::string tName, int threads) {
+static void addBench(const char* fName, std::string tName, int threads,
+                     const Affinity* affinity) {
   tName += std::to_string(threads);
+  ExecutionPolicy policy;
+  if (affinity) {
+    tName += "/affinity:" + affinity->name;
+    policy = affinity->policy;
+  }
 
-  auto* b =
-      benchmark::RegisterBenchmark(tName.c_str(), &BM_RawSpeed, fName, threads);
+  auto* b = benchmark::RegisterBenchmark(tName.c_str(), &BM_RawSpeed, fName,
+                                         threads, policy);
   b->Unit(benchmark::kMillisecond);
   b->UseRealTime();
   b->MeasureProcessCPUTime();
@@ -184,12 +333,10 @@ int main(int argc, char** argv) {
   };
 
   bool threading = hasFlag("-t");
+  bool sweepAffinity = hasFlag("-a");
+  useImagePool = hasFlag("-p");
 
-#ifdef HAVE_OPENMP
-  const auto threadsMax = omp_get_max_threads();
-#else
-  const auto threadsMax = 1;
-#endif
+  const auto threadsMax = rawspeed::getDefaultExecutor().getConcurrency();
 
   const auto threadsMin = threading ? 1 : threadsMax;
 
@@ -217,15 +364,31 @@ int main(int argc, char** argv) {
     ChecksumFileEntries.emplace_back(Entry);
   }
 
+  const std::vector<Affinity> affinities =
+      sweepAffinity ? getAffinities() : std::vector<Affinity>();
+
   // And finally, actually add the raws to be benchmarked.
   for (const auto& Entry : ChecksumFileEntries) {
     const char* fName = Entry.RelFileName.c_str();
     std::string tName(fName);
     tName += "/threads:";
 
-    for (auto threads = threadsMin; threads <= threadsMax; threads++)
-      addBench(Entry.FullFileName.c_str(), tName, threads);
+    if (!sweepAffinity) {
+      for (auto threads = threadsMin; threads <= threadsMax; threads++)
+        addBench(Entry.FullFileName.c_str(), tName, threads, nullptr);
+      continue;
+    }
+
+    for (const Affinity& affinity : affinities) {
+      const rawspeed::CpuSet cpus = affinity.policy.getAllowedCpus();
+      const int maxThreads =
+          cpus.empty() ? threadsMax : std::min(threadsMax, cpus.size());
+      for (auto threads = threadsMin; threads <= maxThreads; threads++)
+        addBench(Entry.FullFileName.c_str(), tName, threads, &affinity);
+    }
   }
 
+  reader = std::make_unique<BatchFileReader>(ChecksumFileEntries);
+
   benchmark::RunSpecifiedBenchmarks();
 }
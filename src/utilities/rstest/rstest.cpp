@@ -24,7 +24,7 @@
 #include <algorithm> // for fill, max
 #include <array>     // for array
 #include <cassert>   // for assert
-#include <chrono>    // for milliseconds, steady_clock, duration_cast
+#include <chrono>    // for duration, duration_cast, milliseconds
 #include <cstdarg>   // for va_end, va_list, va_start
 #include <cstdint>   // for uint16_t, uint32_t, uint8_t
 #include <cstdio>    // for fprintf, fclose, fopen, ftell, fwrite, size_t
@@ -32,8 +32,10 @@
 #include <fstream>   // IWYU pragma: keep
 #include <iostream>  // for cout, cerr
 #include <iterator>  // for istreambuf_iterator, operator!=
+#include <exception> // for rethrow_exception
 #include <map>       // for map
 #include <memory>    // for allocator, unique_ptr
+#include <mutex>     // for mutex, lock_guard
 #include <sstream>   // IWYU pragma: keep
 #include <string>    // for string, operator+, operator<<, char_traits
 #include <utility>   // for pair
@@ -44,7 +46,6 @@
 #include <iomanip> // for operator<<, setw
 #endif
 
-using std::chrono::steady_clock;
 using std::string;
 using std::ostringstream;
 using std::vector;
@@ -55,9 +56,11 @@ using std::cout;
 using std::endl;
 using std::map;
 using std::cerr;
+using rawspeed::BatchDecoder;
+using rawspeed::BatchFileReader;
+using rawspeed::Buffer;
 using rawspeed::CameraMetaData;
-using rawspeed::FileReader;
-using rawspeed::RawParser;
+using rawspeed::RawDecoder;
 using rawspeed::RawImage;
 using rawspeed::iPoint2D;
 using rawspeed::TYPE_USHORT16;
@@ -92,29 +95,18 @@ struct options {
   bool dump;
 };
 
-size_t process(const std::string& filename,
-               const rawspeed::CameraMetaData* metadata, const options& o);
+bool skip(const std::string& filename, const options& o);
+
+void process(const rawspeed::BatchDecoder::Result& result, const options& o);
 
 class RstestHashMismatch final : public rawspeed::RawspeedException {
 public:
-  size_t time;
-
   explicit RAWSPEED_UNLIKELY_FUNCTION RAWSPEED_NOINLINE
-  RstestHashMismatch(const char* msg, size_t time_)
-      : RawspeedException(msg), time(time_) {}
+  RstestHashMismatch(const char* msg) : RawspeedException(msg) {}
 };
 
-struct Timer {
-  mutable std::chrono::steady_clock::time_point start =
-      std::chrono::steady_clock::now();
-  size_t operator()() const {
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-                  std::chrono::steady_clock::now() - start)
-                  .count();
-    start = std::chrono::steady_clock::now();
-    return ms;
-  }
-};
+// The files are decoded (and then processed) by several threads at once.
+std::mutex ioMutex;
 
 // yes, this is not cool. but i see no way to compute the hash of the
 // full image, without duplicating image, and copying excluding padding
@@ -319,9 +311,7 @@ void writeImage(const RawImage& raw, const string& fn) {
   }
 }
 
-size_t process(const string& filename, const CameraMetaData* metadata,
-               const options& o) {
-
+bool skip(const string& filename, const options& o) {
   const string hashfile(filename + ".hash");
 
   // if creating hash and hash exists -> skip current file
@@ -330,50 +320,32 @@ size_t process(const string& filename, const CameraMetaData* metadata,
   ifstream hf(hashfile);
   if (hf.good() == o.create && !o.force) {
 #if !defined(__has_feature) || !__has_feature(thread_sanitizer)
-#ifdef HAVE_OPENMP
-#pragma omp critical(io)
-#endif
     cout << left << setw(55) << filename << ": hash "
          << (o.create ? "exists" : "missing") << ", skipping" << endl;
 #endif
-    return 0;
+    return true;
   }
 
-// to narrow down the list of files that could have causes the crash
-#if !defined(__has_feature) || !__has_feature(thread_sanitizer)
-#ifdef HAVE_OPENMP
-#pragma omp critical(io)
-#endif
-  cout << left << setw(55) << filename << ": starting decoding ... " << endl;
-#endif
-
-  FileReader reader(filename.c_str());
-
-  auto map(reader.readFile());
-  // Buffer* map = readFile( argv[1] );
-
-  Timer t;
-
-  RawParser parser(map.get());
-  auto decoder(parser.getDecoder(metadata));
-  // RawDecoder* decoder = parseRaw( map );
+  return false;
+}
 
-  decoder->failOnUnknown = false;
-  decoder->checkSupport(metadata);
+void process(const BatchDecoder::Result& result, const options& o) {
+  const string& filename = result.fileName;
+  const RawImage& raw = result.image;
 
-  decoder->decodeRaw();
-  decoder->decodeMetaData(metadata);
-  RawImage raw = decoder->mRaw;
-  // RawImage raw = decoder->decode();
+  const string hashfile(filename + ".hash");
+  ifstream hf(hashfile);
 
-  auto time = t();
 #if !defined(__has_feature) || !__has_feature(thread_sanitizer)
-#ifdef HAVE_OPENMP
-#pragma omp critical(io)
-#endif
-  cout << left << setw(55) << filename << ": " << internal << setw(3)
-       << map->getSize() / 1000000 << " MB / " << setw(4) << time << " ms"
-       << endl;
+  {
+    std::lock_guard<std::mutex> guard(ioMutex);
+    cout << left << setw(55) << filename << ": " << internal << setw(3)
+         << result.fileSize / 1000000 << " MB / " << setw(4)
+         << std::chrono::duration_cast<std::chrono::milliseconds>(
+                result.decodeTime)
+                .count()
+         << " ms" << endl;
+  }
 #endif
 
   if (o.create) {
@@ -389,7 +361,7 @@ size_t process(const string& filename, const CameraMetaData* metadata,
     // normally, here we would compare the old hash with the new one
     // but if the force is set, and the hash does not exist, do nothing.
     if (!hf.good() && o.force)
-      return time;
+      return;
 
     string truth((istreambuf_iterator<char>(hf)), istreambuf_iterator<char>());
     if (h != truth) {
@@ -397,11 +369,9 @@ size_t process(const string& filename, const CameraMetaData* metadata,
       f << h;
       if (o.dump)
         writeImage(raw, filename + ".failed");
-      throw RstestHashMismatch("hash/metadata mismatch", time);
+      throw RstestHashMismatch("hash/metadata mismatch");
     }
   }
-
-  return time;
 }
 
 #pragma GCC diagnostic pop
@@ -484,20 +454,19 @@ static int usage(const char* progname) {
 
 using rawspeed::rstest::usage;
 using rawspeed::rstest::options;
+using rawspeed::rstest::ioMutex;
 using rawspeed::rstest::process;
 using rawspeed::rstest::results;
+using rawspeed::rstest::skip;
 
 int main(int argc, char **argv) {
-  int remaining_argc = argc;
-
-  auto hasFlag = [argc, &remaining_argc, argv](const string& flag) {
+  auto hasFlag = [argc, argv](const string& flag) {
     bool found = false;
     for (int i = 1; i < argc; ++i) {
       if (!argv[i] || argv[i] != flag)
         continue;
       found = true;
       argv[i] = nullptr;
-      remaining_argc--;
     }
     return found;
   };
@@ -516,39 +485,51 @@ int main(int argc, char **argv) {
   const CameraMetaData metadata{};
 #endif
 
-  size_t time = 0;
-  map<string, string> failedTests;
-#ifdef HAVE_OPENMP
-#pragma omp parallel for default(none) firstprivate(argc, argv, o) \
-    OMPSHAREDCLAUSE(metadata) shared(cerr, failedTests) schedule(dynamic, 1) \
-    reduction(+ : time) if(remaining_argc > 2)
-#endif
+  vector<string> fileNames;
   for (int i = 1; i < argc; ++i) {
-    if (!argv[i])
-      continue;
+    if (argv[i] && !skip(argv[i], o))
+      fileNames.emplace_back(argv[i]);
+  }
+
+  // Reads the next file(s) while the current one(s) are being decoded.
+  BatchFileReader reader(fileNames);
 
-    try {
-      try {
-        time += process(argv[i], &metadata, o);
-      } catch (rawspeed::rstest::RstestHashMismatch& e) {
-        time += e.time;
-        throw;
-      }
-    } catch (RawspeedException& e) {
-#ifdef HAVE_OPENMP
-#pragma omp critical(io)
+  BatchDecoder batch(&metadata);
+  batch.configureDecoder = [](const string& fileName, RawDecoder* decoder) {
+    // to narrow down the list of files that could have causes the crash
+#if !defined(__has_feature) || !__has_feature(thread_sanitizer)
+    {
+      std::lock_guard<std::mutex> guard(ioMutex);
+      cout << left << setw(55) << fileName << ": starting decoding ... "
+           << endl;
+    }
 #endif
-      {
-        string msg = string(argv[i]) + " failed: " + e.what();
+    decoder->failOnUnknown = false;
+  };
+
+  map<string, string> failedTests;
+  const BatchDecoder::Stats stats =
+      batch.decode(&reader, [&o, &failedTests](BatchDecoder::Result&& result) {
+        try {
+          if (result.error)
+            std::rethrow_exception(result.error);
+          process(result, o);
+        } catch (RawspeedException& e) {
+          std::lock_guard<std::mutex> guard(ioMutex);
+          string msg = result.fileName + " failed: " + e.what();
 #if !defined(__has_feature) || !__has_feature(thread_sanitizer)
-        cerr << msg << endl;
+          cerr << msg << endl;
 #endif
-        failedTests.emplace(argv[i], msg);
-      }
-    }
-  }
+          failedTests.emplace(result.fileName, msg);
+        }
+      });
 
-  cout << "Total decoding time: " << time / 1000.0 << "s" << endl << endl;
+  cout << "Total decoding time: "
+       << std::chrono::duration<double>(stats.decodeTime).count() << "s"
+       << endl;
+  cout << "Throughput: " << stats.getMegabytesPerSecond() << " MB/s, "
+       << stats.getMegapixelsPerSecond() << " MPix/s" << endl
+       << endl;
 
   return results(failedTests, o);
 }
@@ -0,0 +1,221 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#include "common/CpuSet.h"            // for CpuSet, ScopedThreadAffinity, ...
+#include "common/ExecutionPolicy.h"   // for ExecutionPolicy
+#include "common/Executor.h"          // for Executor
+#include "common/RawspeedException.h" // for RawspeedException
+#include <algorithm>                  // for min
+#include <functional>                 // for function
+#include <gtest/gtest.h>              // for ParamIteratorInterface, ParamG...
+#include <memory>                     // for unique_ptr
+#include <string>                     // for string
+#include <tuple>                      // for make_tuple, get, tuple
+#include <vector>                     // for vector
+
+using rawspeed::CpuSet;
+using rawspeed::ExecutionPolicy;
+using rawspeed::Executor;
+using rawspeed::getNumaNodeOfCurrentThread;
+using rawspeed::getNumaNodes;
+using rawspeed::RawspeedException;
+using rawspeed::ScopedThreadAffinity;
+using std::make_tuple;
+using std::string;
+using std::vector;
+
+namespace rawspeed_test {
+
+using ParseType = std::tuple<string, vector<int>, string>;
+class CpuSetParseTest : public ::testing::TestWithParam<ParseType> {
+protected:
+  CpuSetParseTest() = default;
+  virtual void SetUp() {
+    in = std::get<0>(GetParam());
+    expected = std::get<1>(GetParam());
+    canonical = std::get<2>(GetParam());
+  }
+
+  string in;            // input
+  vector<int> expected; // expected output
+  string canonical;     // expected toString()
+};
+static const ParseType parseValues[] = {
+    make_tuple("", vector<int>{}, ""),
+    make_tuple("0", vector<int>{0}, "0"),
+    make_tuple("3", vector<int>{3}, "3"),
+    make_tuple("0-3", vector<int>{0, 1, 2, 3}, "0-3"),
+    make_tuple("0-3,8,10-11", vector<int>{0, 1, 2, 3, 8, 10, 11},
+               "0-3,8,10-11"),
+    make_tuple("2,0,1", vector<int>{0, 1, 2}, "0-2"),
+    make_tuple("1,1,0-1", vector<int>{0, 1}, "0-1"),
+    make_tuple("5-5", vector<int>{5}, "5"),
+    make_tuple("0,2,4", vector<int>{0, 2, 4}, "0,2,4"),
+};
+INSTANTIATE_TEST_CASE_P(CpuSetParseTest, CpuSetParseTest,
+                        ::testing::ValuesIn(parseValues));
+TEST_P(CpuSetParseTest, ParseTest) {
+  const CpuSet cpus = CpuSet::parse(in);
+  ASSERT_EQ(cpus.getCpus(), expected);
+  ASSERT_EQ(cpus.size(), static_cast<int>(expected.size()));
+  ASSERT_EQ(cpus.toString(), canonical);
+  ASSERT_EQ(CpuSet::parse(cpus.toString()), cpus);
+}
+
+class CpuSetParseErrorTest : public ::testing::TestWithParam<const char*> {};
+static const char* const parseErrorValues[] = {
+    "a", "-1", "1-0", "0-1-2", "0x1", " 1", "1.5", "65536", "0-100000",
+};
+INSTANTIATE_TEST_CASE_P(CpuSetParseErrorTest, CpuSetParseErrorTest,
+                        ::testing::ValuesIn(parseErrorValues));
+TEST_P(CpuSetParseErrorTest, ParseErrorTest) {
+  ASSERT_THROW(CpuSet::parse(GetParam()), RawspeedException);
+}
+
+TEST(CpuSetTest, ConstructorSortsAndDeduplicates) {
+  ASSERT_EQ(CpuSet({3, 1, 3, 2}).getCpus(), vector<int>({1, 2, 3}));
+}
+
+TEST(CpuSetTest, Intersect) {
+  const CpuSet a = CpuSet::parse("0-7");
+  const CpuSet b = CpuSet::parse("4-11");
+  ASSERT_EQ(a.intersect(b), CpuSet::parse("4-7"));
+  ASSERT_EQ(b.intersect(a), CpuSet::parse("4-7"));
+  ASSERT_TRUE(a.intersect(CpuSet::parse("8-9")).empty());
+  ASSERT_TRUE(a.intersect(CpuSet()).empty());
+}
+
+TEST(CpuSetTest, NoSuchNumaNode) {
+  ASSERT_TRUE(CpuSet::ofNumaNode(-1).empty());
+  ASSERT_TRUE(CpuSet::ofNumaNode(1 << 20).empty());
+}
+
+TEST(CpuSetTest, ScopedThreadAffinityRestores) {
+  const CpuSet before = CpuSet::ofCurrentThread();
+  if (before.empty())
+    return; // Not supported here.
+
+  {
+    const ScopedThreadAffinity affinity(CpuSet({before.getCpus().front()}));
+    ASSERT_EQ(CpuSet::ofCurrentThread(), CpuSet({before.getCpus().front()}));
+  }
+  ASSERT_EQ(CpuSet::ofCurrentThread(), before);
+
+  {
+    const ScopedThreadAffinity affinity((CpuSet()));
+    ASSERT_EQ(CpuSet::ofCurrentThread(), before);
+  }
+}
+
+TEST(CpuSetTest, NumaNodeOfCurrentThread) {
+  const CpuSet current = CpuSet::ofCurrentThread();
+  if (current.empty())
+    return; // Not supported here.
+
+  for (int node : getNumaNodes()) {
+    const CpuSet cpus = CpuSet::ofNumaNode(node).intersect(current);
+    if (cpus.empty())
+      continue;
+    const ScopedThreadAffinity affinity(cpus);
+    ASSERT_EQ(getNumaNodeOfCurrentThread(), node);
+  }
+}
+
+TEST(ExecutionPolicyTest, Unrestricted) {
+  const ExecutionPolicy policy;
+  ASSERT_TRUE(policy.getAllowedCpus().empty());
+  ASSERT_EQ(policy.makeExecutor(nullptr), nullptr);
+}
+
+TEST(ExecutionPolicyTest, AllowedCpus) {
+  ExecutionPolicy policy;
+  policy.cpus = CpuSet::parse("0-1");
+  ASSERT_EQ(policy.getAllowedCpus(), policy.cpus);
+
+  policy.numaNode = 0;
+  const CpuSet node = CpuSet::ofNumaNode(0);
+  if (node.empty())
+    ASSERT_EQ(policy.getAllowedCpus(), policy.cpus);
+  else if (node.intersect(policy.cpus).empty())
+    ASSERT_THROW(policy.getAllowedCpus(), RawspeedException);
+  else
+    ASSERT_EQ(policy.getAllowedCpus(), node.intersect(policy.cpus));
+}
+
+namespace {
+
+// Runs the chunks serially, on the calling thread, and counts the loops.
+class SerialExecutor final : public Executor {
+public:
+  int numLoops = 0;
+
+  int getConcurrency() const override { return 4; }
+
+  using Executor::parallelFor;
+  void parallelFor(int begin, int end, int grainSize, int /*maxThreads*/,
+                   const std::function<void(int, int)>& body) override {
+    numLoops++;
+    for (int chunk = begin; chunk < end; chunk += grainSize)
+      body(chunk, std::min(chunk + grainSize, end));
+  }
+};
+
+} // namespace
+
+TEST(ExecutionPolicyTest, RunsOnTheGivenExecutor) {
+  SerialExecutor executor;
+
+  ExecutionPolicy policy;
+  policy.maxThreads = 2;
+  const std::unique_ptr<Executor> limited = policy.makeExecutor(&executor);
+  ASSERT_NE(limited, nullptr);
+  ASSERT_EQ(limited->getConcurrency(), 2);
+
+  int numItems = 0;
+  limited->parallelForEach(0, 10, [&numItems](int /*i*/) { numItems++; });
+  ASSERT_EQ(numItems, 10);
+  ASSERT_EQ(executor.numLoops, 1);
+}
+
+TEST(ExecutionPolicyTest, RestrictsTheThreadsOfTheGivenExecutor) {
+  const CpuSet before = CpuSet::ofCurrentThread();
+  if (before.empty())
+    return; // Not supported here.
+
+  SerialExecutor executor;
+
+  ExecutionPolicy policy;
+  policy.cpus = CpuSet({before.getCpus().front()});
+  const std::unique_ptr<Executor> pinned = policy.makeExecutor(&executor);
+  ASSERT_NE(pinned, nullptr);
+  ASSERT_EQ(pinned->getConcurrency(), 1);
+
+  int numItems = 0;
+  pinned->parallelForEach(0, 10, [&policy, &numItems](int /*i*/) {
+    EXPECT_EQ(CpuSet::ofCurrentThread(), policy.cpus);
+    numItems++;
+  });
+  ASSERT_EQ(numItems, 10);
+  ASSERT_EQ(executor.numLoops, 1);
+  ASSERT_EQ(CpuSet::ofCurrentThread(), before);
+}
+
+} // namespace rawspeed_test
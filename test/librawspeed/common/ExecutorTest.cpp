@@ -0,0 +1,237 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "common/Executor.h"              // for Executor, LimitedExecutor, ...
+#include "common/OpenMPExecutor.h"        // for OpenMPExecutor
+#include "common/RawspeedException.h"     // for RawspeedException
+#include "common/ThreadPoolExecutor.h"    // for ThreadPoolExecutor
+#include "decoders/RawDecoderException.h" // for ThrowRDE
+#include <algorithm>                      // for min
+#include <atomic>                         // for atomic
+#include <chrono>                         // for microseconds
+#include <gtest/gtest.h>                  // for Test, Message, TestPartResult
+#include <initializer_list>               // for initializer_list
+#include <memory>                         // for unique_ptr, make_unique
+#include <mutex>                          // for mutex, lock_guard
+#include <thread>                         // for thread, sleep_for
+#include <vector>                         // for vector
+
+using rawspeed::Executor;
+using rawspeed::getLargestFirstOrder;
+using rawspeed::LimitedExecutor;
+using rawspeed::OpenMPExecutor;
+using rawspeed::RawspeedException;
+using rawspeed::TaskGroup;
+using rawspeed::ThreadPoolExecutor;
+
+namespace rawspeed_test {
+
+class ExecutorTest : public ::testing::TestWithParam<int> {
+protected:
+  std::unique_ptr<Executor> pool;
+  std::unique_ptr<Executor> executor;
+
+  void SetUp() override {
+    switch (GetParam()) {
+    case 0:
+      executor = std::make_unique<ThreadPoolExecutor>(1);
+      break;
+    case 1:
+      executor = std::make_unique<ThreadPoolExecutor>(4);
+      break;
+    case 2:
+      executor = std::make_unique<OpenMPExecutor>(4);
+      break;
+    case 3:
+      pool = std::make_unique<ThreadPoolExecutor>(4);
+      executor = std::make_unique<LimitedExecutor>(pool.get(), 2);
+      break;
+    default:
+      FAIL();
+    }
+  }
+};
+
+INSTANTIATE_TEST_CASE_P(Executors, ExecutorTest,
+                        ::testing::Values(0, 1, 2, 3));
+
+TEST_P(ExecutorTest, ParallelForCoversRangeOnceTest) {
+  ASSERT_GE(executor->getConcurrency(), 1);
+
+  for (int grainSize : {1, 2, 7, 100, 1000}) {
+    const int begin = 3;
+    const int end = 1003;
+    std::vector<std::atomic<int>> visited(end);
+    for (auto& v : visited)
+      v = 0;
+
+    executor->parallelFor(
+        begin, end, grainSize, [&visited, grainSize](int b, int e) {
+          ASSERT_LT(b, e);
+          ASSERT_LE(e - b, grainSize);
+          // Busy the threads unevenly, so that the work gets stolen.
+          volatile int sink = 0;
+          for (int i = 0; i < (b % 3) * 1000; ++i)
+            sink = sink + i;
+          for (int i = b; i < e; ++i)
+            visited[i]++;
+        });
+
+    for (int i = 0; i < end; ++i)
+      ASSERT_EQ(visited[i], i < begin ? 0 : 1)
+          << "i: " << i << ", grainSize: " << grainSize;
+  }
+}
+
+TEST_P(ExecutorTest, MaxThreadsTest) {
+  for (int maxThreads : {1, 2, 3}) {
+    std::atomic<int> running{0};
+    std::atomic<int> maxRunning{0};
+    const auto body = [&running, &maxRunning](int /*b*/, int /*e*/) {
+      const int now = ++running;
+      int seen = maxRunning;
+      while (seen < now && !maxRunning.compare_exchange_weak(seen, now))
+        ;
+      std::this_thread::sleep_for(std::chrono::microseconds(100));
+      --running;
+    };
+    executor->parallelFor(0, 64, 1, maxThreads, body);
+    ASSERT_GE(maxRunning, 1);
+    ASSERT_LE(maxRunning, std::min(maxThreads, executor->getConcurrency()));
+  }
+}
+
+TEST_P(ExecutorTest, ChunksStartInOrderTest) {
+  // E.g. the largest items, see getLargestFirstOrder(), must start first.
+  std::mutex mutex;
+  std::vector<int> started;
+  executor->parallelForEach(0, 64, [&mutex, &started](int i) {
+    {
+      std::lock_guard<std::mutex> guard(mutex);
+      started.emplace_back(i);
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  });
+
+  ASSERT_EQ(started.size(), 64U);
+  // When the i'th chunk started, each one of the chunks before it was either
+  // started already, or was just being started by one of the other threads.
+  const int concurrency = executor->getConcurrency();
+  for (int pos = 0; pos < 64; ++pos)
+    ASSERT_LE(started[pos], pos + concurrency - 1) << "pos: " << pos;
+}
+
+TEST_P(ExecutorTest, EmptyRangeTest) {
+  int calls = 0;
+  executor->parallelFor(5, 5, 1, [&calls](int /*b*/, int /*e*/) { calls++; });
+  executor->parallelFor(5, 4, 1, [&calls](int /*b*/, int /*e*/) { calls++; });
+  ASSERT_EQ(calls, 0);
+}
+
+TEST_P(ExecutorTest, NestedParallelForTest) {
+  std::vector<std::atomic<int>> visited(64 * 64);
+  for (auto& v : visited)
+    v = 0;
+
+  executor->parallelForEach(0, 64, [this, &visited](int row) {
+    executor->parallelForEach(
+        0, 64, [&visited, row](int col) { visited[64 * row + col]++; });
+  });
+
+  for (const auto& v : visited)
+    ASSERT_EQ(v, 1);
+}
+
+TEST_P(ExecutorTest, ConcurrentLoopsTest) {
+  std::vector<std::atomic<int>> visited(4 * 1000);
+  for (auto& v : visited)
+    v = 0;
+
+  std::vector<std::thread> callers;
+  for (int t = 0; t < 4; ++t) {
+    callers.emplace_back([this, &visited, t]() {
+      executor->parallelForEach(1000 * t, 1000 * (t + 1),
+                                [&visited](int i) { visited[i]++; });
+    });
+  }
+  for (std::thread& caller : callers)
+    caller.join();
+
+  for (const auto& v : visited)
+    ASSERT_EQ(v, 1);
+}
+
+TEST_P(ExecutorTest, RethrowsTest) {
+  std::atomic<int> calls{0};
+  ASSERT_THROW(executor->parallelForEach(0, 1000,
+                                         [&calls](int i) {
+                                           calls++;
+                                           if (i == 0)
+                                             ThrowRDE("Bad item");
+                                         }),
+               RawspeedException);
+  ASSERT_GE(calls, 1);
+
+  // And the executor is still usable afterwards.
+  calls = 0;
+  executor->parallelForEach(0, 1000, [&calls](int /*i*/) { calls++; });
+  ASSERT_EQ(calls, 1000);
+}
+
+TEST_P(ExecutorTest, TaskGroupTest) {
+  std::atomic<int> calls{0};
+  TaskGroup tasks(executor.get());
+  for (int i = 0; i < 100; ++i)
+    tasks.run([&calls]() { calls++; });
+  tasks.wait();
+  ASSERT_EQ(calls, 100);
+  ASSERT_FALSE(tasks.isCancelled());
+}
+
+TEST_P(ExecutorTest, TaskGroupCancelTest) {
+  std::atomic<int> calls{0};
+  TaskGroup tasks(executor.get());
+  for (int i = 0; i < 100; ++i)
+    tasks.run([&calls]() { calls++; });
+  tasks.cancel();
+  tasks.wait();
+  ASSERT_EQ(calls, 0);
+  ASSERT_TRUE(tasks.isCancelled());
+}
+
+TEST_P(ExecutorTest, TaskGroupRethrowsTest) {
+  TaskGroup tasks(executor.get());
+  tasks.run([]() { ThrowRDE("Bad task"); });
+  for (int i = 0; i < 100; ++i)
+    tasks.run([]() {});
+  ASSERT_THROW(tasks.wait(), RawspeedException);
+  ASSERT_TRUE(tasks.isCancelled());
+}
+
+TEST(LargestFirstOrderTest, LargestFirstOrderTest) {
+  const std::vector<int> sizes = {3, 9, 1, 9, 0, 4};
+  ASSERT_EQ(getLargestFirstOrder(sizes, [](int size) { return size; }),
+            std::vector<int>({1, 3, 5, 0, 2, 4}));
+  ASSERT_TRUE(
+      getLargestFirstOrder(std::vector<int>(), [](int size) { return size; })
+          .empty());
+}
+
+} // namespace rawspeed_test
@@ -0,0 +1,78 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "common/PrefixSum.h" // for interleavedPrefixSum
+#include <array>              // for array
+#include <cstddef>            // for size_t
+#include <cstdint>            // for int16_t, uint16_t, int32_t
+#include <gtest/gtest.h>      // for Message, TestPartResult, Test
+#include <random>             // for minstd_rand, uniform_int_distribution
+#include <vector>             // for vector
+
+using rawspeed::interleavedPrefixSum;
+
+namespace rawspeed_test {
+
+// Compares with the obvious running sum, for all the small lengths.
+template <int N, typename T> void checkPrefixSum() {
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<int> dist(-32768, 32767);
+
+  for (size_t count = 0; count <= 8 * 8; count += N) {
+    std::vector<int16_t> in(count);
+    for (auto& d : in)
+      d = dist(rng);
+
+    std::array<T, N> initial;
+    for (auto& p : initial)
+      p = T(dist(rng));
+
+    std::vector<T> expected(count);
+    std::array<T, N> expectedPred = initial;
+    for (size_t i = 0; i < count; i++) {
+      T& p = expectedPred[i % N];
+      p = T(p + in[i]);
+      expected[i] = p;
+    }
+
+    std::vector<T> out(count);
+    std::array<T, N> pred = initial;
+    interleavedPrefixSum<N>(out.data(), in.data(), count, &pred);
+
+    ASSERT_EQ(out, expected) << "     Where count: " << count;
+    ASSERT_EQ(pred, expectedPred) << "     Where count: " << count;
+  }
+}
+
+TEST(PrefixSumTest, U16Test) {
+  checkPrefixSum<1, uint16_t>();
+  checkPrefixSum<2, uint16_t>();
+  checkPrefixSum<3, uint16_t>();
+  checkPrefixSum<4, uint16_t>();
+}
+
+TEST(PrefixSumTest, I32Test) {
+  checkPrefixSum<1, int32_t>();
+  checkPrefixSum<2, int32_t>();
+  checkPrefixSum<3, int32_t>();
+  checkPrefixSum<4, int32_t>();
+}
+
+} // namespace rawspeed_test
@@ -0,0 +1,188 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+
+#include "common/RawImagePool.h" // for RawImagePool, RawImagePool::Stats
+#include "MemorySanitizer.h"     // for __has_feature
+#include "common/CpuSet.h"       // for CpuSet, ScopedThreadAffinity, getN...
+#include "common/Point.h"        // for iPoint2D
+#include "common/RawImage.h"     // for RawImage, RawImageData, TYPE_USHORT16
+#include <chrono>                // for hours
+#include <cstdint>               // for uint8_t
+#include <cstring>               // for memset
+#include <gtest/gtest.h>         // for Test, Message, TestPartResult
+#include <vector>                // for vector
+
+using rawspeed::CpuSet;
+using rawspeed::getNumaNodes;
+using rawspeed::iPoint2D;
+using rawspeed::RawImage;
+using rawspeed::RawImagePool;
+using rawspeed::ScopedThreadAffinity;
+using rawspeed::TYPE_USHORT16;
+
+namespace rawspeed_test {
+
+static constexpr size_t MaxIdleBytes = 1024;
+
+TEST(RawImagePoolTest, ReusesSameSize) {
+  RawImagePool pool(MaxIdleBytes);
+
+  uint8_t* a = pool.acquire(4, 64);
+  ASSERT_NE(a, nullptr);
+  a[4 * 64 - 1] = 0;
+  pool.release(a, 4, 64);
+
+  // Same pitch * height.
+  uint8_t* b = pool.acquire(2, 128);
+  ASSERT_EQ(b, a);
+
+  // Different one.
+  uint8_t* c = pool.acquire(4, 32);
+  ASSERT_NE(c, nullptr);
+  ASSERT_NE(c, a);
+
+  pool.release(b, 2, 128);
+  pool.release(c, 4, 32);
+
+  const RawImagePool::Stats stats = pool.getStats();
+  ASSERT_EQ(stats.hits, 1U);
+  ASSERT_EQ(stats.misses, 2U);
+  ASSERT_EQ(stats.evictions, 0U);
+  ASSERT_EQ(stats.idleBuffers, 2U);
+  ASSERT_EQ(stats.idleBytes, 4U * 64 + 4U * 32);
+}
+
+TEST(RawImagePoolTest, KeepsAtMostMaxIdleBytes) {
+  RawImagePool pool(MaxIdleBytes);
+
+  uint8_t* a = pool.acquire(1, 512);
+  uint8_t* b = pool.acquire(1, 512);
+  uint8_t* c = pool.acquire(1, 256);
+  pool.release(a, 1, 512);
+  pool.release(b, 1, 512);
+  pool.release(c, 1, 256); // The oldest one, a, has to go.
+
+  RawImagePool::Stats stats = pool.getStats();
+  ASSERT_EQ(stats.evictions, 1U);
+  ASSERT_EQ(stats.idleBuffers, 2U);
+  ASSERT_EQ(stats.idleBytes, 512U + 256);
+
+  // Larger than the whole pool, so it is never kept.
+  pool.release(pool.acquire(1, 2 * MaxIdleBytes), 1, 2 * MaxIdleBytes);
+  stats = pool.getStats();
+  ASSERT_EQ(stats.evictions, 2U);
+  ASSERT_EQ(stats.idleBuffers, 2U);
+}
+
+TEST(RawImagePoolTest, ReleaseIdle) {
+  RawImagePool pool(MaxIdleBytes);
+  pool.release(pool.acquire(1, 64), 1, 64);
+
+  pool.releaseIdle(std::chrono::hours(1));
+  ASSERT_EQ(pool.getStats().idleBuffers, 1U);
+
+  pool.releaseIdle();
+  ASSERT_EQ(pool.getStats().idleBuffers, 0U);
+  ASSERT_EQ(pool.getStats().idleBytes, 0U);
+  ASSERT_EQ(pool.getStats().evictions, 1U);
+}
+
+#if __has_feature(memory_sanitizer) || defined(__SANITIZE_MEMORY__)
+TEST(RawImagePoolTest, ReusedBufferIsNotInitialized) {
+  RawImagePool pool(MaxIdleBytes);
+
+  uint8_t* a = pool.acquire(4, 64);
+  ASSERT_NE(a, nullptr);
+  ASSERT_EQ(__msan_test_shadow(a, 4 * 64), 0);
+  std::memset(a, 0, 4 * 64);
+  ASSERT_EQ(__msan_test_shadow(a, 4 * 64), -1);
+  pool.release(a, 4, 64);
+
+  uint8_t* b = pool.acquire(4, 64);
+  ASSERT_EQ(b, a);
+  // The pixels of the previous image are not there, as far as MSan knows.
+  ASSERT_EQ(__msan_test_shadow(b, 4 * 64), 0);
+  pool.release(b, 4, 64);
+}
+#endif
+
+TEST(RawImagePoolTest, DoesNotReuseAcrossNumaNodes) {
+  const CpuSet current = CpuSet::ofCurrentThread();
+
+  // The nodes the current thread may (partially) run on.
+  std::vector<CpuSet> nodes;
+  for (int node : getNumaNodes()) {
+    const CpuSet cpus = CpuSet::ofNumaNode(node).intersect(current);
+    if (!cpus.empty())
+      nodes.emplace_back(cpus);
+  }
+  if (nodes.size() < 2)
+    return; // Nothing to test here.
+
+  RawImagePool pool(MaxIdleBytes);
+
+  uint8_t* a;
+  {
+    const ScopedThreadAffinity affinity(nodes[0]);
+    a = pool.acquire(4, 64);
+    pool.release(a, 4, 64);
+  }
+  {
+    const ScopedThreadAffinity affinity(nodes[1]);
+    uint8_t* b = pool.acquire(4, 64);
+    ASSERT_NE(b, a);
+    pool.release(b, 4, 64);
+  }
+  {
+    const ScopedThreadAffinity affinity(nodes[0]);
+    uint8_t* c = pool.acquire(4, 64);
+    ASSERT_EQ(c, a);
+    pool.release(c, 4, 64);
+  }
+}
+
+TEST(RawImagePoolTest, RawImage) {
+  RawImagePool pool(1 << 20);
+
+  const uint8_t* data;
+  {
+    RawImage img = RawImage::create(TYPE_USHORT16);
+    img->setPool(&pool);
+    img->dim = iPoint2D(64, 32);
+    img->createData();
+    data = img->getData();
+  }
+  ASSERT_EQ(pool.getStats().misses, 1U);
+  ASSERT_EQ(pool.getStats().idleBuffers, 1U);
+
+  RawImage img = RawImage::create(TYPE_USHORT16);
+  img->setPool(&pool);
+  img->dim = iPoint2D(64, 32);
+  img->createData();
+  ASSERT_EQ(img->getData(), data);
+  ASSERT_EQ(pool.getStats().hits, 1U);
+  ASSERT_EQ(pool.getStats().idleBuffers, 0U);
+
+  img->destroyData();
+  ASSERT_EQ(pool.getStats().idleBuffers, 1U);
+}
+
+} // namespace rawspeed_test
@@ -0,0 +1,293 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decoders/BatchDecoder.h"     // for BatchDecoder, BatchDecoder::R...
+#include "common/Point.h"              // for iPoint2D
+#include "common/RawImage.h"           // for RawImage, RawImageData
+#include "common/RawspeedException.h"  // for RawspeedException
+#include "common/ThreadPoolExecutor.h" // for ThreadPoolExecutor
+#include "io/BatchFileReader.h"        // for BatchFileReader
+#include "metadata/CameraMetaData.h"   // for CameraMetaData
+#include <algorithm>                   // for find
+#include <atomic>                      // for atomic
+#include <cstdint>                     // for uint16_t, uint32_t, uint8_t
+#include <cstdio>                      // for remove
+#include <exception>                   // for rethrow_exception
+#include <fstream>                     // IWYU pragma: keep
+#include <gtest/gtest.h>               // for Message, TestPartResult, Test...
+#include <map>                         // for map
+#include <mutex>                       // for mutex, lock_guard
+#include <stdexcept>                   // for runtime_error
+#include <string>                      // for string, to_string
+#include <utility>                     // for move
+#include <vector>                      // for vector
+
+using rawspeed::BatchDecoder;
+using rawspeed::BatchFileReader;
+using rawspeed::CameraMetaData;
+using rawspeed::iPoint2D;
+using rawspeed::RawspeedException;
+using rawspeed::ThreadPoolExecutor;
+
+namespace rawspeed_test {
+
+TEST(BatchDecoderTest, ThreadBudgetTest) {
+  // A serial stream only ever gets one.
+  ASSERT_EQ(BatchDecoder::getThreadBudget(8, false, 1), 1);
+  ASSERT_EQ(BatchDecoder::getThreadBudget(8, false, 16), 1);
+
+  // Alone, it gets all of them.
+  ASSERT_EQ(BatchDecoder::getThreadBudget(8, true, 1), 8);
+  ASSERT_EQ(BatchDecoder::getThreadBudget(1, true, 1), 1);
+
+  // Else, a fair share of them, but at least one.
+  ASSERT_EQ(BatchDecoder::getThreadBudget(8, true, 2), 4);
+  ASSERT_EQ(BatchDecoder::getThreadBudget(8, true, 3), 2);
+  ASSERT_EQ(BatchDecoder::getThreadBudget(8, true, 8), 1);
+  ASSERT_EQ(BatchDecoder::getThreadBudget(8, true, 100), 1);
+
+  ASSERT_EQ(BatchDecoder::getThreadBudget(8, true, 0), 8);
+}
+
+namespace {
+
+constexpr int Width = 64;
+constexpr int Height = 48;
+constexpr int TileSize = 16;
+
+uint16_t getPixel(int seed, int x, int y) { return seed + 3 * x + 5 * y; }
+
+void putU16(std::vector<uint8_t>* out, uint32_t v) {
+  out->insert(out->end(), {uint8_t(v), uint8_t(v >> 8)});
+}
+
+void putU32(std::vector<uint8_t>* out, uint32_t v) {
+  putU16(out, v);
+  putU16(out, v >> 16);
+}
+
+// An uncompressed, tiled, 16-bit CFA DNG, the pixels are getPixel(seed).
+std::vector<uint8_t> makeDng(int seed) {
+  enum Type : uint16_t { BYTE = 1, ASCII = 2, SHORT = 3, LONG = 4 };
+  struct Entry {
+    uint16_t tag;
+    Type type;
+    std::vector<uint32_t> values;
+  };
+
+  static constexpr int TilesX = Width / TileSize;
+  static constexpr int TilesY = Height / TileSize;
+  static constexpr uint32_t TileBytes = 2 * TileSize * TileSize;
+
+  std::vector<uint8_t> out = {'I', 'I', 42, 0};
+  putU32(&out, 8 + TilesX * TilesY * TileBytes);
+
+  std::vector<uint32_t> offsets;
+  for (int tileY = 0; tileY < TilesY; tileY++) {
+    for (int tileX = 0; tileX < TilesX; tileX++) {
+      offsets.emplace_back(out.size());
+      for (int y = 0; y < TileSize; y++) {
+        for (int x = 0; x < TileSize; x++)
+          putU16(&out, getPixel(seed, TileSize * tileX + x,
+                                TileSize * tileY + y));
+      }
+    }
+  }
+
+  const auto ascii = [](const std::string& s) {
+    std::vector<uint32_t> values(s.begin(), s.end());
+    values.emplace_back(0);
+    return values;
+  };
+
+  const std::vector<uint32_t> byteCounts(offsets.size(), TileBytes);
+
+  const std::vector<Entry> entries = {
+      {254, LONG, {0}},                    // NewSubFileType
+      {256, LONG, {Width}},                // ImageWidth
+      {257, LONG, {Height}},               // ImageLength
+      {258, SHORT, {16}},                  // BitsPerSample
+      {259, SHORT, {1}},                   // Compression
+      {262, SHORT, {32803}},               // PhotometricInterpretation: CFA
+      {271, ASCII, ascii("Make")},         // Make
+      {272, ASCII, ascii("Model")},        // Model
+      {277, SHORT, {1}},                   // SamplesPerPixel
+      {284, SHORT, {1}},                   // PlanarConfiguration
+      {322, LONG, {TileSize}},             // TileWidth
+      {323, LONG, {TileSize}},             // TileLength
+      {324, LONG, offsets},                // TileOffsets
+      {325, LONG, byteCounts},             // TileByteCounts
+      {33421, SHORT, {2, 2}},              // CFARepeatPatternDim
+      {33422, BYTE, {0, 1, 1, 2}},         // CFAPattern
+      {50706, BYTE, {1, 4, 0, 0}},         // DNGVersion
+      {50708, ASCII, ascii("Make Model")}, // UniqueCameraModel
+      {50717, LONG, {65535}},              // WhiteLevel
+  };
+
+  // The values that do not fit into the entries follow the IFD.
+  const uint32_t extraOffset = out.size() + 2 + 12 * entries.size() + 4;
+  std::vector<uint8_t> extra;
+
+  putU16(&out, entries.size());
+  for (const Entry& entry : entries) {
+    std::vector<uint8_t> data;
+    for (uint32_t value : entry.values) {
+      if (entry.type == SHORT)
+        putU16(&data, value);
+      else if (entry.type == LONG)
+        putU32(&data, value);
+      else
+        data.emplace_back(value);
+    }
+
+    putU16(&out, entry.tag);
+    putU16(&out, entry.type);
+    putU32(&out, entry.values.size());
+    if (data.size() <= 4) {
+      data.resize(4);
+      out.insert(out.end(), data.begin(), data.end());
+      continue;
+    }
+    putU32(&out, extraOffset + extra.size());
+    extra.insert(extra.end(), data.begin(), data.end());
+    if (extra.size() % 2 != 0)
+      extra.emplace_back(0);
+  }
+  putU32(&out, 0); // No next IFD.
+
+  out.insert(out.end(), extra.begin(), extra.end());
+  return out;
+}
+
+// Temporary files, the i'th one is makeDng(i), unless it is listed as bad,
+// then it is not a raw at all.
+class TemporaryFiles final {
+public:
+  std::vector<std::string> names;
+
+  explicit TemporaryFiles(int count, const std::vector<int>& bad = {}) {
+    for (int i = 0; i < count; i++) {
+      names.emplace_back(::testing::TempDir() + "BatchDecoderTest." +
+                         std::to_string(i));
+      std::vector<uint8_t> data = makeDng(i);
+      if (std::find(bad.begin(), bad.end(), i) != bad.end())
+        data.assign(data.size(), 0xAA);
+      std::ofstream(names.back(), std::ios::binary)
+          .write(reinterpret_cast<const char*>(data.data()), data.size());
+    }
+  }
+
+  TemporaryFiles(const TemporaryFiles&) = delete;
+  TemporaryFiles& operator=(const TemporaryFiles&) = delete;
+
+  ~TemporaryFiles() {
+    for (const std::string& name : names)
+      std::remove(name.c_str());
+  }
+};
+
+const CameraMetaData metaData{};
+
+} // namespace
+
+TEST(BatchDecoderTest, DecodesEachFileOnceTest) {
+  const TemporaryFiles files(16, /*bad=*/{3, 10});
+  std::vector<std::string> names = files.names;
+  names.emplace_back(files.names[0] + ".missing");
+
+  ThreadPoolExecutor executor(4);
+  BatchDecoder decoder(&metaData, &executor);
+  BatchFileReader reader(names);
+
+  std::mutex mutex;
+  std::map<std::string, BatchDecoder::Result> results;
+  const BatchDecoder::Stats stats =
+      decoder.decode(&reader, [&mutex, &results](BatchDecoder::Result&& r) {
+        std::lock_guard<std::mutex> guard(mutex);
+        const std::string fileName = r.fileName;
+        ASSERT_TRUE(results.emplace(fileName, std::move(r)).second);
+      });
+
+  ASSERT_EQ(results.size(), names.size());
+  ASSERT_EQ(stats.numDecoded, 14U);
+  ASSERT_EQ(stats.numFailed, 3U);
+  ASSERT_EQ(stats.pixels, 14U * Width * Height);
+
+  for (int i = 0; i < 16; i++) {
+    const BatchDecoder::Result& result = results.at(files.names[i]);
+    if (i == 3 || i == 10) {
+      ASSERT_TRUE(result.error);
+      ASSERT_THROW(std::rethrow_exception(result.error), RawspeedException);
+      continue;
+    }
+
+    ASSERT_FALSE(result.error);
+    ASSERT_GE(result.threads, 1);
+    ASSERT_LE(result.threads, executor.getConcurrency());
+    ASSERT_EQ(result.image->dim, iPoint2D(Width, Height));
+    for (int y = 0; y < Height; y++) {
+      const auto* line = reinterpret_cast<const uint16_t*>(
+          result.image->getDataUncropped(0, y));
+      for (int x = 0; x < Width; x++)
+        ASSERT_EQ(line[x], getPixel(i, x, y));
+    }
+  }
+
+  const BatchDecoder::Result& missing = results.at(names.back());
+  ASSERT_TRUE(missing.error);
+  ASSERT_THROW(std::rethrow_exception(missing.error), RawspeedException);
+}
+
+TEST(BatchDecoderTest, SingleTiledDngGetsAllThreadsTest) {
+  const TemporaryFiles files(1);
+
+  ThreadPoolExecutor executor(4);
+  BatchDecoder decoder(&metaData, &executor);
+  BatchFileReader reader(files.names);
+
+  int threads = 0;
+  decoder.decode(&reader, [&threads](BatchDecoder::Result&& result) {
+    ASSERT_FALSE(result.error);
+    threads = result.threads;
+  });
+  ASSERT_EQ(threads, executor.getConcurrency());
+}
+
+TEST(BatchDecoderTest, CallbackExceptionStopsAndIsRethrownTest) {
+  const TemporaryFiles files(64);
+
+  ThreadPoolExecutor executor(4);
+  BatchDecoder decoder(&metaData, &executor);
+  BatchFileReader reader(files.names);
+
+  std::atomic<int> calls{0};
+  ASSERT_THROW(decoder.decode(&reader,
+                              [&calls](BatchDecoder::Result&& /*result*/) {
+                                calls++;
+                                throw std::runtime_error("Bad callback");
+                              }),
+               std::runtime_error);
+
+  // Each thread finishes the decode it is in, but starts no other one.
+  ASSERT_GE(calls, 1);
+  ASSERT_LE(calls, executor.getConcurrency());
+}
+
+} // namespace rawspeed_test
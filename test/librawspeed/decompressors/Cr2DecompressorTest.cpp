@@ -0,0 +1,279 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decompressors/Cr2Decompressor.h" // for Cr2Decompressor, Cr2Sl...
+#include "common/Executor.h"               // for Executor
+#include "common/Point.h"                  // for iPoint2D
+#include "common/RawImage.h"               // for RawImage, RawImageData
+#include "common/ThreadPoolExecutor.h"     // for ThreadPoolExecutor
+#include "decoders/RawDecoderException.h"  // for RawDecoderException
+#include "io/Buffer.h"                     // for Buffer, DataBuffer
+#include "io/ByteStream.h"                 // for ByteStream
+#include "io/Endianness.h"                 // for Endianness, Endianness:...
+#include <atomic>                          // for atomic
+#include <cstdint>                         // for uint8_t, uint32_t, uint...
+#include <functional>                      // for function
+#include <gtest/gtest.h>                   // for Message, TestPartResult
+#include <random>                          // for minstd_rand, uniform_in...
+#include <vector>                          // for vector
+
+using rawspeed::Buffer;
+using rawspeed::ByteStream;
+using rawspeed::Cr2Decompressor;
+using rawspeed::Cr2Slicing;
+using rawspeed::DataBuffer;
+using rawspeed::Endianness;
+using rawspeed::Executor;
+using rawspeed::iPoint2D;
+using rawspeed::RawDecoderException;
+using rawspeed::RawImage;
+using rawspeed::ThreadPoolExecutor;
+using rawspeed::TYPE_USHORT16;
+
+namespace rawspeed_test {
+
+namespace {
+
+constexpr int FrameWidth = 32;
+constexpr int NumComponents = 2;
+constexpr int Width = NumComponents * FrameWidth;
+constexpr int Precision = 14;
+
+// The speculative decoding never splits the stream into segments smaller
+// than 4 KiB, so a stream of 16 KiB is split into exactly 4 of those,
+// however many threads there are.
+constexpr uint64_t SegmentBits = 8 * 4096;
+constexpr int NumSegments = 4;
+
+// Writes the bits MSB-first, with the JPEG byte stuffing.
+class BitWriter final {
+  std::vector<uint8_t>* out;
+  uint32_t cache = 0;
+  int fill = 0;
+
+public:
+  explicit BitWriter(std::vector<uint8_t>* out_) : out(out_) {}
+
+  void put(uint32_t bits, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+      cache = (cache << 1) | ((bits >> i) & 1);
+      if (++fill < 8)
+        continue;
+      out->emplace_back(cache);
+      if (cache == 0xFF)
+        out->emplace_back(0x00);
+      cache = 0;
+      fill = 0;
+    }
+  }
+};
+
+// The Huffman code, followed by the difference bits.
+struct Symbol final {
+  uint32_t bits;
+  int len;
+};
+
+// The table: "0" is a zero difference, "10" is followed by 8 difference bits,
+// "110" by 4. Any code that starts with "111" is invalid.
+Symbol zero() { return {0b0, 1}; }
+Symbol diff8(uint8_t bits) { return {0b10U << 8 | bits, 2 + 8}; }
+Symbol diff4(uint8_t bits) { return {0b110U << 4 | (bits & 0xF), 3 + 4}; }
+
+class SymbolStream final {
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+
+public:
+  std::vector<Symbol> symbols;
+  uint64_t size = 0; // in bits
+
+  void put(Symbol s) {
+    symbols.emplace_back(s);
+    size += s.len;
+  }
+
+  // Random symbols, until (almost) at the given bit position.
+  void putRandomUntil(uint64_t end) {
+    std::uniform_int_distribution<int> kind(0, 2);
+    std::uniform_int_distribution<int> bits(0, 255);
+    while (size + 64 < end) {
+      switch (kind(rng)) {
+      case 0:
+        put(zero());
+        break;
+      case 1:
+        put(diff4(bits(rng)));
+        break;
+      default:
+        put(diff8(bits(rng)));
+        break;
+      }
+    }
+  }
+
+  void putZerosUntil(uint64_t end) {
+    while (size < end)
+      put(zero());
+  }
+};
+
+// The 4 segments are:
+//  * the first one, where the actual decoding starts anyway;
+//  * one that starts in a long run of zeros, and so its speculative decoding
+//    is always at a symbol boundary, but always of the other component.
+//    It never synchronises;
+//  * one whose speculative decoding starts in the difference bits of
+//    a symbol, which are all ones, i.e. an invalid code. It fails;
+//  * and one that starts in a run of zeros, at a symbol boundary of the same
+//    component. It synchronises right away.
+SymbolStream genSymbols() {
+  SymbolStream s;
+
+  // The zeros up to the given bit position, with an odd (or even) number of
+  // symbols before it.
+  const auto putZerosAround = [&s](uint64_t pos, bool odd) {
+    if ((s.symbols.size() + (pos - s.size)) % 2 != odd)
+      s.put(diff8(0));
+    s.putZerosUntil(pos + 1024);
+  };
+
+  s.putRandomUntil(SegmentBits);
+  putZerosAround(SegmentBits, /*odd=*/true);
+
+  s.putRandomUntil(2 * SegmentBits);
+  s.putZerosUntil(2 * SegmentBits - 2);
+  s.put(diff8(0xFF));
+
+  s.putRandomUntil(3 * SegmentBits);
+  putZerosAround(3 * SegmentBits, /*odd=*/false);
+
+  s.putRandomUntil(NumSegments * SegmentBits);
+  s.putZerosUntil(NumSegments * SegmentBits);
+
+  return s;
+}
+
+void putSegment(std::vector<uint8_t>* out, uint8_t marker,
+                const std::vector<uint8_t>& payload) {
+  out->insert(out->end(), {0xFF, marker, uint8_t((payload.size() + 2) >> 8),
+                           uint8_t(payload.size() + 2)});
+  out->insert(out->end(), payload.begin(), payload.end());
+}
+
+// A two-component lossless JPEG, both components use the same table.
+std::vector<uint8_t> encode(const std::vector<Symbol>& symbols, int height) {
+  std::vector<uint8_t> out = {0xFF, 0xD8}; // SOI
+
+  std::vector<uint8_t> dht = {0x00, 1, 1, 1};
+  dht.resize(1 + 16);
+  dht.insert(dht.end(), {0, 8, 4});
+  putSegment(&out, 0xC4, dht);
+
+  putSegment(&out, 0xC3,
+             {Precision, uint8_t(height >> 8), uint8_t(height), 0, FrameWidth,
+              NumComponents, /*id=*/1, /*subsampling=*/0x11, /*Tq=*/0,
+              /*id=*/2, /*subsampling=*/0x11, /*Tq=*/0});
+  putSegment(&out, 0xDA,
+             {NumComponents, /*id=*/1, /*table=*/0x00, /*id=*/2,
+              /*table=*/0x00, /*predictor=*/1, 0, 0});
+
+  BitWriter bits(&out);
+  for (const Symbol& s : symbols)
+    bits.put(s.bits, s.len);
+
+  out.insert(out.end(), {0xFF, 0xD9}); // EOI
+  return out;
+}
+
+// Counts the loops, so we know whether the speculative decoding did happen.
+class CountingExecutor final : public Executor {
+  ThreadPoolExecutor pool{4};
+
+public:
+  std::atomic<int> numLoops{0};
+
+  int getConcurrency() const override { return pool.getConcurrency(); }
+
+  using Executor::parallelFor;
+  void parallelFor(int begin, int end, int grainSize, int maxThreads,
+                   const std::function<void(int, int)>& body) override {
+    numLoops++;
+    pool.parallelFor(begin, end, grainSize, maxThreads, body);
+  }
+};
+
+std::vector<uint16_t> decode(const std::vector<uint8_t>& stream, int height,
+                             Executor* executor, bool speculative) {
+  const iPoint2D dim(Width, height);
+  RawImage img = RawImage::create(dim, TYPE_USHORT16, 1);
+  img->setExecutor(executor);
+
+  Cr2Decompressor d(
+      ByteStream(DataBuffer(Buffer(stream.data(), stream.size()),
+                            Endianness::big)),
+      img);
+  d.setSpeculativeParallelDecode(speculative);
+  d.decode(Cr2Slicing(/*numSlices=*/3, /*sliceWidth=*/24,
+                      /*lastSliceWidth=*/16));
+
+  std::vector<uint16_t> pixels;
+  for (int row = 0; row < dim.y; row++) {
+    const auto* line =
+        reinterpret_cast<const uint16_t*>(img->getDataUncropped(0, row));
+    pixels.insert(pixels.end(), line, line + dim.x);
+  }
+  return pixels;
+}
+
+} // namespace
+
+TEST(Cr2DecompressorTest, SpeculativeDecodeTest) {
+  const SymbolStream s = genSymbols();
+  ASSERT_EQ(s.size, NumSegments * SegmentBits);
+  // The symbols past the last full row are never decoded.
+  const int height = s.symbols.size() / Width;
+  const std::vector<uint8_t> stream = encode(s.symbols, height);
+
+  CountingExecutor serialExecutor;
+  const std::vector<uint16_t> serial =
+      decode(stream, height, &serialExecutor, /*speculative=*/false);
+  ASSERT_EQ(serialExecutor.numLoops, 0);
+
+  CountingExecutor speculativeExecutor;
+  ASSERT_EQ(decode(stream, height, &speculativeExecutor, /*speculative=*/true),
+            serial);
+  ASSERT_EQ(speculativeExecutor.numLoops, 1);
+}
+
+TEST(Cr2DecompressorTest, SpeculativeDecodeOfCorruptStreamTest) {
+  SymbolStream s = genSymbols();
+  const int height = s.symbols.size() / Width;
+  // An invalid code, in the middle of the stream.
+  s.symbols[s.symbols.size() / 2] = {0b111, 3};
+  const std::vector<uint8_t> stream = encode(s.symbols, height);
+
+  CountingExecutor executor;
+  ASSERT_THROW(decode(stream, height, &executor, /*speculative=*/false),
+               RawDecoderException);
+  ASSERT_THROW(decode(stream, height, &executor, /*speculative=*/true),
+               RawDecoderException);
+}
+
+} // namespace rawspeed_test
@@ -0,0 +1,851 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decompressors/DecodeCheckpointIndex.h"  // for DecodeCheckpointIndex
+#include "common/Executor.h"                      // for Executor, getDefa...
+#include "common/Point.h"                         // for iPoint2D
+#include "common/RawImage.h"                      // for RawImage, RawImag...
+#include "common/RawspeedException.h"             // for RawspeedException
+#include "common/ThreadPoolExecutor.h"            // for ThreadPoolExecutor
+#include "decoders/RawDecoderException.h"         // for ThrowRDE
+#include "decompressors/HasselbladDecompressor.h" // for HasselbladDecompr...
+#include "decompressors/KodakDecompressor.h"      // for KodakDecompressor
+#include "decompressors/NikonDecompressor.h"      // for NikonDecompressor
+#include "decompressors/OlympusDecompressor.h"    // for OlympusDecompressor
+#include "decompressors/SamsungV1Decompressor.h"  // for SamsungV1Decompre...
+#include "decompressors/SonyArw1Decompressor.h"   // for SonyArw1Decompressor
+#include "io/BitPumpMSB.h"                        // for BitPumpMSB
+#include "io/BitPumpMSB32.h"                      // for BitPumpMSB32
+#include "io/Buffer.h"                            // for Buffer, DataBuffer
+#include "io/ByteStream.h"                        // for ByteStream
+#include "io/Endianness.h"                        // for Endianness, Endian...
+#include <algorithm>                              // for max, min, reverse
+#include <array>                                  // for array
+#include <atomic>                                 // for atomic
+#include <cstddef>                                // for size_t
+#include <cstdint>                                // for INT32_MAX, int32_t, ...
+#include <cstdlib>                                // for abs
+#include <functional>                             // for function
+#include <gtest/gtest.h>                          // for Test, Message, Tes...
+#include <random>                                 // for minstd_rand, unif...
+#include <tuple>                                  // for get, tuple
+#include <vector>                                 // for vector
+
+using rawspeed::BitPumpMSB;
+using rawspeed::BitPumpMSB32;
+using rawspeed::Buffer;
+using rawspeed::ByteStream;
+using rawspeed::DataBuffer;
+using rawspeed::DecodeCheckpointIndex;
+using rawspeed::Endianness;
+using rawspeed::Executor;
+using rawspeed::HasselbladDecompressor;
+using rawspeed::iPoint2D;
+using rawspeed::KodakDecompressor;
+using rawspeed::NikonDecompressor;
+using rawspeed::OlympusDecompressor;
+using rawspeed::RawImage;
+using rawspeed::RawspeedException;
+using rawspeed::SamsungV1Decompressor;
+using rawspeed::SonyArw1Decompressor;
+using rawspeed::ThreadPoolExecutor;
+using rawspeed::TYPE_USHORT16;
+
+namespace rawspeed_test {
+
+using Format = DecodeCheckpointIndex::Format;
+using Checkpoint = DecodeCheckpointIndex::Checkpoint;
+
+static DecodeCheckpointIndex genIndex(int lines, int count) {
+  DecodeCheckpointIndex index;
+  index.startRecording(Format::NIKON, /*variant=*/1, /*inputSize=*/4096, lines,
+                       /*lineInterval=*/16);
+  for (int i = 0; i < count; ++i) {
+    Checkpoint cp;
+    cp.bitPosition = 100 * i;
+    for (int j = 0; j < DecodeCheckpointIndex::MaxStateSize; ++j)
+      cp.state[j] = (j % 2 ? -1 : 1) * (1000 * i + j);
+    index.record(16 * i, cp);
+  }
+  return index;
+}
+
+TEST(DecodeCheckpointIndexTest, IsUsableForTest) {
+  const DecodeCheckpointIndex index = genIndex(40, 3);
+  ASSERT_TRUE(index.isUsableFor(Format::NIKON, 1, 4096, 40));
+  ASSERT_FALSE(index.isUsableFor(Format::OLYMPUS, 1, 4096, 40));
+  ASSERT_FALSE(index.isUsableFor(Format::NIKON, 0, 4096, 40));
+  ASSERT_FALSE(index.isUsableFor(Format::NIKON, 1, 4095, 40));
+  ASSERT_FALSE(index.isUsableFor(Format::NIKON, 1, 4096, 41));
+
+  // An incompletely recorded index is not usable.
+  ASSERT_FALSE(genIndex(40, 2).isUsableFor(Format::NIKON, 1, 4096, 40));
+
+  ASSERT_FALSE(DecodeCheckpointIndex().isUsableFor(Format::NONE, 0, 0, 0));
+}
+
+TEST(DecodeCheckpointIndexTest, SerializeRoundTripTest) {
+  const DecodeCheckpointIndex index = genIndex(40, 3);
+  const std::vector<uint8_t> data = index.serialize();
+
+  const DecodeCheckpointIndex copy =
+      DecodeCheckpointIndex::deserialize(Buffer(data.data(), data.size()));
+  ASSERT_TRUE(copy.isUsableFor(Format::NIKON, 1, 4096, 40));
+  ASSERT_EQ(copy.getLineInterval(), 16);
+  ASSERT_EQ(copy.size(), index.size());
+  for (size_t i = 0; i < index.size(); ++i) {
+    ASSERT_EQ(copy[i].bitPosition, index[i].bitPosition);
+    ASSERT_EQ(copy[i].state, index[i].state);
+  }
+
+  ASSERT_EQ(copy.serialize(), data);
+}
+
+TEST(DecodeCheckpointIndexTest, DeserializeRejectsBadDataTest) {
+  const std::vector<uint8_t> data = genIndex(40, 3).serialize();
+
+  const auto deserialize = [](const std::vector<uint8_t>& d) {
+    return DecodeCheckpointIndex::deserialize(Buffer(d.data(), d.size()));
+  };
+
+  // Truncated.
+  for (size_t size = 1; size < data.size(); ++size) {
+    const std::vector<uint8_t> truncated(data.begin(), data.begin() + size);
+    ASSERT_THROW(deserialize(truncated), RawspeedException);
+  }
+
+  // Trailing data.
+  std::vector<uint8_t> longer = data;
+  longer.push_back(0);
+  ASSERT_THROW(deserialize(longer), RawspeedException);
+
+  // Bad magic, version, format.
+  for (int byte : {0, 4, 8}) {
+    std::vector<uint8_t> bad = data;
+    bad[byte] ^= 0x80;
+    ASSERT_THROW(deserialize(bad), RawspeedException);
+  }
+
+  // An incompletely recorded index.
+  ASSERT_THROW(deserialize(genIndex(40, 2).serialize()), RawspeedException);
+
+  // Line count or interval that are not sane, which must not overflow
+  // while computing the expected checkpoint count.
+  for (int byte : {24, 28}) {
+    for (uint32_t value : {0U, 0x10001U, 0x7FFFFFFFU, 0x80000000U, ~0U}) {
+      std::vector<uint8_t> bad = data;
+      for (int i = 0; i < 4; ++i)
+        bad[byte + i] = static_cast<uint8_t>(value >> (8 * i));
+      ASSERT_THROW(deserialize(bad), RawspeedException);
+    }
+  }
+}
+
+template <typename Pump> static void checkResumePump() {
+  std::vector<uint8_t> data(64);
+  for (size_t i = 0; i < data.size(); ++i)
+    data[i] = 37 * i + 11;
+  const ByteStream bs(
+      DataBuffer(Buffer(data.data(), data.size()), Endianness::little));
+
+  // Read the stream in differently-sized pieces, and check that it can be
+  // resumed at the start of each one.
+  Pump pump(bs);
+  for (uint32_t len = 1; pump.getBitPosition() + 32 <= 8 * data.size();
+       len = len % 17 + 1) {
+    const uint64_t bitPosition = pump.getBitPosition();
+    const uint32_t expected = pump.peekBits(16);
+
+    Pump resumed = DecodeCheckpointIndex::resumePump<Pump>(bs, bitPosition);
+    ASSERT_EQ(resumed.peekBits(16), expected) << "bitPosition: " << bitPosition;
+
+    pump.getBits(len);
+  }
+}
+
+TEST(DecodeCheckpointIndexTest, ResumeBitPumpMSBTest) {
+  checkResumePump<BitPumpMSB>();
+}
+
+TEST(DecodeCheckpointIndexTest, ResumeBitPumpMSB32Test) {
+  checkResumePump<BitPumpMSB32>();
+}
+
+TEST(DecodeCheckpointIndexTest, DecodeInParallelCoversAllLinesTest) {
+  const int lines = 40;
+  const DecodeCheckpointIndex index = genIndex(lines, 3);
+
+  std::vector<int> decoded(lines);
+  index.decodeInParallel(
+      &rawspeed::getDefaultExecutor(),
+      [&index, &decoded](const Checkpoint& cp, int lineBegin, int lineEnd) {
+        const int i = lineBegin / index.getLineInterval();
+        EXPECT_EQ(cp.bitPosition, index[i].bitPosition);
+        for (int line = lineBegin; line < lineEnd; ++line)
+          decoded[line]++;
+        // Where the next checkpoint is, see genIndex().
+        return uint64_t(100) * (i + 1);
+      });
+
+  for (int line = 0; line < lines; ++line)
+    ASSERT_EQ(decoded[line], 1) << "line: " << line;
+}
+
+TEST(DecodeCheckpointIndexTest, DecodeInParallelThrowsTest) {
+  const DecodeCheckpointIndex index = genIndex(40, 3);
+
+  const auto decodeLines = [](const Checkpoint& cp, int lineBegin,
+                              int lineEnd) {
+    if (lineBegin != 0)
+      ThrowRDE("Bad lines %i..%i", lineBegin, lineEnd);
+    return cp.bitPosition + 100;
+  };
+  ASSERT_THROW(
+      index.decodeInParallel(&rawspeed::getDefaultExecutor(), decodeLines),
+      RawspeedException);
+}
+
+TEST(DecodeCheckpointIndexTest, DecodeInParallelChecksTheEndTest) {
+  const DecodeCheckpointIndex index = genIndex(40, 3);
+
+  // Each of the lines but the last ones must end at the next checkpoint.
+  for (int wrong = 0; wrong < 3; ++wrong) {
+    const auto decodeLines = [wrong](const Checkpoint& cp, int lineBegin,
+                                     int /*lineEnd*/) {
+      return cp.bitPosition + (lineBegin / 16 == wrong ? 99 : 100);
+    };
+    if (wrong == 2) {
+      ASSERT_NO_THROW(index.decodeInParallel(&rawspeed::getDefaultExecutor(),
+                                             decodeLines));
+    } else {
+      ASSERT_THROW(index.decodeInParallel(&rawspeed::getDefaultExecutor(),
+                                          decodeLines),
+                   RawspeedException);
+    }
+  }
+}
+
+namespace {
+
+// Counts the loops, so we know whether a decode was actually parallelized.
+class CountingExecutor final : public Executor {
+  ThreadPoolExecutor pool{4};
+
+public:
+  std::atomic<int> numLoops{0};
+
+  int getConcurrency() const override { return pool.getConcurrency(); }
+
+  using Executor::parallelFor;
+  void parallelFor(int begin, int end, int grainSize, int maxThreads,
+                   const std::function<void(int, int)>& body) override {
+    numLoops++;
+    pool.parallelFor(begin, end, grainSize, maxThreads, body);
+  }
+};
+
+using Decode = std::function<void(const RawImage& img,
+                                  DecodeCheckpointIndex* index)>;
+
+// Decodes into a new image, returns its pixels.
+std::vector<uint16_t> decodeImage(const iPoint2D& dim, Executor* executor,
+                                  const Decode& decode,
+                                  DecodeCheckpointIndex* index) {
+  RawImage img = RawImage::create(dim, TYPE_USHORT16, 1);
+  img->setExecutor(executor);
+  decode(img, index);
+
+  std::vector<uint16_t> pixels;
+  for (int row = 0; row < dim.y; ++row) {
+    const auto* line =
+        reinterpret_cast<const uint16_t*>(img->getDataUncropped(0, row));
+    pixels.insert(pixels.end(), line, line + dim.x);
+  }
+  return pixels;
+}
+
+// The decode that records the index, and the one that resumes from each of
+// its checkpoints in parallel, must both be identical to the plain one.
+void checkResumedDecodeIsIdentical(const iPoint2D& dim, const Decode& decode,
+                                   const std::vector<uint16_t>* expected) {
+  CountingExecutor executor;
+
+  const std::vector<uint16_t> serial =
+      decodeImage(dim, &executor, decode, nullptr);
+  if (expected) {
+    ASSERT_EQ(serial, *expected);
+  }
+
+  DecodeCheckpointIndex index;
+  ASSERT_EQ(decodeImage(dim, &executor, decode, &index), serial);
+  ASSERT_GT(index.size(), 1U);
+
+  // As it would come from a sidecar.
+  const std::vector<uint8_t> data = index.serialize();
+  DecodeCheckpointIndex loaded =
+      DecodeCheckpointIndex::deserialize(Buffer(data.data(), data.size()));
+
+  const int numLoops = executor.numLoops;
+  ASSERT_EQ(decodeImage(dim, &executor, decode, &loaded), serial);
+  // It was used, not re-recorded.
+  ASSERT_GT(executor.numLoops, numLoops);
+  ASSERT_EQ(loaded.serialize(), data);
+}
+
+// An index is only keyed by the size of the input, so when it was recorded
+// for another input of the same size, the decoding must notice that.
+void checkStaleIndexIsRejected(const iPoint2D& dim, const Decode& record,
+                               const Decode& decode) {
+  CountingExecutor executor;
+
+  DecodeCheckpointIndex index;
+  decodeImage(dim, &executor, record, &index);
+  ASSERT_GT(index.size(), 1U);
+
+  ASSERT_THROW(decodeImage(dim, &executor, decode, &index), RawspeedException);
+}
+
+// The state of a checkpoint is untrusted input too. Each of the given values
+// of the given predictor, in the second checkpoint, must be rejected.
+void checkBadPredictorIsRejected(const iPoint2D& dim, const Decode& decode,
+                                 int predictor,
+                                 const std::vector<int32_t>& values) {
+  CountingExecutor executor;
+
+  DecodeCheckpointIndex index;
+  decodeImage(dim, &executor, decode, &index);
+  ASSERT_GT(index.size(), 1U);
+  const std::vector<uint8_t> data = index.serialize();
+
+  for (int32_t value : values) {
+    // See DecodeCheckpointIndex::serialize(): the header, the first
+    // checkpoint, then the bit position of the second one.
+    std::vector<uint8_t> bad = data;
+    for (int i = 0; i < 4; ++i)
+      bad[36 + 28 + 8 + 4 * predictor + i] = uint32_t(value) >> (8 * i);
+    DecodeCheckpointIndex loaded =
+        DecodeCheckpointIndex::deserialize(Buffer(bad.data(), bad.size()));
+
+    ASSERT_THROW(decodeImage(dim, &executor, decode, &loaded),
+                 RawspeedException)
+        << "value: " << value;
+  }
+}
+
+std::vector<uint8_t>
+genRandomBytes(size_t size, unsigned seed = std::minstd_rand::default_seed) {
+  std::minstd_rand rng(seed); // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<unsigned> bytes(0, 0xFF);
+
+  std::vector<uint8_t> data(size);
+  for (uint8_t& b : data)
+    b = bytes(rng);
+  return data;
+}
+
+ByteStream getStream(const std::vector<uint8_t>& data,
+                     Endianness endianness = Endianness::little) {
+  return ByteStream(DataBuffer(Buffer(data.data(), data.size()), endianness));
+}
+
+// Writes the bits MSB-first.
+class BitWriter final {
+  std::vector<uint8_t> data;
+  uint32_t cache = 0;
+  int fill = 0;
+
+public:
+  void put(uint32_t bits, int count) {
+    for (int i = count - 1; i >= 0; --i) {
+      cache = (cache << 1) | ((bits >> i) & 1);
+      if (++fill < 8)
+        continue;
+      data.emplace_back(cache);
+      cache = 0;
+      fill = 0;
+    }
+  }
+
+  // The difference in its JPEG-like form, the length is encoded separately.
+  void putDiff(int diff, int len) {
+    if (len != 0)
+      put(diff > 0 ? diff : diff + (1 << len) - 1, len);
+  }
+
+  // For the 32-bit pumps, each 4 bytes are stored as a little-endian word.
+  std::vector<uint8_t> finish(bool words = false) {
+    while (fill != 0 || (words && data.size() % 4 != 0))
+      put(0, 1);
+    if (words) {
+      for (auto word = data.begin(); word != data.end(); word += 4)
+        std::reverse(word, word + 4);
+    }
+    // Some slack for the pumps that refill ahead.
+    data.resize(data.size() + 8);
+    return data;
+  }
+};
+
+int getDiffLength(int diff) {
+  int len = 0;
+  while ((std::abs(diff) >> len) != 0)
+    len++;
+  return len;
+}
+
+// Random 12-bit values, the range the decompressors below allow.
+std::vector<int> genValues(const iPoint2D& dim) {
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<int> values(0, 4095);
+
+  std::vector<int> out(dim.area());
+  for (int& v : out)
+    v = values(rng);
+  return out;
+}
+
+std::vector<uint16_t> toPixels(const std::vector<int>& values) {
+  return std::vector<uint16_t>(values.begin(), values.end());
+}
+
+// The trees of the NikonDecompressor: the number of codes of each length,
+// then the difference length of each code. Those above 0xF are shifted.
+const std::array<std::array<std::array<uint8_t, 16>, 2>, 6> nikonTrees = {{
+    {{{0, 1, 5, 1, 1, 1, 1, 1, 1, 2, 0, 0, 0, 0, 0, 0},
+      {5, 4, 3, 6, 2, 7, 1, 0, 8, 9, 11, 10, 12}}},
+    {{{0, 1, 5, 1, 1, 1, 1, 1, 1, 2, 0, 0, 0, 0, 0, 0},
+      {0x39, 0x5a, 0x38, 0x27, 0x16, 5, 4, 3, 2, 1, 0, 11, 12, 12}}},
+    {{{0, 1, 4, 2, 3, 1, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0},
+      {5, 4, 6, 3, 7, 2, 8, 1, 9, 0, 10, 11, 12}}},
+    {{{0, 1, 4, 3, 1, 1, 1, 1, 1, 2, 0, 0, 0, 0, 0, 0},
+      {5, 6, 4, 7, 8, 3, 9, 2, 1, 0, 10, 11, 12, 13, 14}}},
+    {{{0, 1, 5, 1, 1, 1, 1, 1, 1, 1, 2, 0, 0, 0, 0, 0},
+      {8, 0x5c, 0x4b, 0x3a, 0x29, 7, 6, 5, 4, 3, 2, 1, 0, 13, 14}}},
+    {{{0, 1, 4, 2, 2, 3, 1, 2, 0, 0, 0, 0, 0, 0, 0, 0},
+      {7, 6, 8, 5, 9, 4, 10, 3, 11, 12, 2, 0, 1, 13, 14}}},
+}};
+
+// {code, code length} of each (not shifted) difference length of the tree.
+std::array<std::array<int, 2>, 16> getNikonCodes(int huffSelect) {
+  const auto& tree = nikonTrees[huffSelect];
+  std::array<std::array<int, 2>, 16> codes = {{}};
+  int code = 0;
+  size_t i = 0;
+  for (int len = 1; len <= 16; ++len) {
+    for (int n = 0; n < tree[0][len - 1]; ++n, ++code, ++i) {
+      const int diffLen = tree[1][i];
+      if (diffLen < 16 && codes[diffLen][1] == 0)
+        codes[diffLen] = {{code, len}};
+    }
+    code <<= 1;
+  }
+  return codes;
+}
+
+// Random values that each tree can encode, i.e. small differences, since
+// the trees after the split only have the longer ones shifted. All the
+// predictors start at 2048, and the values stay within 12 bits.
+std::vector<uint8_t> genNikonData(const iPoint2D& dim, int huffSelect,
+                                  int split, unsigned seed) {
+  std::minstd_rand rng(seed); // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<int> diffs(-31, 31);
+
+  const std::array<std::array<int, 2>, 16> codesBeforeSplit =
+      getNikonCodes(huffSelect);
+  const std::array<std::array<int, 2>, 16> codesAfterSplit =
+      getNikonCodes(split ? huffSelect + 1 : huffSelect);
+
+  BitWriter bits;
+  std::array<std::array<int, 2>, 2> up = {{{2048, 2048}, {2048, 2048}}};
+  for (int row = 0; row < dim.y; ++row) {
+    const auto& codes =
+        split && row >= split ? codesAfterSplit : codesBeforeSplit;
+    std::array<int, 2> pred = up[row & 1];
+    for (int col = 0; col < dim.x; ++col) {
+      int diff = diffs(rng);
+      if (pred[col & 1] + diff < 0 || pred[col & 1] + diff > 4095)
+        diff = -diff;
+      pred[col & 1] += diff;
+      if (col < 2)
+        up[row & 1][col] = pred[col & 1];
+
+      const int len = getDiffLength(diff);
+      bits.put(codes[len][0], codes[len][1]);
+      bits.putDiff(diff, len);
+    }
+  }
+  return bits.finish();
+}
+
+} // namespace
+
+class NikonResumeTest
+    : public ::testing::TestWithParam<std::tuple<bool, bool, bool>> {};
+
+TEST_P(NikonResumeTest, ResumedDecodeIsIdenticalTest) {
+  const bool fourteenBits = std::get<0>(GetParam());
+  const bool withSplit = std::get<1>(GetParam());
+  const bool uncorrectedRawValues = std::get<2>(GetParam());
+
+  const iPoint2D dim(32, 200);
+  const uint32_t bitsPS = fourteenBits ? 14 : 12;
+
+  std::vector<uint8_t> meta;
+  const auto put16 = [&meta](uint16_t v) {
+    meta.emplace_back(v >> 8);
+    meta.emplace_back(v & 0xFF);
+  };
+  if (withSplit) {
+    // v0 = 68, v1 = 32: the curve has 3 points, 2 equal segments, and the
+    // Huffman tree changes at the split row.
+    meta = {68, 32};
+    for (int i = 0; i < 4; ++i)
+      put16(2048);
+    put16(3); // csize
+    put16(0);
+    put16(1 << (bitsPS - 2));
+    put16((1 << bitsPS) - 1);
+    meta.resize(562);
+    put16(100); // split
+  } else {
+    // v0 = 70: no curve.
+    meta = {70, 0};
+    for (int i = 0; i < 4; ++i)
+      put16(2048);
+    put16(0); // csize
+  }
+
+  // v0 = 68 is lossy, v0 = 70 is lossless.
+  const int huffSelect = (withSplit ? 0 : 2) + (fourteenBits ? 3 : 0);
+  const std::vector<uint8_t> data =
+      genNikonData(dim, huffSelect, withSplit ? 100 : 0, /*seed=*/1);
+
+  const auto decode = [&](const RawImage& img, DecodeCheckpointIndex* index) {
+    NikonDecompressor n(img, getStream(meta, Endianness::big), bitsPS);
+    n.setCheckpointIndex(index);
+    n.decompress(getStream(data), uncorrectedRawValues);
+  };
+  checkResumedDecodeIsIdentical(dim, decode, nullptr);
+  for (int predictor = 0; predictor < 4; ++predictor)
+    checkBadPredictorIsRejected(dim, decode, predictor,
+                                {-1, 1 << 16, INT32_MAX});
+}
+
+TEST(DecodeCheckpointIndexTest, NikonStaleIndexIsRejectedTest) {
+  const iPoint2D dim(32, 200);
+
+  std::vector<uint8_t> meta = {70, 0};
+  for (int i = 0; i < 4; ++i)
+    meta.insert(meta.end(), {2048 >> 8, 0});
+  meta.insert(meta.end(), {0, 0}); // csize
+
+  // Another input of the same size.
+  std::vector<uint8_t> data = genNikonData(dim, 2, 0, /*seed=*/1);
+  std::vector<uint8_t> other = genNikonData(dim, 2, 0, /*seed=*/2);
+  data.resize(std::max(data.size(), other.size()));
+  other.resize(data.size());
+
+  const auto decode = [&meta](const std::vector<uint8_t>& input) {
+    return [&meta, &input](const RawImage& img, DecodeCheckpointIndex* index) {
+      NikonDecompressor n(img, getStream(meta, Endianness::big), 12);
+      n.setCheckpointIndex(index);
+      n.decompress(getStream(input), /*uncorrectedRawValues=*/true);
+    };
+  };
+  checkStaleIndexIsRejected(dim, decode(data), decode(other));
+}
+
+INSTANTIATE_TEST_CASE_P(NikonResumeTest, NikonResumeTest,
+                        ::testing::Combine(::testing::Bool(),
+                                           ::testing::Bool(),
+                                           ::testing::Bool()));
+
+TEST(DecodeCheckpointIndexTest, OlympusResumedDecodeIsIdenticalTest) {
+  const iPoint2D dim(32, 200);
+  const std::vector<uint8_t> data = genRandomBytes(7 + 4 * dim.area());
+
+  checkResumedDecodeIsIdentical(
+      dim,
+      [&data](const RawImage& img, DecodeCheckpointIndex* index) {
+        OlympusDecompressor o(img);
+        o.setCheckpointIndex(index);
+        o.decompress(getStream(data));
+      },
+      nullptr);
+}
+
+TEST(DecodeCheckpointIndexTest, OlympusStaleIndexIsRejectedTest) {
+  const iPoint2D dim(32, 200);
+
+  // Another input of the same size.
+  const std::vector<uint8_t> data = genRandomBytes(7 + 4 * dim.area());
+  const std::vector<uint8_t> other = genRandomBytes(data.size(), /*seed=*/2);
+
+  const auto decode = [](const std::vector<uint8_t>& input) {
+    return [&input](const RawImage& img, DecodeCheckpointIndex* index) {
+      OlympusDecompressor o(img);
+      o.setCheckpointIndex(index);
+      o.decompress(getStream(input));
+    };
+  };
+  checkStaleIndexIsRejected(dim, decode(data), decode(other));
+}
+
+TEST(DecodeCheckpointIndexTest, SonyArw1ResumedDecodeIsIdenticalTest) {
+  // The lines are the columns here.
+  const iPoint2D dim(200, 8);
+  const std::vector<int> values = genValues(dim);
+
+  // The columns are stored last to first, and each one has the even rows
+  // first, then the odd ones.
+  BitWriter bits;
+  int pred = 0;
+  for (int col = dim.x - 1; col >= 0; --col) {
+    for (int i = 0; i < dim.y; ++i) {
+      const int row = i < dim.y / 2 ? 2 * i : 2 * (i - dim.y / 2) + 1;
+      const int value = values[row * dim.x + col];
+      const int diff = value - pred;
+      pred = value;
+
+      const int len = getDiffLength(diff);
+      if (len == 0) {
+        bits.put(0b011, 3);
+      } else if (len < 3) {
+        bits.put(4 - len, 2);
+      } else if (len == 3) {
+        bits.put(0b010, 3);
+      } else {
+        bits.put(0, 2 + len - 4);
+        bits.put(1, 1);
+      }
+      bits.putDiff(diff, len);
+    }
+  }
+  const std::vector<uint8_t> data = bits.finish();
+
+  const auto decode = [&data](const RawImage& img,
+                              DecodeCheckpointIndex* index) {
+    SonyArw1Decompressor a(img);
+    a.setCheckpointIndex(index);
+    a.decompress(getStream(data));
+  };
+  const std::vector<uint16_t> expected = toPixels(values);
+  checkResumedDecodeIsIdentical(dim, decode, &expected);
+  checkBadPredictorIsRejected(dim, decode, 0, {-1, 1 << 12, INT32_MAX});
+}
+
+TEST(DecodeCheckpointIndexTest, SamsungV1ResumedDecodeIsIdenticalTest) {
+  const iPoint2D dim(64, 200);
+  const std::vector<int> values = genValues(dim);
+
+  // {code length, difference length}, the codes are assigned in this order.
+  static const std::array<std::array<int, 2>, 14> tab = {
+      {{3, 4},
+       {3, 7},
+       {2, 6},
+       {2, 5},
+       {4, 3},
+       {6, 0},
+       {7, 9},
+       {8, 10},
+       {9, 11},
+       {10, 12},
+       {10, 13},
+       {5, 1},
+       {4, 8},
+       {4, 2}}};
+  std::array<std::array<int, 2>, 14> codes; // by difference length
+  int next = 0;
+  for (const auto& t : tab) {
+    codes[t[1]] = {{next >> (10 - t[0]), t[0]}};
+    next += 1024 >> t[0];
+  }
+
+  // The predictors are the first two values of the previous row of the same
+  // parity.
+  BitWriter bits;
+  std::array<std::array<int, 2>, 2> up = {{}};
+  for (int row = 0; row < dim.y; ++row) {
+    std::array<int, 2> pred = up[row & 1];
+    for (int col = 0; col < dim.x; ++col) {
+      const int value = values[row * dim.x + col];
+      const int diff = value - pred[col & 1];
+      pred[col & 1] = value;
+      if (col < 2)
+        up[row & 1][col] = value;
+
+      const int len = getDiffLength(diff);
+      bits.put(codes[len][0], codes[len][1]);
+      bits.putDiff(diff, len);
+    }
+  }
+  const std::vector<uint8_t> data = bits.finish();
+
+  const auto decode = [&data](const RawImage& img,
+                              DecodeCheckpointIndex* index) {
+    const ByteStream bs = getStream(data);
+    SamsungV1Decompressor s(img, &bs, 12);
+    s.setCheckpointIndex(index);
+    s.decompress();
+  };
+  const std::vector<uint16_t> expected = toPixels(values);
+  checkResumedDecodeIsIdentical(dim, decode, &expected);
+  for (int predictor = 0; predictor < 4; ++predictor)
+    checkBadPredictorIsRejected(dim, decode, predictor,
+                                {-1, 1 << 12, INT32_MAX});
+}
+
+class KodakResumeTest : public ::testing::TestWithParam<bool> {};
+
+TEST_P(KodakResumeTest, ResumedDecodeIsIdenticalTest) {
+  const bool uncorrectedRawValues = GetParam();
+
+  // Two segments per row, 256 and 44 pixels, the latter with the odd start.
+  const iPoint2D dim(300, 200);
+
+  // Each segment has the lengths first, one byte per two pixels, then the
+  // differences, consumed LSB-first from (for 4 mod 8 pixels, one 16-bit
+  // word, then) 32-bit words that are read as needed. The differences are
+  // small and positive, so the values stay within 12 bits.
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<int> lens(0, 4);
+  std::uniform_int_distribution<uint32_t> bits(0, 15);
+  std::vector<uint8_t> data;
+  std::vector<uint16_t> expected;
+  for (int row = 0; row < dim.y; ++row) {
+    for (int col = 0; col < dim.x; col += 256) {
+      const int len = std::min(256, dim.x - col);
+
+      std::vector<int> segmentLens;
+      for (int i = 0; i < len; i += 2) {
+        segmentLens.emplace_back(lens(rng));
+        segmentLens.emplace_back(lens(rng));
+        data.emplace_back(segmentLens[i] | (segmentLens[i + 1] << 4));
+      }
+
+      // The bits in the order they are consumed, and how many are read.
+      std::vector<bool> stream;
+      int available = (len & 7) == 4 ? 16 : 0;
+      std::array<int, 2> pred = {{}};
+      for (int i = 0; i < len; ++i) {
+        const int l = segmentLens[i];
+        if (available - int(stream.size()) < l)
+          available += 32;
+        if (l != 0) {
+          // The top bit is set, so it is positive.
+          const uint32_t diff = (1U << (l - 1)) | (bits(rng) >> (5 - l));
+          pred[i & 1] += diff;
+          for (int b = 0; b < l; ++b)
+            stream.emplace_back((diff >> b) & 1);
+        }
+        expected.emplace_back(pred[i & 1]);
+      }
+      stream.resize(available);
+
+      for (size_t pos = 0; pos < stream.size();) {
+        const int size = pos == 0 && (len & 7) == 4 ? 16 : 32;
+        uint32_t word = 0;
+        for (int b = 0; b < size; ++b, ++pos)
+          word |= uint32_t(stream[pos]) << b;
+        // Big-endian 16-bit halves, the low one first.
+        for (int half = 0; half < size; half += 16) {
+          data.emplace_back(word >> (half + 8));
+          data.emplace_back(word >> half);
+        }
+      }
+    }
+  }
+
+  // With dithering, which has its own state.
+  std::vector<uint16_t> curve(4096);
+  for (size_t i = 0; i < curve.size(); ++i)
+    curve[i] = 16 * i;
+
+  checkResumedDecodeIsIdentical(
+      dim,
+      [&](const RawImage& img, DecodeCheckpointIndex* index) {
+        if (!uncorrectedRawValues)
+          img->setTable(curve, /*dither=*/true);
+        KodakDecompressor k(img, getStream(data), 12, uncorrectedRawValues);
+        k.setCheckpointIndex(index);
+        k.decompress();
+      },
+      uncorrectedRawValues ? &expected : nullptr);
+}
+
+INSTANTIATE_TEST_CASE_P(KodakResumeTest, KodakResumeTest, ::testing::Bool());
+
+TEST(DecodeCheckpointIndexTest, HasselbladResumedDecodeIsIdenticalTest) {
+  const iPoint2D dim(32, 200);
+
+  std::vector<uint8_t> data = {0xFF, 0xD8}; // SOI
+  const auto putSegment = [&data](uint8_t marker,
+                                  const std::vector<uint8_t>& payload) {
+    data.insert(data.end(), {0xFF, marker, 0, uint8_t(payload.size() + 2)});
+    data.insert(data.end(), payload.begin(), payload.end());
+  };
+
+  // The difference lengths 0..8, all with a 4-bit code.
+  std::vector<uint8_t> dht = {/*class, id*/ 0x00, 0, 0, 0, 9};
+  dht.resize(1 + 16);
+  for (uint8_t len = 0; len <= 8; ++len)
+    dht.emplace_back(len);
+  putSegment(0xC4, dht);
+
+  putSegment(0xC3, {/*precision*/ 12, 0, uint8_t(dim.y), 0, uint8_t(dim.x),
+                    /*cps*/ 1, /*id*/ 1, /*subsampling*/ 0x11, /*Tq*/ 0});
+  putSegment(0xDA,
+             {/*cps*/ 1, /*id*/ 1, /*table*/ 0x00, /*predictor*/ 1, 0, 0});
+
+  // Then the scan, the pixels are close to the initial predictor, so all the
+  // differences fit in 8 bits. Each two pixels have their lengths first,
+  // then their differences.
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<int> values(0x8000 - 128, 0x8000 + 127);
+  std::vector<uint16_t> expected;
+  BitWriter bits;
+  for (int row = 0; row < dim.y; ++row) {
+    for (int col = 0; col < dim.x; col += 2) {
+      std::array<int, 2> diffs;
+      for (int& diff : diffs) {
+        expected.emplace_back(values(rng));
+        diff = expected.back() - (col == 0 ? 0x8000 : expected.end()[-3]);
+      }
+      for (int diff : diffs)
+        bits.put(getDiffLength(diff), 4);
+      for (int diff : diffs)
+        bits.putDiff(diff, getDiffLength(diff));
+    }
+  }
+  const std::vector<uint8_t> scan = bits.finish(/*words=*/true);
+  data.insert(data.end(), scan.begin(), scan.end());
+  data.insert(data.end(), {0xFF, 0xD9});
+
+  checkResumedDecodeIsIdentical(
+      dim,
+      [&data](const RawImage& img, DecodeCheckpointIndex* index) {
+        HasselbladDecompressor h(getStream(data, Endianness::big), img);
+        h.setCheckpointIndex(index);
+        h.decode(0);
+      },
+      &expected);
+}
+
+} // namespace rawspeed_test
@@ -0,0 +1,126 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decompressors/HuffmanTableCache.h" // for HuffmanTableCache
+#include "decompressors/HuffmanTable.h"      // for HuffmanTable
+#include "io/Buffer.h"                       // for Buffer
+#include <algorithm>                         // for min
+#include <array>                             // for array
+#include <cstddef>                           // for size_t
+#include <cstdint>                           // for uint8_t
+#include <gtest/gtest.h>                     // for Test, Message, TestPar...
+#include <memory>                            // for shared_ptr
+
+using rawspeed::Buffer;
+using rawspeed::HuffmanTable;
+using rawspeed::HuffmanTableCache;
+
+namespace rawspeed_test {
+
+static HuffmanTable genHT(const std::array<uint8_t, 16>& nCodesPerLength,
+                          const std::array<uint8_t, 3>& codeValues) {
+  HuffmanTable ht;
+  const auto nCodes = ht.setNCodesPerLength(
+      Buffer(nCodesPerLength.data(), nCodesPerLength.size()));
+  ht.setCodeValues(Buffer(codeValues.data(), nCodes));
+  return ht;
+}
+
+TEST(HuffmanTableCacheTest, SameTableIsSharedTest) {
+  HuffmanTableCache cache;
+
+  const auto a = cache.get(genHT({0, 3}, {1, 2, 3}), true, false);
+  const auto b = cache.get(genHT({0, 3}, {1, 2, 3}), true, false);
+  ASSERT_EQ(a, b);
+  ASSERT_EQ(cache.size(), 1);
+}
+
+TEST(HuffmanTableCacheTest, DifferentTablesTest) {
+  HuffmanTableCache cache;
+
+  const auto a = cache.get(genHT({0, 3}, {1, 2, 3}), true, false);
+  // Different code values.
+  const auto b = cache.get(genHT({0, 3}, {1, 2, 4}), true, false);
+  // Different code lengths.
+  const auto c = cache.get(genHT({1, 1, 1}, {1, 2, 3}), true, false);
+  // Different setup parameters.
+  const auto d = cache.get(genHT({0, 3}, {1, 2, 3}), false, false);
+  const auto e = cache.get(genHT({0, 3}, {1, 2, 3}), true, true);
+
+  ASSERT_NE(a, b);
+  ASSERT_NE(a, c);
+  ASSERT_NE(a, d);
+  ASSERT_NE(a, e);
+  ASSERT_NE(d, e);
+  ASSERT_EQ(cache.size(), 5);
+}
+
+TEST(HuffmanTableCacheTest, TableOutlivesCacheTest) {
+  std::shared_ptr<const HuffmanTable> ht;
+  {
+    HuffmanTableCache cache;
+    ht = cache.get(genHT({0, 3}, {1, 2, 3}), true, false);
+  }
+  ASSERT_EQ(*ht, genHT({0, 3}, {1, 2, 3}));
+}
+
+TEST(HuffmanTableCacheTest, KeepsAtMostMaxEntriesTest) {
+  HuffmanTableCache cache(4);
+
+  for (uint8_t v = 0; v < 16; v++) {
+    cache.get(genHT({0, 3}, {1, 2, v}), true, false);
+    ASSERT_EQ(cache.size(), std::min<size_t>(v + 1, 4));
+  }
+
+  // The default limit is enforced too.
+  HuffmanTableCache defaultCache;
+  for (uint8_t v = 0; v < 16; v++)
+    defaultCache.get(genHT({0, 3}, {1, 2, v}), true, false);
+  ASSERT_EQ(defaultCache.size(), HuffmanTableCache::DefaultMaxEntries);
+}
+
+TEST(HuffmanTableCacheTest, EvictsLeastRecentlyUsedTest) {
+  HuffmanTableCache cache(2);
+
+  const auto a = cache.get(genHT({0, 3}, {1, 2, 3}), true, false);
+  const auto b = cache.get(genHT({0, 3}, {1, 2, 4}), true, false);
+  // Now b is older than a.
+  ASSERT_EQ(cache.get(genHT({0, 3}, {1, 2, 3}), true, false), a);
+  // Evicts b.
+  const auto c = cache.get(genHT({0, 3}, {1, 2, 5}), true, false);
+  ASSERT_EQ(cache.size(), 2);
+
+  ASSERT_EQ(cache.get(genHT({0, 3}, {1, 2, 3}), true, false), a);
+  ASSERT_EQ(cache.get(genHT({0, 3}, {1, 2, 5}), true, false), c);
+  // b was evicted, so it is set up anew, but it still equals the old one.
+  const auto b2 = cache.get(genHT({0, 3}, {1, 2, 4}), true, false);
+  ASSERT_NE(b2, b);
+  ASSERT_EQ(*b2, *b);
+}
+
+TEST(HuffmanTableCacheTest, CorruptTableIsNotStoredTest) {
+  HuffmanTableCache cache;
+
+  // Difference length 17 is not valid.
+  ASSERT_ANY_THROW(cache.get(genHT({0, 3}, {1, 2, 17}), true, false));
+  ASSERT_EQ(cache.size(), 0);
+}
+
+} // namespace rawspeed_test
@@ -0,0 +1,240 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decompressors/LJpegDecompressor.h" // for LJpegDecompressor
+#include "common/Point.h"                    // for iPoint2D
+#include "common/RawImage.h"                 // for RawImage, RawImageData
+#include "common/ThreadPoolExecutor.h"       // for ThreadPoolExecutor
+#include "decoders/RawDecoderException.h"    // for RawDecoderException
+#include "io/Buffer.h"                       // for Buffer, DataBuffer
+#include "io/ByteStream.h"                   // for ByteStream
+#include "io/Endianness.h"                   // for Endianness, Endianness:...
+#include <algorithm>                         // for search
+#include <cstdint>                           // for uint8_t, uint16_t, uint...
+#include <cstdlib>                           // for abs
+#include <gtest/gtest.h>                     // for Message, TestPartResult
+#include <random>                            // for minstd_rand, uniform_in...
+#include <vector>                            // for vector
+
+using rawspeed::Buffer;
+using rawspeed::ByteStream;
+using rawspeed::DataBuffer;
+using rawspeed::Endianness;
+using rawspeed::iPoint2D;
+using rawspeed::LJpegDecompressor;
+using rawspeed::RawDecoderException;
+using rawspeed::RawImage;
+using rawspeed::ThreadPoolExecutor;
+using rawspeed::TYPE_USHORT16;
+
+namespace rawspeed_test {
+
+namespace {
+
+constexpr int Width = 4;
+constexpr int Height = 6;
+constexpr int Precision = 12;
+
+// Writes the bits MSB-first, with the JPEG byte stuffing.
+class BitWriter final {
+  std::vector<uint8_t>* out;
+  uint32_t cache = 0;
+  int fill = 0;
+
+public:
+  explicit BitWriter(std::vector<uint8_t>* out_) : out(out_) {}
+
+  void put(uint32_t bits, int count) {
+    for (int i = count - 1; i >= 0; i--) {
+      cache = (cache << 1) | ((bits >> i) & 1);
+      if (++fill < 8)
+        continue;
+      out->emplace_back(cache);
+      if (cache == 0xFF)
+        out->emplace_back(0x00);
+      cache = 0;
+      fill = 0;
+    }
+  }
+
+  // Pads the last byte with ones, as the JPEG spec says.
+  void flush() {
+    while (fill != 0)
+      put(1, 1);
+  }
+};
+
+// The 9 difference lengths 0..8, all with a 4-bit code equal to the length.
+void putDifference(BitWriter* bits, int diff) {
+  int len = 0;
+  while ((std::abs(diff) >> len) != 0)
+    len++;
+  ASSERT_LE(len, 8);
+
+  bits->put(len, 4);
+  if (len != 0)
+    bits->put(diff > 0 ? diff : diff + (1 << len) - 1, len);
+}
+
+void putSegment(std::vector<uint8_t>* out, uint8_t marker,
+                const std::vector<uint8_t>& payload) {
+  out->insert(out->end(), {0xFF, marker, uint8_t((payload.size() + 2) >> 8),
+                           uint8_t(payload.size() + 2)});
+  out->insert(out->end(), payload.begin(), payload.end());
+}
+
+// A single-component lossless JPEG of the given pixels, with a restart
+// interval of rowsPerInterval rows (none if 0). restartMarker(i) gives the
+// bytes after the i'th interval, rst() gives the correct RSTn marker.
+template <typename RestartMarker>
+std::vector<uint8_t> encode(const std::vector<uint16_t>& pixels,
+                            int rowsPerInterval,
+                            const RestartMarker& restartMarker) {
+  std::vector<uint8_t> out = {0xFF, 0xD8}; // SOI
+
+  std::vector<uint8_t> dht = {0x00, 0, 0, 0, 9};
+  dht.resize(1 + 16);
+  for (uint8_t len = 0; len <= 8; len++)
+    dht.emplace_back(len);
+  putSegment(&out, 0xC4, dht);
+
+  if (rowsPerInterval != 0) {
+    const int interval = rowsPerInterval * Width;
+    putSegment(&out, 0xDD, {uint8_t(interval >> 8), uint8_t(interval)});
+  }
+
+  putSegment(&out, 0xC3,
+             {Precision, 0, Height, 0, Width, /*cps=*/1, /*id=*/1,
+              /*subsampling=*/0x11, /*Tq=*/0});
+  putSegment(&out, 0xDA,
+             {/*cps=*/1, /*id=*/1, /*table=*/0x00, /*predictor=*/1, 0, 0});
+
+  BitWriter bits(&out);
+  int interval = 0;
+  for (int row = 0; row < Height; row++) {
+    if (rowsPerInterval != 0 && row != 0 && row % rowsPerInterval == 0) {
+      bits.flush();
+      const std::vector<uint8_t> marker = restartMarker(interval++);
+      out.insert(out.end(), marker.begin(), marker.end());
+    }
+
+    for (int col = 0; col < Width; col++) {
+      // Each interval starts over with the initial predictor.
+      int pred = 1 << (Precision - 1);
+      if (col != 0)
+        pred = pixels[row * Width + col - 1];
+      else if (rowsPerInterval == 0 ? row != 0 : row % rowsPerInterval != 0)
+        pred = pixels[(row - 1) * Width];
+      putDifference(&bits, pixels[row * Width + col] - pred);
+    }
+  }
+  bits.flush();
+
+  out.insert(out.end(), {0xFF, 0xD9}); // EOI
+  return out;
+}
+
+std::vector<uint8_t> rst(int interval) {
+  return {0xFF, uint8_t(0xD0 + interval % 8)};
+}
+
+std::vector<uint16_t> genPixels() {
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  // Close to the initial predictor, so all the differences fit in 8 bits.
+  std::uniform_int_distribution<uint16_t> values(2000, 2100);
+
+  std::vector<uint16_t> pixels;
+  for (int i = 0; i < Width * Height; i++)
+    pixels.emplace_back(values(rng));
+  return pixels;
+}
+
+std::vector<uint16_t> decode(const std::vector<uint8_t>& stream) {
+  ThreadPoolExecutor executor(4);
+
+  RawImage img = RawImage::create(iPoint2D(Width, Height), TYPE_USHORT16, 1);
+  img->setExecutor(&executor);
+
+  LJpegDecompressor d(
+      ByteStream(DataBuffer(Buffer(stream.data(), stream.size()),
+                            Endianness::big)),
+      img);
+  d.decode(0, 0, Width, Height, false);
+
+  std::vector<uint16_t> pixels;
+  for (int row = 0; row < Height; row++) {
+    const auto* line =
+        reinterpret_cast<const uint16_t*>(img->getDataUncropped(0, row));
+    pixels.insert(pixels.end(), line, line + Width);
+  }
+  return pixels;
+}
+
+} // namespace
+
+TEST(LJpegDecompressorTest, NoRestartIntervalTest) {
+  const std::vector<uint16_t> pixels = genPixels();
+  ASSERT_EQ(decode(encode(pixels, 0, rst)), pixels);
+}
+
+TEST(LJpegDecompressorTest, RestartIntervalTest) {
+  const std::vector<uint16_t> pixels = genPixels();
+  for (int rowsPerInterval = 1; rowsPerInterval <= Height; rowsPerInterval++)
+    ASSERT_EQ(decode(encode(pixels, rowsPerInterval, rst)), pixels);
+}
+
+TEST(LJpegDecompressorTest, RestartMarkerAfterFillBytesTest) {
+  const std::vector<uint16_t> pixels = genPixels();
+  const auto filled = [](int interval) {
+    std::vector<uint8_t> marker = {0xFF, 0xFF};
+    for (uint8_t byte : rst(interval))
+      marker.emplace_back(byte);
+    return marker;
+  };
+  ASSERT_EQ(decode(encode(pixels, 1, filled)), pixels);
+}
+
+TEST(LJpegDecompressorTest, MissingRestartMarkerTest) {
+  const std::vector<uint16_t> pixels = genPixels();
+  const auto missing = [](int interval) {
+    return interval == 2 ? std::vector<uint8_t>() : rst(interval);
+  };
+  ASSERT_THROW(decode(encode(pixels, 1, missing)), RawDecoderException);
+}
+
+TEST(LJpegDecompressorTest, WrongRestartMarkerTest) {
+  const std::vector<uint16_t> pixels = genPixels();
+  const auto wrong = [](int interval) { return rst(interval + 1); };
+  ASSERT_THROW(decode(encode(pixels, 1, wrong)), RawDecoderException);
+}
+
+TEST(LJpegDecompressorTest, PartialRowRestartIntervalTest) {
+  const std::vector<uint16_t> pixels = genPixels();
+  std::vector<uint8_t> stream = encode(pixels, 1, rst);
+  // Patch the DRI to half a row.
+  const std::vector<uint8_t> dri = {0xFF, 0xDD, 0x00, 0x04, 0x00, Width};
+  const auto pos =
+      std::search(stream.begin(), stream.end(), dri.begin(), dri.end());
+  ASSERT_NE(pos, stream.end());
+  pos[5] = Width / 2;
+  ASSERT_THROW(decode(stream), RawDecoderException);
+}
+
+} // namespace rawspeed_test
@@ -0,0 +1,123 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "decompressors/UncompressedDecompressor.h" // for UncompressedDeco...
+#include "common/Common.h"                          // for BitOrder, BitOrd...
+#include "common/Point.h"                           // for iPoint2D
+#include "common/RawImage.h"                        // for RawImage, RawIma...
+#include "io/BitPumpLSB.h"                          // for BitPumpLSB
+#include "io/BitPumpMSB.h"                          // for BitPumpMSB
+#include "io/Buffer.h"                              // for Buffer, DataBuffer
+#include "io/ByteStream.h"                          // for ByteStream
+#include "io/Endianness.h"                          // for Endianness, Endi...
+#include <cstdint>                                  // for uint8_t, uint16_t
+#include <gtest/gtest.h>                            // for Message, TestPar...
+#include <random>                                   // for minstd_rand, uni...
+#include <tuple>                                    // for get, tuple
+#include <vector>                                   // for vector
+
+using rawspeed::BitOrder;
+using rawspeed::BitOrder_LSB;
+using rawspeed::BitOrder_MSB;
+using rawspeed::BitPumpLSB;
+using rawspeed::BitPumpMSB;
+using rawspeed::Buffer;
+using rawspeed::ByteStream;
+using rawspeed::DataBuffer;
+using rawspeed::Endianness;
+using rawspeed::iPoint2D;
+using rawspeed::RawImage;
+using rawspeed::TYPE_USHORT16;
+using rawspeed::UncompressedDecompressor;
+
+namespace rawspeed_test {
+
+// bits per pixel, bit order, width, extra bytes per row
+using UnpackType = std::tuple<int, BitOrder, int, int>;
+class UnpackTest : public ::testing::TestWithParam<UnpackType> {
+protected:
+  UnpackTest() = default;
+  virtual void SetUp() {
+    bits = std::get<0>(GetParam());
+    order = std::get<1>(GetParam());
+    width = std::get<2>(GetParam());
+    skip = std::get<3>(GetParam());
+  }
+
+  template <typename Pump>
+  std::vector<uint16_t> reference(const ByteStream& bs, int pitch) const {
+    std::vector<uint16_t> out;
+    Pump pump(bs);
+    for (int row = 0; row < height; row++) {
+      for (int col = 0; col < width; col++)
+        out.emplace_back(pump.getBits(bits));
+      pump.skipBytes(pitch - bits * width / 8);
+    }
+    return out;
+  }
+
+  static constexpr int height = 3;
+
+  int bits;
+  BitOrder order;
+  int width;
+  int skip;
+};
+
+// Only the widths for which the rows end on a byte boundary.
+INSTANTIATE_TEST_CASE_P(
+    Packed, UnpackTest,
+    ::testing::Combine(::testing::Values(10, 12, 14),
+                       ::testing::Values(BitOrder_LSB, BitOrder_MSB),
+                       ::testing::Values(4, 8, 12, 16, 20, 36),
+                       ::testing::Values(0, 1, 5)));
+
+TEST_P(UnpackTest, SameAsBitPumpTest) {
+  const int pitch = bits * width / 8 + skip;
+
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<unsigned> bytes(0, 255);
+  std::vector<uint8_t> input(pitch * height);
+  for (auto& b : input)
+    b = bytes(rng);
+
+  const Buffer b(input.data(), input.size());
+  const ByteStream bs(DataBuffer(b, Endianness::little));
+
+  const std::vector<uint16_t> expected = order == BitOrder_MSB
+                                             ? reference<BitPumpMSB>(bs, pitch)
+                                             : reference<BitPumpLSB>(bs, pitch);
+
+  const iPoint2D dim(width, height);
+  RawImage mRaw = RawImage::create(dim, TYPE_USHORT16, 1);
+  UncompressedDecompressor u(bs, mRaw);
+  u.readUncompressedRaw(dim, {0, 0}, pitch, bits, order);
+
+  for (int row = 0; row < height; row++) {
+    const auto* out =
+        reinterpret_cast<const uint16_t*>(mRaw->getDataUncropped(0, row));
+    for (int col = 0; col < width; col++) {
+      ASSERT_EQ(out[col], expected[row * width + col])
+          << "     Where row: " << row << ", col: " << col;
+    }
+  }
+}
+
+} // namespace rawspeed_test
@@ -0,0 +1,168 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "io/BatchFileReader.h" // for BatchFileReader, BatchFileReader...
+#include "io/Buffer.h"          // for Buffer
+#include "io/FileIOException.h" // for FileIOException
+#include <algorithm>            // for sort
+#include <cstdio>               // for remove
+#include <fstream>              // IWYU pragma: keep
+#include <gtest/gtest.h>        // for Message, TestPartResult, TestInfo
+#include <memory>               // for unique_ptr
+#include <mutex>                // for mutex, lock_guard
+#include <string>               // for string, to_string
+#include <thread>               // for thread
+#include <vector>               // for vector
+
+using rawspeed::BatchFileReader;
+using rawspeed::Buffer;
+using rawspeed::FileIOException;
+
+namespace rawspeed_test {
+
+namespace {
+
+// Temporary files, the i'th one contains the decimal representation of i.
+class TemporaryFiles final {
+public:
+  std::vector<std::string> names;
+
+  explicit TemporaryFiles(int count) {
+    for (int i = 0; i < count; i++) {
+      names.emplace_back(::testing::TempDir() + "BatchFileReaderTest." +
+                         std::to_string(i));
+      std::ofstream(names.back()) << i;
+    }
+  }
+
+  TemporaryFiles(const TemporaryFiles&) = delete;
+  TemporaryFiles& operator=(const TemporaryFiles&) = delete;
+
+  ~TemporaryFiles() {
+    for (const std::string& name : names)
+      std::remove(name.c_str());
+  }
+};
+
+std::string getContents(const Buffer* buffer) {
+  return std::string(reinterpret_cast<const char*>(buffer->begin()),
+                     buffer->getSize());
+}
+
+} // namespace
+
+TEST(BatchFileReaderTest, HandsOutInOrder) {
+  for (size_t readAhead : {1, 2, 5}) {
+    const TemporaryFiles files(16);
+    BatchFileReader reader(files.names, readAhead);
+
+    for (size_t i = 0; i < 16; i++) {
+      EXPECT_EQ(reader.getNumRemaining(), 16 - i);
+
+      BatchFileReader::File file;
+      ASSERT_TRUE(reader.next(&file));
+      EXPECT_EQ(file.fileName, files.names[i]);
+      EXPECT_EQ(getContents(file.get()), std::to_string(i));
+
+      const std::unique_ptr<const Buffer> buffer = file.release();
+      EXPECT_EQ(getContents(buffer.get()), std::to_string(i));
+    }
+
+    EXPECT_EQ(reader.getNumRemaining(), 0U);
+    BatchFileReader::File file;
+    EXPECT_FALSE(reader.next(&file));
+  }
+}
+
+TEST(BatchFileReaderTest, NoFiles) {
+  BatchFileReader reader(std::vector<std::string>{});
+  EXPECT_EQ(reader.getNumRemaining(), 0U);
+  BatchFileReader::File file;
+  EXPECT_FALSE(reader.next(&file));
+}
+
+TEST(BatchFileReaderTest, ReadErrorIsRethrownForThatFileOnly) {
+  const TemporaryFiles files(2);
+  const std::string missing = files.names[0] + ".missing";
+  BatchFileReader reader({files.names[0], missing, files.names[1]});
+
+  BatchFileReader::File file;
+  ASSERT_TRUE(reader.next(&file));
+  EXPECT_EQ(getContents(file.get()), "0");
+
+  ASSERT_TRUE(reader.next(&file));
+  EXPECT_EQ(file.fileName, missing);
+  EXPECT_THROW(file.get(), FileIOException);
+  EXPECT_THROW(file.release(), FileIOException);
+
+  ASSERT_TRUE(reader.next(&file));
+  EXPECT_EQ(getContents(file.get()), "1");
+
+  EXPECT_FALSE(reader.next(&file));
+}
+
+TEST(BatchFileReaderTest, EachFileIsHandedOutOnce) {
+  const TemporaryFiles files(64);
+  BatchFileReader reader(files.names, 3);
+
+  std::mutex mutex;
+  std::vector<std::string> contents;
+
+  std::vector<std::thread> consumers;
+  for (int i = 0; i < 4; i++) {
+    consumers.emplace_back([&reader, &mutex, &contents]() {
+      for (BatchFileReader::File file; reader.next(&file);) {
+        std::lock_guard<std::mutex> lock(mutex);
+        contents.emplace_back(getContents(file.get()));
+      }
+    });
+  }
+  for (std::thread& consumer : consumers)
+    consumer.join();
+
+  std::vector<std::string> expected;
+  for (int i = 0; i < 64; i++)
+    expected.emplace_back(std::to_string(i));
+
+  std::sort(contents.begin(), contents.end());
+  std::sort(expected.begin(), expected.end());
+  EXPECT_EQ(contents, expected);
+}
+
+TEST(BatchFileReaderTest, DestroyWhileReading) {
+  const TemporaryFiles files(64);
+
+  // Nothing handed out, the reader is blocked on the full queue, or reading.
+  {
+    const BatchFileReader reader(files.names, 4);
+  }
+
+  // Partially consumed.
+  for (int consumed = 1; consumed < 8; consumed++) {
+    BatchFileReader reader(files.names, 2);
+    for (int i = 0; i < consumed; i++) {
+      BatchFileReader::File file;
+      ASSERT_TRUE(reader.next(&file));
+      EXPECT_EQ(getContents(file.get()), std::to_string(i));
+    }
+  }
+}
+
+} // namespace rawspeed_test
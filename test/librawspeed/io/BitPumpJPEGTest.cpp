@@ -27,8 +27,12 @@
 #include <cstdint>          // for uint8_t, uint32_t
 #include <gtest/gtest.h>    // for Test, Message, SuiteApiResolver, TestInf...
 #include <initializer_list> // for initializer_list
+#include <vector>           // for vector
 
 using rawspeed::BitPumpJPEG;
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+using rawspeed::BitPumpJPEGWide;
+#endif
 using rawspeed::Buffer;
 using rawspeed::ByteStream;
 using rawspeed::DataBuffer;
@@ -66,6 +70,48 @@ const std::array<uint8_t, 8> Pattern<BitPumpJPEG, SaturatedTag>::Data{
 
 INSTANTIATE_TYPED_TEST_CASE_P(JPEG, BitPumpTest, Patterns<BitPumpJPEG>);
 
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+template <>
+const std::array<uint8_t, 4> Pattern<BitPumpJPEGWide, OnesTag>::Data = {
+    {/* [Byte0 Byte1 Byte2 Byte3] */
+     /* Byte: [Bit0 .. Bit7] */
+     0b10100100, 0b01000010, 0b00001000, 0b00011111}};
+template <> uint32_t Pattern<BitPumpJPEGWide, OnesTag>::data(int index) {
+  const auto set = GenOnesBE(1, 0);
+  return set[index];
+}
+
+template <>
+const std::array<uint8_t, 4> Pattern<BitPumpJPEGWide, InvOnesTag>::Data = {
+    {0b11010010, 0b00100001, 0b00000100, 0b00001111}};
+template <> uint32_t Pattern<BitPumpJPEGWide, InvOnesTag>::data(int index) {
+  const auto set = GenOnesBE(0, -1);
+  return set[index];
+}
+
+// If 0xFF0x00 byte sequence is found, it is just 0xFF, i.e. 0x00 is ignored.
+// So if we want 0xFF, we need to append 0x00 byte
+template <>
+const std::array<uint8_t, 8> Pattern<BitPumpJPEGWide, SaturatedTag>::Data{
+    {uint8_t(~0U), 0, uint8_t(~0U), 0, uint8_t(~0U), 0, uint8_t(~0U), 0}};
+
+INSTANTIATE_TYPED_TEST_CASE_P(JPEGWide, BitPumpTest,
+                              Patterns<BitPumpJPEGWide>);
+
+TEST(BitPumpJPEGTest, WideCacheTest) {
+  checkSameBits<BitPumpJPEG, BitPumpJPEGWide>();
+
+  // And with properly stuffed data, which does not end on the first FF.
+  std::vector<uint8_t> input;
+  for (unsigned i = 0; i < 1024; i++) {
+    input.emplace_back(i % 3 ? static_cast<uint8_t>(37 * i) : 0xFF);
+    if (input.back() == 0xFF)
+      input.emplace_back(0x00);
+  }
+  checkSameBits<BitPumpJPEG, BitPumpJPEGWide>(input);
+}
+#endif
+
 TEST(BitPumpJPEGTest, 0xFF0x00Is0xFFTest) {
   // If 0xFF0x00 byte sequence is found, it is just 0xFF, i.e. 0x00 is ignored.
   static const std::array<uint8_t, 2 + 4> data{
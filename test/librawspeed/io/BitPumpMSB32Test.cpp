@@ -25,6 +25,9 @@
 #include <gtest/gtest.h>     // for Types, INSTANTIATE_TYPED_TEST_CASE_P
 
 using rawspeed::BitPumpMSB32;
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+using rawspeed::BitPumpMSB32Wide;
+#endif
 
 namespace rawspeed_test {
 
@@ -51,4 +54,31 @@ template <> uint32_t Pattern<BitPumpMSB32, InvOnesTag>::data(int index) {
 
 INSTANTIATE_TYPED_TEST_CASE_P(MSB32, BitPumpTest, Patterns<BitPumpMSB32>);
 
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+template <>
+const std::array<uint8_t, 4> Pattern<BitPumpMSB32Wide, OnesTag>::Data = {
+    {/* [Byte3 Byte2 Byte1 Byte0] */
+     /* Byte: [Bit0 .. Bit7] */
+     0b00011111, 0b00001000, 0b01000010, 0b10100100}};
+template <> uint32_t Pattern<BitPumpMSB32Wide, OnesTag>::data(int index) {
+  const auto set = GenOnesBE(1, 0);
+  return set[index];
+}
+
+template <>
+const std::array<uint8_t, 4> Pattern<BitPumpMSB32Wide, InvOnesTag>::Data = {
+    {0b00001111, 0b00000100, 0b00100001, 0b11010010}};
+template <> uint32_t Pattern<BitPumpMSB32Wide, InvOnesTag>::data(int index) {
+  const auto set = GenOnesBE(0, -1);
+  return set[index];
+}
+
+INSTANTIATE_TYPED_TEST_CASE_P(MSB32Wide, BitPumpTest,
+                              Patterns<BitPumpMSB32Wide>);
+
+TEST(BitPumpMSB32Test, WideCacheTest) {
+  checkSameBits<BitPumpMSB32, BitPumpMSB32Wide>();
+}
+#endif
+
 } // namespace rawspeed_test
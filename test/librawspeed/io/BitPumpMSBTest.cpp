@@ -25,6 +25,9 @@
 #include <gtest/gtest.h>    // for Types, INSTANTIATE_TYPED_TEST_CASE_P
 
 using rawspeed::BitPumpMSB;
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+using rawspeed::BitPumpMSBWide;
+#endif
 
 namespace rawspeed_test {
 
@@ -51,4 +54,30 @@ template <> uint32_t Pattern<BitPumpMSB, InvOnesTag>::data(int index) {
 
 INSTANTIATE_TYPED_TEST_CASE_P(MSB, BitPumpTest, Patterns<BitPumpMSB>);
 
+#if defined(HAVE_BITSTREAM_WIDE_CACHE)
+template <>
+const std::array<uint8_t, 4> Pattern<BitPumpMSBWide, OnesTag>::Data = {
+    {/* [Byte0 Byte1 Byte2 Byte3] */
+     /* Byte: [Bit0 .. Bit7] */
+     0b10100100, 0b01000010, 0b00001000, 0b00011111}};
+template <> uint32_t Pattern<BitPumpMSBWide, OnesTag>::data(int index) {
+  const auto set = GenOnesBE(1, 0);
+  return set[index];
+}
+
+template <>
+const std::array<uint8_t, 4> Pattern<BitPumpMSBWide, InvOnesTag>::Data = {
+    {0b11010010, 0b00100001, 0b00000100, 0b00001111}};
+template <> uint32_t Pattern<BitPumpMSBWide, InvOnesTag>::data(int index) {
+  const auto set = GenOnesBE(0, -1);
+  return set[index];
+}
+
+INSTANTIATE_TYPED_TEST_CASE_P(MSBWide, BitPumpTest, Patterns<BitPumpMSBWide>);
+
+TEST(BitPumpMSBTest, WideCacheTest) {
+  checkSameBits<BitPumpMSB, BitPumpMSBWide>();
+}
+#endif
+
 } // namespace rawspeed_test
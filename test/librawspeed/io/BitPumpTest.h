@@ -22,7 +22,12 @@
 #include "io/Buffer.h"     // for Buffer
 #include "io/ByteStream.h" // for ByteStream
 #include "io/Endianness.h" // for getHostEndianness, Endianness::big, Endia...
+#include <algorithm>       // for copy
 #include <array>           // for array
+#include <cstdint>         // for uint8_t, uint32_t, uint64_t
+#include <random>          // for minstd_rand, uniform_int_distribution
+#include <utility>         // for move
+#include <vector>          // for vector
 #include <gtest/gtest.h>   // for Message, AssertionResult, ASSERT_PRED_FOR...
 
 using rawspeed::Buffer;
@@ -120,10 +125,7 @@ public:
   using PatternT = typename T::PatternT;
 
 protected:
-  template <typename Tag, typename TestDataType, typename L>
-  void runTest(const TestDataType& data, L gen) {
-    const Buffer b(data.data(), data.size());
-
+  template <typename Tag, typename L> void runTest(const Buffer& b, L gen) {
     for (auto e : {Endianness::little, Endianness::big}) {
       const DataBuffer db(b, e);
       const ByteStream bs(db);
@@ -132,6 +134,23 @@ protected:
       BitPumpPatternTest<T, Tag>::Test(&pump, gen);
     }
   }
+
+  template <typename Tag, typename TestDataType, typename L>
+  void runTest(const TestDataType& data, L gen) {
+    // Without any tail padding.
+    runTest<Tag>(Buffer(data.data(), data.size()), gen);
+
+    // With zero tail padding.
+    auto zeroPadded = Buffer::Create(data.size());
+    std::copy(data.begin(), data.end(), zeroPadded.get());
+    runTest<Tag>(Buffer(std::move(zeroPadded), data.size()), gen);
+
+    // With garbage in the padding, which must not be observable.
+    std::vector<uint8_t> garbage(data.size() + Buffer::TailPadding, 0xFF);
+    std::copy(data.begin(), data.end(), garbage.begin());
+    const Buffer garbagePadded(garbage.data(), garbage.size());
+    runTest<Tag>(garbagePadded.getSubView(0, data.size()), gen);
+  }
 };
 
 TYPED_TEST_CASE_P(BitPumpTest);
@@ -235,6 +254,39 @@ auto GenOnesBE = [](int zerosToOutput,
   return v;
 };
 
+// The BitStreams that only differ in the cache must return the same bits.
+template <typename Pump, typename WidePump>
+void checkSameBits(const std::vector<uint8_t>& input) {
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<uint32_t> lens(1, 31);
+
+  const Buffer b(input.data(), input.size());
+  for (auto e : {Endianness::little, Endianness::big}) {
+    const DataBuffer db(b, e);
+    const ByteStream bs(db);
+
+    Pump pump(bs);
+    WidePump widePump(bs);
+    // NOTE: with byte stuffing, not all the input bytes are data bytes.
+    for (uint64_t bits = 0; bits < 4 * input.size();) {
+      const uint32_t len = lens(rng);
+      ASSERT_EQ(pump.getBits(len), widePump.getBits(len))
+          << "     Where bits: " << bits;
+      bits += len;
+    }
+  }
+}
+
+template <typename Pump, typename WidePump> void checkSameBits() {
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<unsigned> bytes(0, 255);
+
+  std::vector<uint8_t> input(1024);
+  for (auto& byte : input)
+    byte = bytes(rng);
+  checkSameBits<Pump, WidePump>(input);
+}
+
 template <typename Pump, typename Pattern> struct PumpAndPattern {
   using PumpT = Pump;
   using PatternT = Pattern;
@@ -24,6 +24,7 @@
 #include <gtest/gtest.h>   // for ParamIteratorInterface, Message, TestPart...
 #include <iomanip>         // for setfill, setw, _Setw, _Setfill
 #include <iostream>        // for hex, endl, ostream
+#include <vector>          // for vector
 
 using rawspeed::Endianness;
 using rawspeed::getBE;
@@ -35,6 +36,8 @@ using rawspeed::getU16BE;
 using rawspeed::getU16LE;
 using rawspeed::getU32BE;
 using rawspeed::getU32LE;
+using rawspeed::swapRow16;
+using rawspeed::swapRow32;
 using std::setfill;
 using std::setw;
 
@@ -365,4 +368,30 @@ TEST_P(doubleTest, getNOP) {
   }
 }
 
+template <typename T>
+static void checkSwapRow(void (*swapRow)(T*, const void*, size_t)) {
+  // All the lengths around the vector width, and an unaligned source.
+  for (size_t count = 0; count < 40; count++) {
+    for (size_t offset = 0; offset < 2; offset++) {
+      std::vector<uint8_t> in(offset + sizeof(T) * count);
+      for (size_t i = 0; i < in.size(); i++)
+        in[i] = static_cast<uint8_t>(17 * i + 1);
+      std::vector<T> out(count);
+
+      swapRow(out.data(), in.data() + offset, count);
+
+      for (size_t i = 0; i < count; i++) {
+        ASSERT_EQ(out[i],
+                  getByteSwapped<T>(in.data() + offset + sizeof(T) * i, true))
+            << "     Where count: " << count << ", offset: " << offset
+            << ", i: " << i;
+      }
+    }
+  }
+}
+
+TEST(EndiannessTest, swapRow16Test) { checkSwapRow<uint16_t>(&swapRow16); }
+
+TEST(EndiannessTest, swapRow32Test) { checkSwapRow<uint32_t>(&swapRow32); }
+
 } // namespace rawspeed_test
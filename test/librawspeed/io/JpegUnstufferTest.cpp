@@ -0,0 +1,162 @@
+/*
+    RawSpeed - RAW file decoder.
+
+    Copyright (C) 2026 RawSpeed developers
+
+    This library is free software; you can redistribute it and/or
+    modify it under the terms of the GNU Lesser General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+
+    This library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+    Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public
+    License along with this library; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "io/JpegUnstuffer.h"        // for JpegUnstuffer
+#include "io/BitPumpJPEG.h"          // for BitPumpJPEG
+#include "io/BitPumpJPEGUnstuffed.h" // for BitPumpJPEGUnstuffed
+#include "io/Buffer.h"               // for Buffer, DataBuffer
+#include "io/ByteStream.h"           // for ByteStream
+#include "io/Endianness.h"           // for Endianness, Endianness::big
+#include <cstdint>                   // for uint8_t
+#include <gtest/gtest.h>             // for Message, TestPartResult, TestInfo
+#include <random>                    // for minstd_rand, uniform_int_distribu...
+#include <tuple>                     // for get, tuple
+#include <vector>                    // for vector
+
+using rawspeed::BitPumpJPEG;
+using rawspeed::BitPumpJPEGUnstuffed;
+using rawspeed::Buffer;
+using rawspeed::ByteStream;
+using rawspeed::DataBuffer;
+using rawspeed::Endianness;
+using rawspeed::JpegUnstuffer;
+
+namespace rawspeed_test {
+
+// input, expected data bytes, expected marker position, is copy expected?
+using UnstufferType =
+    std::tuple<std::vector<uint8_t>, std::vector<uint8_t>,
+               Buffer::size_type, bool>;
+class JpegUnstufferTest : public ::testing::TestWithParam<UnstufferType> {};
+
+static const UnstufferType UnstufferValues[] = {
+    // clang-format off
+    UnstufferType({0x12, 0x34}, {0x12, 0x34}, 2, false),
+    UnstufferType({0x12, 0xFF, 0xD9, 0x34}, {0x12}, 1, false),
+    UnstufferType({0xFF, 0xD9}, {}, 0, false),
+    UnstufferType({0xFF, 0xFF, 0x00}, {}, 0, false),
+    UnstufferType({0xFF, 0x00}, {0xFF}, 2, true),
+    UnstufferType({0x12, 0xFF, 0x00, 0x34}, {0x12, 0xFF, 0x34}, 4, true),
+    UnstufferType({0xFF, 0x00, 0xFF, 0x00, 0xFF, 0xD9, 0x56},
+                  {0xFF, 0xFF}, 4, true),
+    UnstufferType({0xFF, 0x00, 0x12, 0xFF, 0x00, 0xFF, 0xC4},
+                  {0xFF, 0x12, 0xFF}, 5, true),
+    // past-the-end is read as zero, so the trailing 0xFF is not a marker.
+    UnstufferType({0x12, 0xFF}, {0x12, 0xFF}, 2, true),
+    // clang-format on
+};
+
+INSTANTIATE_TEST_CASE_P(Basic, JpegUnstufferTest,
+                        ::testing::ValuesIn(UnstufferValues));
+
+TEST_P(JpegUnstufferTest, UnstuffTest) {
+  const auto& input = std::get<0>(GetParam());
+  const auto& expected = std::get<1>(GetParam());
+
+  const Buffer b(input.data(), input.size());
+  const DataBuffer db(b, Endianness::big);
+  const ByteStream bs(db);
+
+  const JpegUnstuffer u(bs);
+
+  ASSERT_EQ(u.getMarkerPosition(), std::get<2>(GetParam()));
+  ASSERT_EQ(u.isCopy(), std::get<3>(GetParam()));
+
+  const ByteStream& s = u.getStream();
+  ASSERT_EQ(s.getSize(), expected.size());
+  for (unsigned i = 0; i < expected.size(); i++)
+    ASSERT_EQ(s.peekByte(i), expected[i]) << "     Where i: " << i;
+
+  if (!u.isCopy()) {
+    ASSERT_EQ(s.begin(), input.data());
+  }
+}
+
+TEST_P(JpegUnstufferTest, FindMarkerTest) {
+  const auto& input = std::get<0>(GetParam());
+
+  const Buffer b(input.data(), input.size());
+  const DataBuffer db(b, Endianness::big);
+  const ByteStream bs(db);
+
+  ASSERT_EQ(JpegUnstuffer::findMarker(bs), std::get<2>(GetParam()));
+}
+
+// The BitPumpJPEGUnstuffed over the unstuffed data must return exactly the
+// same bits as BitPumpJPEG over the original data.
+TEST(JpegUnstufferTest, SameBitsAsBitPumpJPEGTest) {
+  std::minstd_rand rng; // NOLINT do not need crypto-level randomness
+  std::uniform_int_distribution<unsigned> bytes(0, 255);
+  std::uniform_int_distribution<unsigned> lens(1, 31);
+
+  for (int stuffed = 1; stuffed <= 16; stuffed++) {
+    std::vector<uint8_t> input;
+    for (unsigned i = 0; i < 4096; i++) {
+      // Lots of 0xFF bytes, that need to be stuffed.
+      input.emplace_back(i % stuffed ? bytes(rng) : 0xFF);
+      if (input.back() == 0xFF)
+        input.emplace_back(0x00);
+    }
+    // And the marker at the end.
+    input.emplace_back(0xFF);
+    input.emplace_back(0xD9);
+
+    const Buffer b(input.data(), input.size());
+    const DataBuffer db(b, Endianness::big);
+    const ByteStream bs(db);
+
+    const JpegUnstuffer u(bs);
+    ASSERT_EQ(u.getMarkerPosition(), input.size() - 2);
+
+    BitPumpJPEG jpeg(bs);
+    BitPumpJPEGUnstuffed unstuffed(u.getStream());
+
+    // Also read a bit past the end of the data.
+    for (uint64_t bits = 0; bits < 8 * (u.getStream().getSize() + 4);) {
+      const unsigned len = lens(rng);
+      ASSERT_EQ(jpeg.getBits(len), unstuffed.getBits(len))
+          << "     Where bits: " << bits;
+      bits += len;
+    }
+  }
+}
+
+// However far past the marker, the segment reads as zeros,
+// and the bit position keeps counting them.
+TEST(JpegUnstufferTest, ZerosPastTheMarkerTest) {
+  // Both with and without stuffed bytes.
+  for (const std::vector<uint8_t>& input :
+       {std::vector<uint8_t>{0x12, 0x34, 0xFF, 0xD9, 0x56, 0x78},
+        std::vector<uint8_t>{0xFF, 0x00, 0x34, 0xFF, 0xD9, 0x56, 0x78}}) {
+    const Buffer b(input.data(), input.size());
+    const DataBuffer db(b, Endianness::big);
+    const ByteStream bs(db);
+
+    const JpegUnstuffer u(bs);
+    BitPumpJPEGUnstuffed pump(u.getStream());
+    pump.getBits(16);
+    for (int i = 0; i < 1024; i++) {
+      ASSERT_EQ(pump.getBits(31), 0U) << "     Where i: " << i;
+      ASSERT_EQ(pump.getBitPosition(), 16 + 31 * uint64_t(i + 1));
+    }
+  }
+}
+
+} // namespace rawspeed_test